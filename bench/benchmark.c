@@ -0,0 +1,202 @@
+/**
+ * Micro-benchmarks of the hot paths, run under simavr by tools/benchmark.py
+ *
+ * Built by the bench env with the stubbed I2C bus (I2C_STUB): the bus takes no time, so the cycles
+ * are the CPU work of the drivers only, the bus time is bytes * 22.5 us at 400 kHz.
+ * Timer1 counts CPU cycles, the cost of the empty benchmark (loop and call) is subtracted.
+ * Every benchmark sends "BENCH <name> <iterations> <cycles per operation> <bus bytes per operation>",
+ * the last line is "BENCH END", then the CPU sleeps with interrupts disabled and simavr exits.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "i2c.h"
+#include "i2c_stub.h"
+#include "ssd1306.h"
+#include "bmp180.h"
+#include "numeric_font.h"
+#include "thermometer_bitmap.h"
+#include "uart.h"
+
+#define BENCH_ITERATIONS 16
+#define BENCH_LINE_LENGTH UART_TX_BUFFER_SIZE
+#define BENCH_NAME_LENGTH 32
+#define UART_BAUD_RATE 115200
+#define SSD1306_I2C_ADDRESS 0x3C
+#define BMP180_I2C_ADDRESS 0x77
+#define TEXT_LENGTH 7
+#define TEXT_PAGE 1
+#define TEXT_COLUMN 45
+#define BMP180_UT 27898 // Example of the datasheet: 15.0 C
+#define BMP180_UP 23843 // Example of the datasheet: 69964 Pa in ultra low power mode
+
+typedef void (*bench_function_t)(void);
+
+// Calibration of the datasheet example as read from the EEPROM of BMP180 (AC1...MD, big-endian)
+static const uint8_t bmp180_calibration[] = {
+    0x01, 0x98, 0xFF, 0xB8, 0xC7, 0xD1, 0x7F, 0xE5, 0x7F, 0xF5, 0x5A, 0x71,
+    0x18, 0x2E, 0x00, 0x04, 0x80, 0x00, 0xDD, 0xF9, 0x0B, 0x34,
+};
+
+static volatile uint16_t bench_overflows;
+static uint32_t bench_overhead; // Cycles of the empty benchmark
+static ssd1306_t* display;
+static ssd1306_t* framebuffer_display;
+static ssd1306_framebuffer_t framebuffer;
+static ssd1306_text_field_t text_field;
+static bmp180_t* bmp180;
+static uint8_t bench_iteration; // Alternates the text, unchanged text is not sent again
+static volatile int32_t bench_result; // Keeps the results from being optimized out
+static char bench_text[TEXT_LENGTH + 1];
+
+ISR(TIMER1_OVF_vect) {
+  bench_overflows++;
+}
+
+static void bench_timer_start(void) {
+  bench_overflows = 0;
+  TCNT1 = 0;
+  TIFR1 = _BV(TOV1);
+  TCCR1B = _BV(CS10); // F_CPU / 1
+}
+
+static uint32_t bench_timer_stop(void) {
+  TCCR1B = 0;
+  uint32_t cycles;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    cycles = (uint32_t)bench_overflows << 16 | TCNT1;
+    if (bit_is_set(TIFR1, TOV1)) {
+      cycles += 0x10000; // Overflow at the stop, its interrupt is not handled yet
+    }
+  }
+  return cycles;
+}
+
+// Not inlined: the call through the pointer must stay the same for the empty benchmark
+static __attribute__((noinline)) uint32_t bench_measure(bench_function_t function) {
+  uart_flush(); // UART interrupts would be counted
+  i2c_stub_reset_bytes();
+  bench_timer_start();
+  for (uint8_t i = 0; i < BENCH_ITERATIONS; i++) {
+    function();
+  }
+  return bench_timer_stop();
+}
+
+static void bench_send(const char* line) {
+  while (!uart_print(line)) {}
+}
+
+static void bench_run(PGM_P name, bench_function_t function) {
+  const uint32_t cycles = bench_measure(function);
+  const uint32_t bytes = i2c_stub_get_bytes();
+  char text[BENCH_NAME_LENGTH];
+  char line[BENCH_LINE_LENGTH];
+  strcpy_P(text, name);
+  snprintf_P(line, sizeof(line), PSTR("BENCH %s %u %lu %lu\r\n"), text, BENCH_ITERATIONS,
+    (unsigned long)((cycles - bench_overhead) / BENCH_ITERATIONS), (unsigned long)(bytes / BENCH_ITERATIONS));
+  bench_send(line);
+}
+
+static void bench_empty(void) {}
+
+static const char* bench_next_text(void) {
+  return bench_iteration++ % 2 ? "+21.4*<" : "+21.5*>";
+}
+
+static void bench_clear_display(void) {
+  ssd1306_clear_display(display);
+}
+
+// Same bytes as the paged bitmap, read as rows
+static void bench_draw_bitmap(void) {
+  ssd1306_draw_bitmap(display, 0, 0, THERMOMETER_BITMAP_WIDTH, THERMOMETER_BITMAP_HEIGHT, thermometer_bitmap);
+}
+
+static void bench_draw_paged_bitmap(void) {
+  ssd1306_draw_paged_bitmap(display, 0, 0, THERMOMETER_BITMAP_WIDTH, THERMOMETER_BITMAP_HEIGHT, thermometer_bitmap);
+}
+
+static void bench_print(void) {
+  ssd1306_print(display, "+21.4*<", TEXT_PAGE, TEXT_COLUMN);
+}
+
+static void bench_update_text_field(void) {
+  ssd1306_update_text_field(display, &text_field, bench_next_text());
+}
+
+static void bench_print_framebuffer(void) {
+  ssd1306_print(framebuffer_display, bench_next_text(), TEXT_PAGE, TEXT_COLUMN);
+  ssd1306_flush(framebuffer_display);
+}
+
+static void bench_compensate_temperature(void) {
+  bench_result = bmp180_compensate_temperature(bmp180, BMP180_UT);
+}
+
+static void bench_compensate_pressure(void) {
+  bench_result = bmp180_compensate_pressure(bmp180, BMP180_UP);
+}
+
+// Formats of update_display() in src/main.c
+static void bench_format_temperature(void) {
+  const int16_t temp = bench_result % 1000;
+  sprintf_P(bench_text, PSTR("%c%d.%d*%c"), temp > 0 ? '+' : '-', abs(temp / 10), abs(temp % 10), '<');
+}
+
+static void bench_format_pressure(void) {
+  sprintf_P(bench_text, PSTR(" %dh%c"), (int16_t)(bench_result % 1000), '>');
+}
+
+int main(void) {
+  uart_init(UART_BAUD_RATE);
+  TIMSK1 = _BV(TOIE1);
+  sei();
+  bench_send("BENCH START\r\n");
+
+  ssd1306_config_t ssd1306_cfg = ssd1306_create_config(SSD1306_I2C_ADDRESS);
+  ssd1306_t ssd1306 = ssd1306_create(&ssd1306_cfg);
+  ssd1306_set_font(&ssd1306, &numeric_font);
+  ssd1306_init(&ssd1306, &ssd1306_cfg);
+  display = &ssd1306;
+  text_field = ssd1306_create_text_field(TEXT_PAGE, TEXT_COLUMN, TEXT_LENGTH);
+
+  ssd1306_t ssd1306_framebuffer = ssd1306;
+  ssd1306_set_framebuffer(&ssd1306_framebuffer, &framebuffer);
+  framebuffer_display = &ssd1306_framebuffer;
+
+  i2c_stub_set_read_data(bmp180_calibration, sizeof(bmp180_calibration));
+  bmp180_t bmp180_sensor = bmp180_create(BMP180_I2C_ADDRESS);
+  bmp180_init(&bmp180_sensor);
+  bmp180_set_mode(&bmp180_sensor, BMP180_ULTRA_LOW_POWER_MODE);
+  bmp180 = &bmp180_sensor;
+  bench_result = bmp180_compensate_temperature(bmp180, BMP180_UT); // B5 for the pressure
+
+  bench_overhead = bench_measure(bench_empty);
+  bench_run(PSTR("ssd1306_clear_display"), bench_clear_display);
+  bench_run(PSTR("ssd1306_draw_bitmap"), bench_draw_bitmap);
+  bench_run(PSTR("ssd1306_draw_paged_bitmap"), bench_draw_paged_bitmap);
+  bench_run(PSTR("ssd1306_print"), bench_print);
+  bench_run(PSTR("ssd1306_update_text_field"), bench_update_text_field);
+  bench_run(PSTR("ssd1306_print_framebuffer"), bench_print_framebuffer);
+  bench_run(PSTR("bmp180_compensate_temperature"), bench_compensate_temperature);
+  bench_run(PSTR("bmp180_compensate_pressure"), bench_compensate_pressure);
+  bench_run(PSTR("sprintf_temperature"), bench_format_temperature);
+  bench_run(PSTR("sprintf_pressure"), bench_format_pressure);
+
+  bench_send("BENCH END\r\n");
+  uart_flush();
+  cli();
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  sleep_cpu(); // simavr exits when the CPU sleeps with interrupts disabled
+  while (1) {}
+}
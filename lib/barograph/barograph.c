@@ -0,0 +1,121 @@
+/**
+ * Barograph: scrolling history chart for SSD1306 OLED Display
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "ssd1306.h"
+#include "barograph.h"
+
+#define BAROGRAPH_MAX_PAGES (SSD1306_PAGE_END_ADDRESS - SSD1306_PAGE_START_ADDRESS + 1)
+#define BAROGRAPH_REDRAW_COLUMNS 16 // Columns per transaction of the redraw
+
+barograph_t barograph_create(uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column, int32_t min, int32_t max) {
+    const barograph_t barograph = {
+        .start_page = start_page,
+        .end_page = end_page,
+        .start_column = start_column,
+        .end_column = end_column,
+        .min = min,
+        .max = max,
+        .history = NULL,
+    };
+    return barograph;
+}
+
+/**
+ * Set history for displays without content scroll
+ * The chart is redrawn from it when the display can't scroll (built without SSD1306_CONTENT_SCROLL).
+ * @param barograph
+ * @param history BAROGRAPH_WIDTH() bytes, must stay valid
+*/
+void barograph_set_history(barograph_t* barograph, uint8_t* history) {
+    barograph->history = history;
+    if (history != NULL) {
+        memset(history, 0, BAROGRAPH_WIDTH(barograph));
+    }
+}
+
+bool barograph_clear(const ssd1306_t* ssd1306, const barograph_t* barograph) {
+    if (barograph->history != NULL) {
+        memset(barograph->history, 0, BAROGRAPH_WIDTH(barograph));
+    }
+    return ssd1306_clear_rect(ssd1306, barograph->start_page, barograph->end_page, barograph->start_column, barograph->end_column);
+}
+
+/**
+ * Height of the bar in pixels (0 - height of the chart)
+*/
+static uint8_t barograph_bar_height(const barograph_t* barograph, int32_t value) {
+    const uint8_t height = (barograph->end_page - barograph->start_page + 1) * SSD1306_BITS_PER_COLUMN;
+    if (value <= barograph->min || barograph->max <= barograph->min) {
+        return 0;
+    }
+    if (value >= barograph->max) {
+        return height;
+    }
+    return (uint8_t)((value - barograph->min) * height / (barograph->max - barograph->min));
+}
+
+// Byte of the bar in the page (bit 0 is the top pixel), the bar grows from the bottom of the chart
+static uint8_t barograph_bar_byte(uint8_t pages, uint8_t page, uint8_t bar_height) {
+    const uint8_t top = pages * SSD1306_BITS_PER_COLUMN - bar_height;
+    const uint8_t page_top = page * SSD1306_BITS_PER_COLUMN;
+    if (top <= page_top) {
+        return 0xFF;
+    }
+    if (top >= page_top + SSD1306_BITS_PER_COLUMN) {
+        return 0x00;
+    }
+    return (uint8_t)(0xFF << (top - page_top));
+}
+
+// Whole chart from the history, a few columns per transaction
+static bool barograph_redraw(const ssd1306_t* ssd1306, const barograph_t* barograph, uint8_t pages) {
+    const uint8_t width = BAROGRAPH_WIDTH(barograph);
+    uint8_t columns[BAROGRAPH_REDRAW_COLUMNS];
+    bool is_ok = true;
+    for (uint8_t page = 0; page < pages; page++) {
+        for (uint8_t column = 0; is_ok && column < width; column += BAROGRAPH_REDRAW_COLUMNS) {
+            const uint8_t count = width - column < BAROGRAPH_REDRAW_COLUMNS ? width - column : BAROGRAPH_REDRAW_COLUMNS;
+            for (uint8_t i = 0; i < count; i++) {
+                columns[i] = barograph_bar_byte(pages, page, barograph->history[column + i]);
+            }
+            is_ok = ssd1306_draw_buffer(ssd1306, barograph->start_page + page, barograph->start_column + column, count, SSD1306_BITS_PER_COLUMN, columns);
+        }
+    }
+    return is_ok;
+}
+
+/**
+ * Add value
+ * The framebuffer copy of the chart area is scrolled to the left, in direct mode the chart is
+ * redrawn from the history (nothing is drawn without it). Built with SSD1306_CONTENT_SCROLL the area
+ * is scrolled by the display controller (one content scroll command) and only the new column is sent.
+ * @param ssd1306
+ * @param barograph
+ * @param value
+*/
+bool barograph_add(const ssd1306_t* ssd1306, const barograph_t* barograph, int32_t value) {
+    const uint8_t pages = barograph->end_page - barograph->start_page + 1;
+    if (pages > BAROGRAPH_MAX_PAGES) {
+        return false;
+    }
+    const uint8_t bar_height = barograph_bar_height(barograph, value);
+    if (barograph->history != NULL) {
+        memmove(barograph->history, barograph->history + 1, BAROGRAPH_WIDTH(barograph) - 1);
+        barograph->history[BAROGRAPH_WIDTH(barograph) - 1] = bar_height;
+    }
+
+    if (!ssd1306_scroll_content(ssd1306, SSD1306_SCROLL_LEFT, barograph->start_page, barograph->end_page, barograph->start_column, barograph->end_column)) {
+        return barograph->history != NULL && barograph_redraw(ssd1306, barograph, pages);
+    }
+    uint8_t column[BAROGRAPH_MAX_PAGES];
+    for (uint8_t page = 0; page < pages; page++) {
+        column[page] = barograph_bar_byte(pages, page, bar_height);
+    }
+    return ssd1306_draw_buffer(ssd1306, barograph->start_page, barograph->end_column, 1, pages * SSD1306_BITS_PER_COLUMN, column);
+}
@@ -0,0 +1,36 @@
+/**
+ * Barograph: scrolling history chart for SSD1306 OLED Display
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef BAROGRAPH_H
+#define BAROGRAPH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306_def.h"
+
+#define BAROGRAPH_WIDTH(barograph) ((barograph)->end_column - (barograph)->start_column + 1) // Columns, size of the history
+
+// Chart area of the display. The history is kept in the display RAM,
+// so the value range is fixed: old columns can not be rescaled.
+// The original SSD1306 can't scroll the chart: it is redrawn from the framebuffer or, in direct mode,
+// from the history set by barograph_set_history(). Built with SSD1306_CONTENT_SCROLL the chart is scrolled
+// by the content scroll command (0x2C/0x2D) of SSD1306B, SSD1309 and SSD1315.
+typedef struct {
+    uint8_t start_page;
+    uint8_t end_page;
+    uint8_t start_column;
+    uint8_t end_column;
+    int32_t min; // Value at the bottom of the chart
+    int32_t max; // Value at the top of the chart
+    uint8_t* history; // Bar heights of the columns for redrawing (NULL = the display scrolls)
+} barograph_t;
+
+barograph_t barograph_create(uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column, int32_t min, int32_t max);
+void barograph_set_history(barograph_t* barograph, uint8_t* history);
+bool barograph_clear(const ssd1306_t* ssd1306, const barograph_t* barograph);
+bool barograph_add(const ssd1306_t* ssd1306, const barograph_t* barograph, int32_t value);
+
+#endif // BAROGRAPH_H
@@ -3,9 +3,10 @@
 #include <stdint.h>
 #include <avr/pgmspace.h>
 
+// Generated by tools/bitmap_converter.py (page-native format)
 #define THERMOMETER_BITMAP_WIDTH 24
 #define THERMOMETER_BITMAP_HEIGHT 24
 
-const uint8_t PROGMEM thermometer_bitmap[] = { 0x0, 0x3c, 0x0, 0x0, 0x7e, 0x0, 0x0, 0xc3, 0x0, 0x0, 0xc3, 0x0, 0x0, 0xc3, 0x0, 0x0, 0xc3, 0x0, 0x0, 0xc3, 0x0, 0x0, 0xc3, 0x0, 0x0, 0xc3, 0x0, 0x0, 0xdb, 0x0, 0x0, 0xdb, 0x0, 0x0, 0xdb, 0x0, 0x0, 0xdb, 0x0, 0x0, 0xdb, 0x0, 0x0, 0xdb, 0x0, 0x0, 0xdb, 0x0, 0x80, 0x99, 0x1, 0x80, 0xbd, 0x1, 0x80, 0x3c, 0x1, 0x80, 0x3c, 0x1, 0x80, 0x99, 0x1, 0x80, 0xc3, 0x1, 0x0, 0xff, 0x0, 0x0, 0x3c, 0x0 };
+const uint8_t PROGMEM thermometer_bitmap[] = { 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0xfc, 0xfe, 0x3, 0x3, 0x3, 0x3, 0xfe, 0xfc, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0xff, 0xff, 0x0, 0xfe, 0xfe, 0x0, 0xff, 0xff, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x3f, 0x73, 0x60, 0xce, 0xdf, 0xdf, 0xce, 0x60, 0x73, 0x3f, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 };
 
-#endif // THERMOMETER_BITMAP_H
+#endif // THERMOMETER_BITMAP_H
\ No newline at end of file
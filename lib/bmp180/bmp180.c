@@ -6,58 +6,73 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <util/delay.h>
+#include <avr/sfr_defs.h>
 #include "i2c.h"
 #include "bmp180_def.h"
+#include "units.h"
 
-static bool i2c_read_uin16(uint8_t i2c_address, uint8_t reg, uint16_t* result) {
+static bool bmp180_read_registers(uint8_t i2c_address, uint8_t reg, uint8_t* data, uint8_t length) {
     bool is_ok;
-    uint8_t msb = 0;
-    uint8_t lsb = 0;
+    i2c_profile_set_caller(I2C_CALLER_BMP180);
     is_ok = i2c_start(i2c_address, I2C_MODE_WRITE);
     is_ok = is_ok && i2c_write_byte(reg);
     is_ok = is_ok && i2c_start(i2c_address, I2C_MODE_READ);
-    is_ok = is_ok && i2c_read_byte_ACK(&msb);
-    is_ok = is_ok && i2c_read_byte_NACK(&lsb);
-    if (is_ok) {
-        *result = (uint16_t)(msb << 8 | lsb);
-    }
+    is_ok = is_ok && i2c_read_buffer(data, length);
     i2c_stop();
     return is_ok;
 }
 
-static bool i2c_read_in16(uint8_t i2c_address, uint8_t reg, int16_t* result) {
-    uint16_t value;
-    bool is_ok = i2c_read_uin16(i2c_address, reg, &value);
-    if (is_ok) {
-        *result = (int16_t)value;
-    }
+static bool bmp180_write_register(uint8_t i2c_address, uint8_t reg, uint8_t value) {
+    const uint8_t data[] = { reg, value };
+    bool is_ok;
+    i2c_profile_set_caller(I2C_CALLER_BMP180);
+    is_ok = i2c_start(i2c_address, I2C_MODE_WRITE);
+    is_ok = is_ok && i2c_write_buffer(data, sizeof(data));
+    i2c_stop();
     return is_ok;
 }
 
+static uint16_t bmp180_get_word(const uint8_t* data, uint8_t index) {
+    return (uint16_t)data[index * 2] << 8 | data[index * 2 + 1];
+}
+
 bmp180_t bmp180_create(uint8_t i2c_address) {
     const bmp180_t bmp180 = {
         .i2c_address = i2c_address,
         .mode = BMP180_STANDARD_MODE,
+        .conversion = BMP180_CONVERSION_NONE,
+        .is_B5_valid = false,
         .data = {},
     };
     return bmp180;
 }
 
+/**
+ * Read calibration data
+ * The whole calibration EEPROM (0xAA-0xBF) is read in one sequential transaction.
+*/
 bool bmp180_init(bmp180_t* bmp180) {
-    bool is_ok = true;
-    is_ok = is_ok && i2c_read_in16(bmp180->i2c_address, BMP180_EPROM_AC1, &bmp180->data.AC1);
-    is_ok = is_ok && i2c_read_in16(bmp180->i2c_address, BMP180_EPROM_AC2, &bmp180->data.AC2);
-    is_ok = is_ok && i2c_read_in16(bmp180->i2c_address, BMP180_EPROM_AC3, &bmp180->data.AC3);
-    is_ok = is_ok && i2c_read_uin16(bmp180->i2c_address, BMP180_EPROM_AC4, &bmp180->data.AC4);
-    is_ok = is_ok && i2c_read_uin16(bmp180->i2c_address, BMP180_EPROM_AC5, &bmp180->data.AC5);
-    is_ok = is_ok && i2c_read_uin16(bmp180->i2c_address, BMP180_EPROM_AC6, &bmp180->data.AC6);
-    is_ok = is_ok && i2c_read_in16(bmp180->i2c_address, BMP180_EPROM_B1, &bmp180->data.B1);
-    is_ok = is_ok && i2c_read_in16(bmp180->i2c_address, BMP180_EPROM_B2, &bmp180->data.B2);
-    is_ok = is_ok && i2c_read_in16(bmp180->i2c_address, BMP180_EPROM_MB, &bmp180->data.MB);
-    is_ok = is_ok && i2c_read_in16(bmp180->i2c_address, BMP180_EPROM_MC, &bmp180->data.MC);
-    is_ok = is_ok && i2c_read_in16(bmp180->i2c_address, BMP180_EPROM_MD, &bmp180->data.MD);
+    uint8_t eprom[BMP180_EPROM_SIZE];
+    const bool is_ok = bmp180_read_registers(bmp180->i2c_address, BMP180_EPROM_AC1, eprom, sizeof(eprom));
+    if (is_ok) {
+        bmp180_calibration_data_t *data = &bmp180->data;
+        data->AC1 = (int16_t)bmp180_get_word(eprom, 0);
+        data->AC2 = (int16_t)bmp180_get_word(eprom, 1);
+        data->AC3 = (int16_t)bmp180_get_word(eprom, 2);
+        data->AC4 = bmp180_get_word(eprom, 3);
+        data->AC5 = bmp180_get_word(eprom, 4);
+        data->AC6 = bmp180_get_word(eprom, 5);
+        data->B1 = (int16_t)bmp180_get_word(eprom, 6);
+        data->B2 = (int16_t)bmp180_get_word(eprom, 7);
+        data->MB = (int16_t)bmp180_get_word(eprom, 8);
+        data->MC = (int16_t)bmp180_get_word(eprom, 9);
+        data->MD = (int16_t)bmp180_get_word(eprom, 10);
+        bmp180->MC_2_11 = (int32_t)bmp180->data.MC << 11;
+        bmp180->AC1_4 = (int32_t)bmp180->data.AC1 * 4;
+    }
     return is_ok;
 }
 
@@ -65,12 +80,213 @@ void bmp180_set_mode(bmp180_t* bmp180, bmp180_mode_t mode) {
     bmp180->mode = mode;
 }
 
+/**
+ * Reuse temperature compensation (B5) for several pressure reads
+ * bmp180_get_pressure() measures temperature only when B5 is stale:
+ * it is older than max_age or the temperature may have drifted by max_drift,
+ * estimated from the change between the last two measurements.
+ * @param bmp180
+ * @param max_age Time between temperature measurements in ms (0 = off, temperature is measured by the caller)
+ * @param max_drift Allowed temperature drift in 0.1 C (0 = no drift bound)
+ * @param clock Time in ms, e.g. scheduler_get_time()
+*/
+void bmp180_set_temperature_cache(bmp180_t* bmp180, uint32_t max_age, uint8_t max_drift, bmp180_clock_t clock) {
+    bmp180->B5_max_age = max_age;
+    bmp180->max_drift = max_drift;
+    bmp180->clock = clock;
+}
+
+/**
+ * Check whether temperature must be measured before the next pressure read
+ * Always false when the cache is off.
+*/
+bool bmp180_is_temperature_stale(const bmp180_t* bmp180) {
+    if (bmp180->B5_max_age == 0) {
+        return false;
+    }
+    if (!bmp180->is_B5_valid) {
+        return true;
+    }
+    const uint32_t age = bmp180->clock() - bmp180->B5_time;
+    if (age >= bmp180->B5_max_age) {
+        return true;
+    }
+    // drift_rate * age >= max_drift without 32-bit overflow
+    return bmp180->max_drift > 0 && bmp180->drift_rate > 0 && age >= bmp180->max_drift * BMP180_DRIFT_SCALE / bmp180->drift_rate;
+}
+
+static void bmp180_update_temperature_cache(bmp180_t* bmp180, int32_t temp) {
+    const uint32_t time = bmp180->B5_max_age != 0 ? bmp180->clock() : 0;
+    const uint32_t age = time - bmp180->B5_time;
+    if (bmp180->is_B5_valid && age > 0) {
+        const uint32_t drift_rate = labs(temp - bmp180->temperature) * BMP180_DRIFT_SCALE / age;
+        bmp180->drift_rate = drift_rate > UINT16_MAX ? UINT16_MAX : drift_rate;
+    }
+    bmp180->temperature = temp;
+    bmp180->B5_time = time;
+    bmp180->is_B5_valid = true;
+}
+
+/**
+ * Compensate temperature (integer arithmetic of the datasheet)
+ * Updates B5, which is needed to compensate pressure.
+ * @param bmp180
+ * @param ut Uncompensated temperature
+ * @return Temperature in 0.1 C
+*/
+int32_t bmp180_compensate_temperature(bmp180_t *bmp180, int32_t ut) {
+    const bmp180_calibration_data_t *data = &bmp180->data;
+    const int32_t x1 = ((ut - data->AC6) * (int32_t)data->AC5) >> 15;
+    const int32_t x2 = bmp180->MC_2_11 / (x1 + data->MD);
+    bmp180->B5 = x1 + x2;
+    return (bmp180->B5 + 8) >> 4;
+}
+
+/**
+ * Compensate pressure (integer arithmetic of the datasheet)
+ * Uses B5 of the last temperature compensation.
+ * @param bmp180
+ * @param up Uncompensated pressure (already shifted by 8 - oss)
+ * @return Pressure in Pa
+*/
+int32_t bmp180_compensate_pressure(const bmp180_t *bmp180, int32_t up) {
+    const bmp180_calibration_data_t *data = &bmp180->data;
+    const uint8_t oss = bmp180->mode;
+    const int32_t b6 = bmp180->B5 - 4000;
+    const int32_t b6_2 = (b6 * b6) >> 12;
+    int32_t x1 = (data->B2 * b6_2) >> 11;
+    int32_t x2 = (data->AC2 * b6) >> 11;
+    int32_t x3 = x1 + x2;
+    const int32_t b3 = (((bmp180->AC1_4 + x3) << oss) + 2) / 4;
+    x1 = (data->AC3 * b6) >> 13;
+    x2 = (data->B1 * b6_2) >> 16;
+    x3 = ((x1 + x2) + 2) >> 2;
+    const uint32_t b4 = ((uint32_t)data->AC4 * (uint32_t)(x3 + 32768)) >> 15;
+    const uint32_t b7 = ((uint32_t)up - b3) * (50000 >> oss);
+    int32_t p;
+    if (b7 < 0x80000000) {
+        p = (b7 * 2) / b4;
+    } else {
+        p = (b7 / b4) * 2;
+    }
+    x1 = (p >> 8) * (p >> 8);
+    x1 = (x1 * 3038) >> 16;
+    x2 = (-7357 * p) >> 16;
+    return p + ((x1 + x2 + 3791) >> 4); // Pressure in Pa
+}
+
+/**
+ * Pressure conversion time
+ * @param mode
+ * @return Time in us
+*/
+uint16_t bmp180_get_pressure_conversion_time(bmp180_mode_t mode) {
+    switch (mode) {
+        case BMP180_STANDARD_MODE:
+            return BMP180_CONVERSION_US_PRESSURE_1;
+        case BMP180_HIGH_RESOLUTION_MODE:
+            return BMP180_CONVERSION_US_PRESSURE_2;
+        case BMP180_ULTRA_HIGH_RESOLUTION_MODE:
+            return BMP180_CONVERSION_US_PRESSURE_3;
+        default:
+            return BMP180_CONVERSION_US_PRESSURE_0;
+    }
+}
+
+/**
+ * Conversion time of the running measurement
+ * @return Time in us
+*/
+static uint16_t bmp180_get_conversion_time(const bmp180_t *bmp180) {
+    if (bmp180->conversion == BMP180_CONVERSION_TEMPERATURE) {
+        return BMP180_CONVERSION_US_TEMPERATURE;
+    }
+    return bmp180_get_pressure_conversion_time(bmp180->mode);
+}
+
+static bool bmp180_start(bmp180_t *bmp180, bmp180_conversion_t conversion, uint8_t command, uint16_t *ready_us) {
+    const bool is_ok = bmp180_write_register(bmp180->i2c_address, BMP180_REGISTER_CTR_MEAS, command);
+    bmp180->conversion = is_ok ? conversion : BMP180_CONVERSION_NONE;
+    if (is_ok && ready_us != NULL) {
+        *ready_us = bmp180_get_conversion_time(bmp180);
+    }
+    return is_ok;
+}
+
+/**
+ * Start temperature measurement
+ * Does not wait, the result is fetched by bmp180_read_result().
+ * @param bmp180
+ * @param ready_us Time from now until the result is ready, in us (NULL = not needed)
+*/
+bool bmp180_start_temperature(bmp180_t *bmp180, uint16_t *ready_us) {
+    return bmp180_start(bmp180, BMP180_CONVERSION_TEMPERATURE, BMP180_START_MEASURE_TEMPERATURE, ready_us);
+}
+
+/**
+ * Start pressure measurement
+ * Does not wait, the result is fetched by bmp180_read_result().
+ * The temperature must be measured before, see bmp180_compensate_pressure().
+ * @param bmp180
+ * @param ready_us Time from now until the result is ready, in us (NULL = not needed)
+*/
+bool bmp180_start_pressure(bmp180_t *bmp180, uint16_t *ready_us) {
+    return bmp180_start(bmp180, BMP180_CONVERSION_PRESSURE, BMP180_START_MEASURE_PRESSURE | (bmp180->mode << 6), ready_us);
+}
+
+/**
+ * Check whether the running measurement is complete
+ * Reads Start of Conversion bit, it is cleared by the sensor at the end of conversion.
+ * @param bmp180
+ * @param is_ready
+*/
+bool bmp180_poll(const bmp180_t *bmp180, bool *is_ready) {
+    if (bmp180->conversion == BMP180_CONVERSION_NONE) {
+        *is_ready = false;
+        return true;
+    }
+    uint8_t ctrl_meas;
+    const bool is_ok = bmp180_read_registers(bmp180->i2c_address, BMP180_REGISTER_CTR_MEAS, &ctrl_meas, 1);
+    if (is_ok) {
+        *is_ready = !bit_is_set(ctrl_meas, BMP180_CTR_MEAS_SCO);
+    }
+    return is_ok;
+}
+
+/**
+ * Read and compensate the result of the measurement
+ * Must be called when the conversion time has passed or bmp180_poll() reports ready.
+ * @param bmp180
+ * @param value Temperature in 0.1 C or pressure in Pa, depending on the started measurement
+*/
+bool bmp180_read_result(bmp180_t *bmp180, int32_t *value) {
+    const bmp180_conversion_t conversion = bmp180->conversion;
+    if (conversion == BMP180_CONVERSION_NONE) {
+        return false;
+    }
+    bmp180->conversion = BMP180_CONVERSION_NONE;
+
+    uint8_t out[3];
+    const uint8_t length = conversion == BMP180_CONVERSION_TEMPERATURE ? 2 : 3;
+    const bool is_ok = bmp180_read_registers(bmp180->i2c_address, BMP180_REGISTER_OUT_MSB, out, length);
+    if (!is_ok) {
+        return is_ok;
+    }
+
+    if (conversion == BMP180_CONVERSION_TEMPERATURE) {
+        bmp180->UT = (int32_t)out[0] << 8 | out[1];
+        *value = bmp180_compensate_temperature(bmp180, bmp180->UT);
+        bmp180_update_temperature_cache(bmp180, *value);
+    }
+    else {
+        bmp180->UP = ((uint32_t)out[0] << 16 | (uint32_t)out[1] << 8 | out[2]) >> (8 - bmp180->mode);
+        *value = bmp180_compensate_pressure(bmp180, bmp180->UP);
+    }
+    return is_ok;
+}
+
 bool bmp180_get_temperature(bmp180_t *bmp180, int32_t *temp) {
-    bool is_ok;
-    is_ok = i2c_start(bmp180->i2c_address, I2C_MODE_WRITE);
-    is_ok = is_ok && i2c_write_byte(BMP180_REGISTER_CTR_MEAS);
-    is_ok = is_ok && i2c_write_byte(BMP180_START_MEASURE_TEMPERATURE);
-    i2c_stop();
+    bool is_ok = bmp180_start_temperature(bmp180, NULL);
 
     if (!is_ok) {
         return is_ok;
@@ -79,33 +295,16 @@ bool bmp180_get_temperature(bmp180_t *bmp180, int32_t *temp) {
     // Waiting measurement
     _delay_ms(BMP180_DELAY_MS_TEMPERATURE);
 
-    uint8_t msb = 0;
-    uint8_t lsb = 0;
-    is_ok = is_ok && i2c_start(bmp180->i2c_address, I2C_MODE_WRITE);
-    is_ok = is_ok && i2c_write_byte(BMP180_REGISTER_OUT_MSB);
-    is_ok = is_ok && i2c_start(bmp180->i2c_address, I2C_MODE_READ);
-    is_ok = is_ok && i2c_read_byte_ACK(&msb);
-    is_ok = is_ok && i2c_read_byte_NACK(&lsb);
-    i2c_stop();
-
-    if (is_ok) {
-        const bmp180_calibration_data_t *data = &bmp180->data;
-        int32_t ut = (msb << 8) | lsb;
-        int32_t x1 = (ut - data->AC6) * data->AC5 / pow(2, 15);
-        int32_t x2 = data->MC * pow(2, 11) / (x1 + data->MD);
-        bmp180->B5 = x1 + x2;
-        int32_t t = (bmp180->B5 + 8) / pow(2, 4); // Temperature in 0.1 C
-        *temp = t;
-    }
-    return is_ok;
+    return bmp180_read_result(bmp180, temp);
 }
 
-bool bmp180_get_pressure(const bmp180_t *bmp180, int32_t *press) {
-    bool is_ok;
-    is_ok = i2c_start(bmp180->i2c_address, I2C_MODE_WRITE);
-    is_ok = is_ok && i2c_write_byte(BMP180_REGISTER_CTR_MEAS);
-    is_ok = is_ok && i2c_write_byte(BMP180_START_MEASURE_PRESSURE | (bmp180->mode << 6));
-    i2c_stop();
+bool bmp180_get_pressure(bmp180_t *bmp180, int32_t *press) {
+    bool is_ok = true;
+    if (bmp180_is_temperature_stale(bmp180)) {
+        int32_t temp;
+        is_ok = bmp180_get_temperature(bmp180, &temp);
+    }
+    is_ok = is_ok && bmp180_start_pressure(bmp180, NULL);
 
     if (!is_ok) {
         return is_ok;
@@ -127,69 +326,29 @@ bool bmp180_get_pressure(const bmp180_t *bmp180, int32_t *press) {
             break;
     }
 
-    uint8_t msb = 0;
-    uint8_t lsb = 0;
-    uint8_t xlsb = 0;
-    
-    is_ok = is_ok && i2c_start(bmp180->i2c_address, I2C_MODE_WRITE);
-    is_ok = is_ok && i2c_write_byte(BMP180_REGISTER_OUT_MSB);
-    is_ok = is_ok && i2c_start(bmp180->i2c_address, I2C_MODE_READ);
-    is_ok = is_ok && i2c_read_byte_ACK(&msb);
-    is_ok = is_ok && i2c_read_byte_ACK(&lsb);
-    is_ok = is_ok && i2c_read_byte_NACK(&xlsb);
-    i2c_stop();
-
-    if (is_ok) {
-        const bmp180_calibration_data_t *data = &bmp180->data;
-        int32_t up = ((uint32_t)msb << 16 | (uint32_t)lsb << 8 | xlsb) >> (8 - bmp180->mode);
-        int32_t b6 = bmp180->B5 - 4000;
-        int32_t x1 = (data->B2 * (b6 * b6 / pow(2, 12))) / pow(2, 11);
-        int32_t x2 = data->AC2 * b6 / pow(2, 11);
-        int32_t x3 = x1 + x2;
-        int32_t b3 = ((((int32_t)data->AC1 * 4 + x3) << bmp180->mode) + 2) / 4;
-        x1 = data->AC3 * b6 / pow(2, 13);
-        x2 = (data->B1 * (b6 * b6 / pow(2, 12))) / pow(2, 16);
-        x3 = ((x1 + x2) + 2) / pow(2, 2);
-        uint32_t b4 = data->AC4 * (uint32_t)(x3 + 32768) / pow(2, 15);
-        uint32_t b7 = ((uint32_t)up - b3) * (50000 >> bmp180->mode);
-        int32_t p = 0;
-        if (b7 < 0x80000000) {
-            p = (b7 * 2) / b4;
-        } else {
-            p = (b7 / b4) * 2;
-        }
-        x1 = (p / pow(2, 8)) * (p / pow(2, 8));
-        x1 = (x1 * 3038) / pow(2, 16);
-        x2 = (-7357 * p) / pow(2, 16);
-        p = p + (x1 + x2 + 3791) / pow(2, 4); // Pressure in Pa
-        *press = p;
-    }
-    return is_ok;
+    return bmp180_read_result(bmp180, press);
 }
 
+/**
+ * Altitude in m above the standard sea level pressure
+ * See: units_pressure_to_altitude()
+*/
 uint16_t bmp180_pressure_to_altitude(int32_t *pressure) {
-    return (uint16_t)(44330 * (1 - pow((*pressure / 101325.0), 1 / 5.255)));
+    return (uint16_t)(units_pressure_to_altitude(*pressure, UNITS_STANDARD_PRESSURE) / 10);
 }
 
+/**
+ * Pressure in mmHg
+ * See: units_pressure_to_mmhg()
+*/
 uint16_t bmp180_pressure_to_mm(int32_t *pressure) {
-    return (uint16_t)(*pressure / 133.322);
+    return units_pressure_to_mmhg(*pressure);
 }
 
 bool bmp180_reset(const bmp180_t *bmp180) {
-    bool is_ok;
-    is_ok = i2c_start(bmp180->i2c_address, I2C_MODE_WRITE);
-    is_ok = is_ok && i2c_write_byte(BMP180_REGISTER_SOFT_RESET);
-    is_ok = is_ok && i2c_write_byte(BMP180_START_SOFT_RESET);
-    i2c_stop();
-    return is_ok;
+    return bmp180_write_register(bmp180->i2c_address, BMP180_REGISTER_SOFT_RESET, BMP180_START_SOFT_RESET);
 }
 
 bool bmp180_get_id(const bmp180_t *bmp180, uint8_t *chip_id) {
-    bool is_ok;
-    is_ok = i2c_start(bmp180->i2c_address, I2C_MODE_WRITE);
-    is_ok = is_ok && i2c_write_byte(BMP180_REGISTER_CHIP_ID);
-    is_ok = is_ok && i2c_start(bmp180->i2c_address, I2C_MODE_READ);
-    is_ok = is_ok && i2c_read_byte_NACK(chip_id);
-    i2c_stop();
-    return is_ok;
+    return bmp180_read_registers(bmp180->i2c_address, BMP180_REGISTER_CHIP_ID, chip_id, 1);
 }
@@ -13,8 +13,17 @@
 bmp180_t bmp180_create(uint8_t i2c_address);
 bool bmp180_init(bmp180_t *bmp180);
 bool bmp180_get_temperature(bmp180_t *bmp180, int32_t *temp);
-bool bmp180_get_pressure(const bmp180_t *bmp180, int32_t *press);
+bool bmp180_get_pressure(bmp180_t *bmp180, int32_t *press);
+bool bmp180_start_temperature(bmp180_t *bmp180, uint16_t *ready_us);
+bool bmp180_start_pressure(bmp180_t *bmp180, uint16_t *ready_us);
+bool bmp180_poll(const bmp180_t *bmp180, bool *is_ready);
+bool bmp180_read_result(bmp180_t *bmp180, int32_t *value);
+uint16_t bmp180_get_pressure_conversion_time(bmp180_mode_t mode);
+int32_t bmp180_compensate_temperature(bmp180_t *bmp180, int32_t ut);
+int32_t bmp180_compensate_pressure(const bmp180_t *bmp180, int32_t up);
 void bmp180_set_mode(bmp180_t *bmp180, bmp180_mode_t mode);
+void bmp180_set_temperature_cache(bmp180_t *bmp180, uint32_t max_age, uint8_t max_drift, bmp180_clock_t clock);
+bool bmp180_is_temperature_stale(const bmp180_t *bmp180);
 bool bmp180_reset(const bmp180_t *bmp180);
 bool bmp180_get_id(const bmp180_t *bmp180, uint8_t *chip_id);
 uint16_t bmp180_pressure_to_altitude(int32_t *pressure);
@@ -21,6 +21,7 @@
 #define BMP180_EPROM_MB 0xBA
 #define BMP180_EPROM_MC 0xBC
 #define BMP180_EPROM_MD 0xBE
+#define BMP180_EPROM_SIZE 22 // AC1-MD, 11 big-endian words
 
 #define BMP180_START_MEASURE_TEMPERATURE 0x2E // Start measure temperature
 #define BMP180_START_MEASURE_PRESSURE 0x34 // Start measure pressure
@@ -32,6 +33,16 @@
 #define BMP180_DELAY_MS_PRESSURE_2 13.5
 #define BMP180_DELAY_MS_PRESSURE_3 25.5
 
+#define BMP180_CONVERSION_US_TEMPERATURE 4500
+#define BMP180_CONVERSION_US_PRESSURE_0 4500
+#define BMP180_CONVERSION_US_PRESSURE_1 7500
+#define BMP180_CONVERSION_US_PRESSURE_2 13500
+#define BMP180_CONVERSION_US_PRESSURE_3 25500
+
+#define BMP180_DRIFT_SCALE 65536UL // Drift rate is stored in 0.1 C per 65536 ms (about a minute)
+
+#define BMP180_CTR_MEAS_SCO 5 // Start of conversion, cleared when the conversion is complete
+
 #define BMP180_REGISTER_OUT_XLSB 0xF8
 #define BMP180_REGISTER_OUT_LSB 0xF7
 #define BMP180_REGISTER_OUT_MSB 0xF6
@@ -46,6 +57,14 @@ typedef enum {
     BMP180_ULTRA_HIGH_RESOLUTION_MODE = 3,
 } bmp180_mode_t;
 
+typedef enum {
+    BMP180_CONVERSION_NONE = 0,
+    BMP180_CONVERSION_TEMPERATURE = 1,
+    BMP180_CONVERSION_PRESSURE = 2,
+} bmp180_conversion_t;
+
+typedef uint32_t (*bmp180_clock_t)(void); // Time in ms
+
 typedef struct {
     int16_t AC1;
     int16_t AC2;
@@ -63,8 +82,20 @@ typedef struct {
 typedef struct {
     const uint8_t i2c_address;
     bmp180_mode_t mode;
+    bmp180_conversion_t conversion; // Running measurement
     bmp180_calibration_data_t data;
     int32_t B5; // For calculation pressure
+    bool is_B5_valid; // Temperature has been measured
+    uint32_t B5_time; // Time of the temperature measurement in ms (only with temperature cache)
+    uint32_t B5_max_age; // In ms, 0 = temperature cache is off
+    uint8_t max_drift; // In 0.1 C
+    uint16_t drift_rate; // Temperature change in 0.1 C per BMP180_DRIFT_SCALE ms
+    bmp180_clock_t clock; // Time in ms for the temperature cache
+    int32_t temperature; // Last measured temperature in 0.1 C
+    int32_t UT; // Last uncompensated temperature
+    int32_t UP; // Last uncompensated pressure
+    int32_t MC_2_11; // MC * 2^11, precomputed in bmp180_init()
+    int32_t AC1_4; // AC1 * 4, precomputed in bmp180_init()
 } bmp180_t;
 
 #endif // BMP180_DEF_H
\ No newline at end of file
@@ -0,0 +1,183 @@
+/**
+ * C Library for BMP180 oversampling
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bmp180.h"
+#include "bmp180_sampler.h"
+
+bmp180_sampler_config_t bmp180_sampler_create_config(void) {
+    bmp180_sampler_config_t config = {
+        .mode = BMP180_STANDARD_MODE,
+        .samples = 1,
+        .filter = BMP180_FILTER_AVERAGE,
+    };
+    return config;
+}
+
+static uint8_t bmp180_sampler_get_samples(const bmp180_sampler_config_t* config) {
+    if (config->samples == 0) {
+        return 1;
+    }
+    return config->samples > BMP180_SAMPLER_MAX_SAMPLES ? BMP180_SAMPLER_MAX_SAMPLES : config->samples;
+}
+
+/**
+ * Conversion time of one burst: one temperature and N pressure conversions
+ * @return Time in us
+*/
+uint32_t bmp180_sampler_get_conversion_time(const bmp180_sampler_config_t* config) {
+    return BMP180_CONVERSION_US_TEMPERATURE + (uint32_t)bmp180_get_pressure_conversion_time(config->mode) * bmp180_sampler_get_samples(config);
+}
+
+static int32_t bmp180_sampler_average(const int32_t* values, uint8_t length) {
+    int32_t sum = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        sum += values[i];
+    }
+    return (sum + length / 2) / length; // Rounded
+}
+
+static int32_t bmp180_sampler_median(int32_t* values, uint8_t length) {
+    // Insertion sort, length is small
+    for (uint8_t i = 1; i < length; i++) {
+        const int32_t value = values[i];
+        uint8_t j = i;
+        while (j > 0 && values[j - 1] > value) {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = value;
+    }
+    if (length % 2 == 0) {
+        return (values[length / 2 - 1] + values[length / 2] + 1) / 2;
+    }
+    return values[length / 2];
+}
+
+/**
+ * Measure temperature and pressure with oversampling
+ * Temperature is measured once, then N pressure conversions are done back-to-back
+ * and filtered. With temperature cache the temperature is measured only when it is stale,
+ * see bmp180_set_temperature_cache(). Sets the mode of the sensor.
+ * @param bmp180
+ * @param config
+ * @param temp Temperature in 0.1 C
+ * @param press Pressure in Pa
+*/
+bool bmp180_sampler_measure(bmp180_t* bmp180, const bmp180_sampler_config_t* config, int32_t* temp, int32_t* press) {
+    const uint8_t samples = bmp180_sampler_get_samples(config);
+    int32_t values[BMP180_SAMPLER_MAX_SAMPLES];
+
+    bmp180_set_mode(bmp180, config->mode);
+    bool is_ok = true;
+    if (bmp180->B5_max_age == 0) {
+        is_ok = bmp180_get_temperature(bmp180, temp);
+    }
+    for (uint8_t i = 0; i < samples && is_ok; i++) {
+        is_ok = bmp180_get_pressure(bmp180, &values[i]);
+    }
+    if (bmp180->B5_max_age != 0) {
+        *temp = bmp180->temperature;
+    }
+
+    if (is_ok) {
+        *press = config->filter == BMP180_FILTER_MEDIAN ? bmp180_sampler_median(values, samples) : bmp180_sampler_average(values, samples);
+    }
+    return is_ok;
+}
+
+static uint32_t isqrt(uint32_t value) {
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+/**
+ * Measure noise of the configuration
+ * Takes a number of filtered readings and computes their standard deviation.
+ * The pressure must be stable during the benchmark.
+ * @param bmp180
+ * @param config
+ * @param rounds Filtered readings (2-255)
+ * @param benchmark Result
+*/
+bool bmp180_sampler_benchmark(bmp180_t* bmp180, const bmp180_sampler_config_t* config, uint8_t rounds, bmp180_benchmark_t* benchmark) {
+    if (rounds < 2) {
+        return false;
+    }
+
+    int32_t temp;
+    int32_t first = 0;
+    int32_t sum = 0; // Deviations from the first reading are small, so the sums fit in 32 bits
+    uint32_t sum_squares = 0;
+    bool is_ok = true;
+
+    for (uint8_t i = 0; i < rounds && is_ok; i++) {
+        int32_t press;
+        is_ok = bmp180_sampler_measure(bmp180, config, &temp, &press);
+        if (i == 0) {
+            first = press;
+        }
+        const int32_t delta = press - first;
+        sum += delta;
+        sum_squares += (uint32_t)(delta * delta);
+    }
+
+    if (is_ok) {
+        // Variance in Pa^2 scaled by 100^2, so the deviation is in 0.01 Pa
+        const uint64_t n = rounds;
+        const int64_t spread = (int64_t)n * sum_squares - (int64_t)sum * sum;
+        const uint64_t variance = (uint64_t)spread * 10000 / (n * n);
+        benchmark->mode = config->mode;
+        benchmark->samples = bmp180_sampler_get_samples(config);
+        benchmark->filter = config->filter;
+        benchmark->conversion_time = bmp180_sampler_get_conversion_time(config);
+        benchmark->deviation = variance > UINT32_MAX ? UINT16_MAX : (uint16_t)isqrt(variance);
+    }
+    return is_ok;
+}
+
+/**
+ * Benchmark every mode with 1, 2, 4, 8 and 16 samples per burst
+ * The callback is called with the result of every combination, e.g. to print it.
+ * @param bmp180
+ * @param filter
+ * @param rounds Filtered readings per combination (2-255)
+ * @param callback
+ * @param context Passed to the callback
+*/
+bool bmp180_sampler_benchmark_all(bmp180_t* bmp180, bmp180_filter_t filter, uint8_t rounds, bmp180_benchmark_callback_t callback, void* context) {
+    const bmp180_mode_t mode = bmp180->mode;
+    bool is_ok = true;
+
+    for (uint8_t m = BMP180_ULTRA_LOW_POWER_MODE; m <= BMP180_ULTRA_HIGH_RESOLUTION_MODE && is_ok; m++) {
+        for (uint8_t samples = 1; samples <= BMP180_SAMPLER_MAX_SAMPLES && is_ok; samples *= 2) {
+            const bmp180_sampler_config_t config = { .mode = m, .samples = samples, .filter = filter };
+            bmp180_benchmark_t benchmark;
+            is_ok = bmp180_sampler_benchmark(bmp180, &config, rounds, &benchmark);
+            if (is_ok) {
+                callback(&benchmark, context);
+            }
+        }
+    }
+
+    bmp180_set_mode(bmp180, mode);
+    return is_ok;
+}
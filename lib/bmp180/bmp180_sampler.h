@@ -0,0 +1,43 @@
+/**
+ * C Library for BMP180 oversampling
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef BMP180_SAMPLER_H
+#define BMP180_SAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bmp180_def.h"
+
+#define BMP180_SAMPLER_MAX_SAMPLES 16
+
+typedef enum {
+    BMP180_FILTER_AVERAGE = 0,
+    BMP180_FILTER_MEDIAN = 1,
+} bmp180_filter_t;
+
+typedef struct {
+    bmp180_mode_t mode; // Oversampling of the sensor
+    uint8_t samples; // Pressure conversions per burst (1-16)
+    bmp180_filter_t filter;
+} bmp180_sampler_config_t;
+
+typedef struct {
+    bmp180_mode_t mode;
+    uint8_t samples;
+    bmp180_filter_t filter;
+    uint32_t conversion_time; // Conversion time of one burst (in us)
+    uint16_t deviation; // Standard deviation of the filtered pressure (in 0.01 Pa)
+} bmp180_benchmark_t;
+
+typedef void (*bmp180_benchmark_callback_t)(const bmp180_benchmark_t* benchmark, void* context);
+
+bmp180_sampler_config_t bmp180_sampler_create_config(void);
+uint32_t bmp180_sampler_get_conversion_time(const bmp180_sampler_config_t* config);
+bool bmp180_sampler_measure(bmp180_t* bmp180, const bmp180_sampler_config_t* config, int32_t* temp, int32_t* press);
+bool bmp180_sampler_benchmark(bmp180_t* bmp180, const bmp180_sampler_config_t* config, uint8_t rounds, bmp180_benchmark_t* benchmark);
+bool bmp180_sampler_benchmark_all(bmp180_t* bmp180, bmp180_filter_t filter, uint8_t rounds, bmp180_benchmark_callback_t callback, void* context);
+
+#endif // BMP180_SAMPLER_H
@@ -0,0 +1,443 @@
+/**
+ * C Library for history log of measurements in EEPROM
+ *
+ * The log is a ring of blocks, blocks are written in turn so the wear is spread over the whole EEPROM.
+ * A block starts with a header (keyframe) holding the first sample, followed by records of deltas:
+ *   0b0tttpppp - temperature delta -4..3 and pressure delta -8..7
+ *   0b10nnnnnn - n + 1 samples equal to the previous one
+ *   0xC0, zigzag varint temperature delta, zigzag varint pressure delta, 0xC0 | length - any deltas
+ * The last byte of a record tells its length, so records are read backward without decoding the block.
+ * The log is exact by default. With a dead band small changes are not logged, so the noise of the last digit
+ * does not break the runs, see eeprom_log_set_dead_band().
+ *
+ * The commit byte of the header is written last and a record's first byte is written after the rest,
+ * a reset in the middle of a write leaves an invalid block or a free record that are skipped on boot.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "eeprom_log.h"
+
+#define EEPROM_LOG_FREE 0xFF // Erased byte
+#define EEPROM_LOG_COMMIT 0xA5 // Header is complete
+#define EEPROM_LOG_CRC_SIZE 12 // Header bytes covered by CRC
+#define EEPROM_LOG_COMMIT_OFFSET 13
+#define EEPROM_LOG_SMALL_TEMP 4 // Temperature delta bias of the small record
+#define EEPROM_LOG_SMALL_PRESS 8 // Pressure delta bias of the small record
+#define EEPROM_LOG_RUN 0x80
+#define EEPROM_LOG_RUN_MAX 64
+#define EEPROM_LOG_WIDE 0xC0
+#define EEPROM_LOG_WIDE_MIN 4
+#define EEPROM_LOG_WIDE_MAX 8
+#define EEPROM_LOG_VARINT_MAX 3
+
+// Layout of the header in EEPROM, the commit byte is the last one
+typedef struct {
+    uint32_t time; // Time of the keyframe (in seconds)
+    uint16_t sequence; // Increments with every block
+    uint16_t interval; // Time between samples (in seconds)
+    int16_t temp; // Temperature in 0.1 C
+    uint16_t press; // Pressure in 0.1 hPa
+    uint8_t crc;
+    uint8_t commit;
+} eeprom_log_header_t;
+
+typedef struct {
+    int32_t temp; // Temperature delta
+    int32_t press; // Pressure delta
+    uint8_t repeat; // Samples of the record
+    uint8_t length; // Bytes of the record
+} eeprom_log_record_t;
+
+static uint8_t* eeprom_log_get_address(uint8_t block, uint8_t offset) {
+    return (uint8_t*)(uintptr_t)(EEPROM_LOG_ADDRESS + (uint16_t)block * EEPROM_LOG_BLOCK_SIZE + offset);
+}
+
+static uint8_t eeprom_log_read_byte(uint8_t block, uint8_t offset) {
+    return eeprom_read_byte(eeprom_log_get_address(block, offset));
+}
+
+static uint8_t eeprom_log_get_crc(const eeprom_log_header_t* header) {
+    const uint8_t* data = (const uint8_t*)header;
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < EEPROM_LOG_CRC_SIZE; i++) {
+        crc = _crc8_ccitt_update(crc, data[i]);
+    }
+    return crc;
+}
+
+static bool eeprom_log_read_header(uint8_t block, eeprom_log_header_t* header) {
+    eeprom_read_block(header, eeprom_log_get_address(block, 0), EEPROM_LOG_HEADER_SIZE);
+    return header->commit == EEPROM_LOG_COMMIT && header->crc == eeprom_log_get_crc(header);
+}
+
+static uint8_t eeprom_log_put_varint(uint8_t* data, int32_t value) {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    uint8_t length = 0;
+    while (zigzag >= 0x80) {
+        data[length++] = (uint8_t)zigzag | 0x80;
+        zigzag >>= 7;
+    }
+    data[length++] = (uint8_t)zigzag;
+    return length;
+}
+
+static uint8_t eeprom_log_get_varint(uint8_t block, uint8_t offset, int32_t* value) {
+    uint32_t zigzag = 0;
+    for (uint8_t i = 0; i < EEPROM_LOG_VARINT_MAX && offset + i < EEPROM_LOG_BLOCK_SIZE; i++) {
+        const uint8_t data = eeprom_log_read_byte(block, offset + i);
+        zigzag |= (uint32_t)(data & 0x7F) << (7 * i);
+        if (!(data & 0x80)) {
+            *value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Reads the record at the offset, returns false at the end of the block
+static bool eeprom_log_read_record(uint8_t block, uint8_t offset, eeprom_log_record_t* record) {
+    if (offset >= EEPROM_LOG_BLOCK_SIZE) {
+        return false;
+    }
+    const uint8_t tag = eeprom_log_read_byte(block, offset);
+    record->temp = 0;
+    record->press = 0;
+    record->repeat = 1;
+    record->length = 1;
+
+    if (tag < EEPROM_LOG_RUN) {
+        record->temp = (int32_t)(tag >> 4) - EEPROM_LOG_SMALL_TEMP;
+        record->press = (int32_t)(tag & 0x0F) - EEPROM_LOG_SMALL_PRESS;
+        return true;
+    }
+    if (tag < EEPROM_LOG_WIDE) {
+        record->repeat = (tag & 0x3F) + 1;
+        return true;
+    }
+    if (tag != EEPROM_LOG_WIDE) {
+        return false;
+    }
+
+    uint8_t length = eeprom_log_get_varint(block, offset + record->length, &record->temp);
+    record->length = length == 0 ? 0 : record->length + length;
+    length = record->length == 0 ? 0 : eeprom_log_get_varint(block, offset + record->length, &record->press);
+    record->length = length == 0 ? 0 : record->length + length + 1;
+    return record->length != 0 && offset + record->length <= EEPROM_LOG_BLOCK_SIZE
+        && eeprom_log_read_byte(block, offset + record->length - 1) == (EEPROM_LOG_WIDE | record->length);
+}
+
+// Reads the record that ends at the offset
+static bool eeprom_log_read_record_before(uint8_t block, uint8_t end, eeprom_log_record_t* record) {
+    if (end <= EEPROM_LOG_HEADER_SIZE) {
+        return false;
+    }
+    const uint8_t last = eeprom_log_read_byte(block, end - 1);
+    uint8_t length = 1;
+    if (last >= EEPROM_LOG_WIDE) {
+        length = last & 0x0F;
+        if (length < EEPROM_LOG_WIDE_MIN || end < EEPROM_LOG_HEADER_SIZE + length) {
+            return false;
+        }
+    }
+    return eeprom_log_read_record(block, end - length, record) && record->length == length;
+}
+
+/**
+ * Init log
+ * Finds the head and the tail of the log in EEPROM. The first sample after init starts a new block.
+ * @param log
+ * @param interval Time between samples (in seconds)
+*/
+void eeprom_log_init(eeprom_log_t* log, uint16_t interval) {
+    memset(log, 0, sizeof(eeprom_log_t));
+    log->interval = interval;
+    log->head = EEPROM_LOG_NO_BLOCK;
+
+    // Head is the valid block with the latest sequence number
+    eeprom_log_header_t header;
+    for (uint8_t block = 0; block < EEPROM_LOG_BLOCKS; block++) {
+        if (eeprom_log_read_header(block, &header)
+            && (log->head == EEPROM_LOG_NO_BLOCK || (int16_t)(header.sequence - log->sequence) > 0)) {
+            log->head = block;
+            log->sequence = header.sequence;
+        }
+    }
+    if (log->head == EEPROM_LOG_NO_BLOCK) {
+        return;
+    }
+
+    // Tail is the end of the chain of sequence numbers going back from the head
+    log->blocks = 1;
+    while (log->blocks < EEPROM_LOG_BLOCKS) {
+        const uint8_t block = (log->head + EEPROM_LOG_BLOCKS - log->blocks) % EEPROM_LOG_BLOCKS;
+        if (!eeprom_log_read_header(block, &header) || header.sequence != (uint16_t)(log->sequence - log->blocks)) {
+            break;
+        }
+        log->blocks++;
+    }
+
+    // Last sample of the head block, decoding stops at a record that was not completed
+    eeprom_log_read_header(log->head, &header);
+    log->temp = header.temp;
+    log->press = header.press;
+    uint16_t samples = 0;
+    uint8_t position = EEPROM_LOG_HEADER_SIZE;
+    eeprom_log_record_t record;
+    while (eeprom_log_read_record(log->head, position, &record)) {
+        log->temp += record.temp;
+        log->press += record.press;
+        samples += record.repeat;
+        position += record.length;
+    }
+    log->time = header.time + (uint32_t)samples * header.interval;
+    log->position = EEPROM_LOG_BLOCK_SIZE; // No RTC, the time after reset does not continue the head block
+}
+
+/**
+ * Set dead band of the logged values
+ * Changes up to the dead band from the logged value are logged as no change, longer runs of equal samples
+ * make the log cover more time. A logged sample is then off by up to the dead band, pressure also by
+ * its rounding to 0.1 hPa (up to 0.1 C and 15 Pa with a dead band of 1).
+ * @param log
+ * @param dead_band In 0.1 C and 0.1 hPa (0 = exact)
+*/
+void eeprom_log_set_dead_band(eeprom_log_t* log, uint8_t dead_band) {
+    log->dead_band = dead_band;
+}
+
+static void eeprom_log_start_block(eeprom_log_t* log, uint32_t time, int16_t temp, uint16_t press) {
+    const bool is_empty = eeprom_log_is_empty(log);
+    const uint8_t block = is_empty ? 0 : (log->head + 1) % EEPROM_LOG_BLOCKS;
+    const eeprom_log_header_t header = {
+        .time = time,
+        .sequence = is_empty ? 0 : log->sequence + 1,
+        .interval = log->interval,
+        .temp = temp,
+        .press = press,
+        .commit = EEPROM_LOG_FREE,
+    };
+    eeprom_log_header_t committed = header;
+    committed.crc = eeprom_log_get_crc(&header);
+
+    // Block is invalidated first, then erased, the header is committed last
+    eeprom_update_byte(eeprom_log_get_address(block, EEPROM_LOG_COMMIT_OFFSET), EEPROM_LOG_FREE);
+    for (uint8_t offset = EEPROM_LOG_HEADER_SIZE; offset < EEPROM_LOG_BLOCK_SIZE; offset++) {
+        eeprom_update_byte(eeprom_log_get_address(block, offset), EEPROM_LOG_FREE);
+    }
+    eeprom_update_block(&committed, eeprom_log_get_address(block, 0), EEPROM_LOG_COMMIT_OFFSET);
+    eeprom_update_byte(eeprom_log_get_address(block, EEPROM_LOG_COMMIT_OFFSET), EEPROM_LOG_COMMIT);
+
+    if (log->blocks < EEPROM_LOG_BLOCKS) {
+        log->blocks++;
+    }
+    log->head = block;
+    log->sequence = header.sequence;
+    log->position = EEPROM_LOG_HEADER_SIZE;
+    log->run = 0;
+}
+
+// First byte of the record is written last
+static bool eeprom_log_write_record(eeprom_log_t* log, const uint8_t* data, uint8_t length) {
+    if (log->position + length > EEPROM_LOG_BLOCK_SIZE) {
+        return false;
+    }
+    for (uint8_t i = length - 1; i > 0; i--) {
+        eeprom_update_byte(eeprom_log_get_address(log->head, log->position + i), data[i]);
+    }
+    eeprom_update_byte(eeprom_log_get_address(log->head, log->position), data[0]);
+    log->position += length;
+    return true;
+}
+
+static bool eeprom_log_write_delta(eeprom_log_t* log, int32_t temp, int32_t press) {
+    uint8_t data[EEPROM_LOG_WIDE_MAX];
+    uint8_t length;
+
+    if (temp == 0 && press == 0) {
+        if (log->run != 0) {
+            const uint8_t run = eeprom_log_read_byte(log->head, log->run);
+            if ((run & 0x3F) < EEPROM_LOG_RUN_MAX - 1) {
+                // Byte is rewritten in place, a reset loses only this run
+                eeprom_update_byte(eeprom_log_get_address(log->head, log->run), run + 1);
+                return true;
+            }
+        }
+        data[0] = EEPROM_LOG_RUN;
+        length = 1;
+    }
+    else if (temp >= -EEPROM_LOG_SMALL_TEMP && temp < EEPROM_LOG_SMALL_TEMP
+             && press >= -EEPROM_LOG_SMALL_PRESS && press < EEPROM_LOG_SMALL_PRESS) {
+        data[0] = (uint8_t)((temp + EEPROM_LOG_SMALL_TEMP) << 4) | (uint8_t)(press + EEPROM_LOG_SMALL_PRESS);
+        length = 1;
+    }
+    else {
+        data[0] = EEPROM_LOG_WIDE;
+        length = 1;
+        length += eeprom_log_put_varint(&data[length], temp);
+        length += eeprom_log_put_varint(&data[length], press);
+        length++;
+        data[length - 1] = EEPROM_LOG_WIDE | length;
+    }
+
+    const uint8_t position = log->position;
+    if (!eeprom_log_write_record(log, data, length)) {
+        return false;
+    }
+    log->run = data[0] == EEPROM_LOG_RUN ? position : 0;
+    return true;
+}
+
+// Logged value follows the samples with a lag of up to the dead band
+static int32_t eeprom_log_apply_dead_band(const eeprom_log_t* log, int32_t delta) {
+    return delta >= -log->dead_band && delta <= log->dead_band ? 0 : delta;
+}
+
+/**
+ * Append sample
+ * A new block is started when the block is full or the time does not follow the previous sample.
+ * @param log
+ * @param time Time of the sample (in seconds)
+ * @param temp Temperature in 0.1 C
+ * @param press Pressure in Pa
+*/
+void eeprom_log_append(eeprom_log_t* log, uint32_t time, int32_t temp, int32_t press) {
+    const int16_t log_temp = temp > INT16_MAX ? INT16_MAX : (temp < INT16_MIN ? INT16_MIN : (int16_t)temp);
+    press = (press + EEPROM_LOG_PRESSURE_SCALE / 2) / EEPROM_LOG_PRESSURE_SCALE;
+    const uint16_t log_press = press > UINT16_MAX ? UINT16_MAX : (press < 0 ? 0 : (uint16_t)press);
+
+    const bool is_next = !eeprom_log_is_empty(log) && time == log->time + log->interval;
+    const int32_t temp_delta = eeprom_log_apply_dead_band(log, (int32_t)log_temp - log->temp);
+    const int32_t press_delta = eeprom_log_apply_dead_band(log, (int32_t)log_press - log->press);
+    if (!is_next || !eeprom_log_write_delta(log, temp_delta, press_delta)) {
+        eeprom_log_start_block(log, time, log_temp, log_press);
+        log->temp = log_temp;
+        log->press = log_press;
+    }
+    else {
+        log->temp += temp_delta;
+        log->press += press_delta;
+    }
+    log->time = time;
+}
+
+bool eeprom_log_is_empty(const eeprom_log_t* log) {
+    return log->head == EEPROM_LOG_NO_BLOCK;
+}
+
+/**
+ * Get time of the last sample
+ * @param log
+*/
+uint32_t eeprom_log_get_time(const eeprom_log_t* log) {
+    return log->time;
+}
+
+/**
+ * Clear log
+ * Only the commit bytes of the headers are erased.
+ * @param log
+*/
+void eeprom_log_clear(eeprom_log_t* log) {
+    const uint8_t dead_band = log->dead_band;
+    for (uint8_t block = 0; block < EEPROM_LOG_BLOCKS; block++) {
+        eeprom_update_byte(eeprom_log_get_address(block, EEPROM_LOG_COMMIT_OFFSET), EEPROM_LOG_FREE);
+    }
+    eeprom_log_init(log, log->interval);
+    log->dead_band = dead_band;
+}
+
+/**
+ * Create iterator from the last sample to the first one
+ * The log must not be appended while iterating.
+ * @param log
+*/
+eeprom_log_iterator_t eeprom_log_iterate(const eeprom_log_t* log) {
+    eeprom_log_iterator_t iterator;
+    memset(&iterator, 0, sizeof(eeprom_log_iterator_t));
+    iterator.block = log->head;
+    iterator.blocks = log->blocks == 0 ? 0 : log->blocks - 1;
+    iterator.sequence = log->sequence;
+    return iterator;
+}
+
+// Decodes the block forward once, the samples are then undone one by one
+static bool eeprom_log_load_block(eeprom_log_iterator_t* iterator) {
+    eeprom_log_header_t header;
+    if (!eeprom_log_read_header(iterator->block, &header) || header.sequence != iterator->sequence) {
+        iterator->block = EEPROM_LOG_NO_BLOCK;
+        return false;
+    }
+    iterator->time = header.time;
+    iterator->interval = header.interval;
+    iterator->temp = header.temp;
+    iterator->press = header.press;
+    iterator->index = 0;
+    iterator->repeat = 0;
+    iterator->position = EEPROM_LOG_HEADER_SIZE;
+
+    eeprom_log_record_t record;
+    while (eeprom_log_read_record(iterator->block, iterator->position, &record)) {
+        iterator->temp += record.temp;
+        iterator->press += record.press;
+        iterator->index += record.repeat;
+        iterator->position += record.length;
+    }
+    iterator->is_started = true;
+    return true;
+}
+
+static void eeprom_log_step_back(eeprom_log_iterator_t* iterator) {
+    if (iterator->index == 0) {
+        // Keyframe was the first sample of the block
+        if (iterator->blocks == 0) {
+            iterator->block = EEPROM_LOG_NO_BLOCK;
+        }
+        else {
+            iterator->block = (iterator->block + EEPROM_LOG_BLOCKS - 1) % EEPROM_LOG_BLOCKS;
+            iterator->blocks--;
+            iterator->sequence--;
+            iterator->is_started = false;
+        }
+        return;
+    }
+
+    if (iterator->repeat == 0) {
+        eeprom_log_record_t record;
+        if (!eeprom_log_read_record_before(iterator->block, iterator->position, &record)) {
+            iterator->block = EEPROM_LOG_NO_BLOCK;
+            return;
+        }
+        iterator->position -= record.length;
+        iterator->repeat = record.repeat;
+        iterator->temp -= record.temp;
+        iterator->press -= record.press;
+    }
+    iterator->repeat--;
+    iterator->index--;
+}
+
+/**
+ * Get previous sample
+ * @param iterator
+ * @param sample
+ * @return false if there are no more samples
+*/
+bool eeprom_log_prev(eeprom_log_iterator_t* iterator, eeprom_log_sample_t* sample) {
+    if (iterator->block == EEPROM_LOG_NO_BLOCK) {
+        return false;
+    }
+    if (!iterator->is_started && !eeprom_log_load_block(iterator)) {
+        return false;
+    }
+    sample->time = iterator->time + (uint32_t)iterator->index * iterator->interval;
+    sample->temp = iterator->temp;
+    sample->press = (int32_t)iterator->press * EEPROM_LOG_PRESSURE_SCALE;
+    eeprom_log_step_back(iterator);
+    return true;
+}
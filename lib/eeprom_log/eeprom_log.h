@@ -0,0 +1,69 @@
+/**
+ * C Library for history log of measurements in EEPROM
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef EEPROM_LOG_H
+#define EEPROM_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef EEPROM_LOG_ADDRESS
+#define EEPROM_LOG_ADDRESS 0 // First byte of the log in EEPROM
+#endif
+// A sample per minute in 16 blocks covers about 22 hours of weather changing by 40 Pa/h and about 17 hours
+// of steady weather (native build with the noise of the datasheet), with a dead band of 1 about 3 days
+// and about 12 days, see eeprom_log_set_dead_band()
+#ifndef EEPROM_LOG_BLOCKS
+#define EEPROM_LOG_BLOCKS 16 // 16 * 64 = 1 KB, whole EEPROM of ATmega328P
+#endif
+#define EEPROM_LOG_BLOCK_SIZE 64
+#define EEPROM_LOG_HEADER_SIZE 14
+#define EEPROM_LOG_NO_BLOCK 0xFF
+#define EEPROM_LOG_PRESSURE_SCALE 10 // Pressure is logged in 0.1 hPa
+
+typedef struct {
+    uint32_t time; // Time of the sample (in seconds)
+    int16_t temp; // Temperature in 0.1 C
+    int32_t press; // Pressure in Pa (rounded to 0.1 hPa)
+} eeprom_log_sample_t;
+
+typedef struct {
+    uint16_t interval; // Time between samples (in seconds)
+    uint8_t dead_band; // Changes up to this (in 0.1 C or 0.1 hPa) are logged as no change, 0 = exact
+    uint8_t head; // Block being written (EEPROM_LOG_NO_BLOCK = log is empty)
+    uint8_t blocks; // Valid blocks from the oldest to the head
+    uint16_t sequence; // Sequence number of the head block
+    uint8_t position; // Write offset in the head block
+    uint8_t run; // Offset of the run record that is extended by equal samples (0 = none)
+    uint32_t time; // Last sample as logged (temperature in 0.1 C, pressure in 0.1 hPa)
+    int16_t temp;
+    uint16_t press;
+} eeprom_log_t;
+
+typedef struct {
+    uint8_t block; // Current block (EEPROM_LOG_NO_BLOCK = no more samples)
+    uint8_t blocks; // Blocks left after the current one
+    uint16_t sequence;
+    uint8_t position; // End of the next record to undo
+    uint8_t repeat; // Samples left of the current run record
+    uint16_t index; // Index of the current sample in the block (keyframe = 0)
+    bool is_started;
+    uint32_t time; // Time of the keyframe
+    uint16_t interval;
+    int16_t temp;
+    uint16_t press;
+} eeprom_log_iterator_t;
+
+void eeprom_log_init(eeprom_log_t* log, uint16_t interval);
+void eeprom_log_set_dead_band(eeprom_log_t* log, uint8_t dead_band);
+void eeprom_log_append(eeprom_log_t* log, uint32_t time, int32_t temp, int32_t press);
+bool eeprom_log_is_empty(const eeprom_log_t* log);
+uint32_t eeprom_log_get_time(const eeprom_log_t* log);
+void eeprom_log_clear(eeprom_log_t* log);
+eeprom_log_iterator_t eeprom_log_iterate(const eeprom_log_t* log);
+bool eeprom_log_prev(eeprom_log_iterator_t* iterator, eeprom_log_sample_t* sample);
+
+#endif // EEPROM_LOG_H
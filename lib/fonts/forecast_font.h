@@ -0,0 +1,33 @@
+#ifndef FORECAST_FONT_H
+#define FORECAST_FONT_H
+
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include "ssd1306_def.h"
+
+// Generated by tools/bitmap_converter.py (page-native format)
+static const uint8_t PROGMEM forecast_font_bitmaps[] = {
+    0x80, 0x80, 0xc, 0xcc, 0xe8, 0xf0, 0xf0, 0xf3, 0xf3, 0xf0, 0xf0, 0xe8, 0xcc, 0xc, 0x80, 0x80, 0x1, 0x1, 0x30, 0x33, 0x17, 0xf, 0xf, 0xcf, 0xcf, 0xf, 0xf, 0x17, 0x33, 0x30, 0x1, 0x1, // '0'
+    0x20, 0x22, 0x4, 0xf0, 0xf8, 0xfb, 0x78, 0xb0, 0xe4, 0xc2, 0xc0, 0xc0, 0x80, 0x0, 0x0, 0x0, 0x0, 0x0, 0x18, 0x3c, 0x3d, 0x3e, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3e, 0x18, // '1'
+    0x0, 0x0, 0xc0, 0xe0, 0xe0, 0xf0, 0xf8, 0xf8, 0xf8, 0xf8, 0xf0, 0xe0, 0xc0, 0x80, 0x0, 0x0, 0xe, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0xe, // '2'
+    0xc0, 0xe0, 0xf8, 0xfc, 0xfc, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xfe, 0xfc, 0xf8, 0xf0, 0xe0, 0xc0, 0x0, 0x9, 0x45, 0x21, 0x1, 0x9, 0x45, 0x21, 0x1, 0x9, 0x45, 0x21, 0x1, 0x9, 0x5, 0x0, // '3'
+    0xc0, 0xe0, 0xf8, 0xfc, 0xfc, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xfe, 0xfc, 0xf8, 0xf0, 0xe0, 0xc0, 0x0, 0x1, 0x1, 0x1, 0x1, 0x9, 0x4d, 0x2e, 0x3a, 0x19, 0x9, 0x1, 0x1, 0x1, 0x1, 0x0, // '4'
+};
+
+// Offset of the glyph in forecast_font_bitmaps for every char from 0x30 to 0x34
+static const uint16_t PROGMEM forecast_font_offsets[] = {
+    0, 32, 64, 96, 128,
+};
+
+const ssd1306_font_t forecast_font = {
+    .width = 16,
+    .height = 16,
+    .letter_spacing = 0,
+    .format = SSD1306_BITMAP_PAGED,
+    .first_char = 0x30,
+    .last_char = 0x34,
+    .offsets = forecast_font_offsets,
+    .bitmaps = forecast_font_bitmaps
+};
+
+#endif // FORECAST_FONT_H
\ No newline at end of file
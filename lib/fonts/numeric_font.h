@@ -1,58 +1,56 @@
-#ifndef FONT_BINARY_H
-#define FONT_BINARY_H
+#ifndef NUMERIC_FONT_H
+#define NUMERIC_FONT_H
 
 #include <avr/pgmspace.h>
 #include <stdint.h>
 #include "ssd1306_def.h"
 
-static const uint8_t PROGMEM bitmap_space[] = { 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 };
-static const uint8_t PROGMEM bitmap_0[] = { 0x7c, 0xfe, 0xe7, 0xc7, 0xc7, 0xc7, 0xc7, 0xc7, 0xc7, 0xc7, 0xc7, 0xfe, 0x7e };
-static const uint8_t PROGMEM bitmap_1[] = { 0x1c, 0x1f, 0x1f, 0x1b, 0x19, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0xff, 0xff };
-static const uint8_t PROGMEM bitmap_2[] = { 0x3e, 0x7f, 0xe7, 0xe3, 0xe3, 0x60, 0x70, 0x38, 0x1c, 0xe, 0xf, 0xff, 0xff };
-static const uint8_t PROGMEM bitmap_3[] = { 0x7f, 0x7f, 0x70, 0x78, 0x1c, 0x3c, 0x7c, 0xe0, 0xe0, 0xe0, 0xe3, 0x7f, 0x7f };
-static const uint8_t PROGMEM bitmap_4[] = { 0xf0, 0x70, 0x38, 0x38, 0x1c, 0xe, 0xee, 0xe7, 0xff, 0xff, 0xff, 0xe0, 0xe0 };
-static const uint8_t PROGMEM bitmap_5[] = { 0xff, 0xff, 0x7, 0x7, 0x7, 0x7f, 0xff, 0xc7, 0xc0, 0xc0, 0xe7, 0xff, 0x7e };
-static const uint8_t PROGMEM bitmap_6[] = { 0x38, 0x38, 0x1c, 0x1c, 0xe, 0x7f, 0x7f, 0xe7, 0xe3, 0xe3, 0xe3, 0xff, 0x7e };
-static const uint8_t PROGMEM bitmap_7[] = { 0xff, 0xff, 0xe3, 0xe3, 0x63, 0x70, 0x38, 0x38, 0x1c, 0x1c, 0x1c, 0xe, 0xe };
-static const uint8_t PROGMEM bitmap_8[] = { 0x7c, 0xfe, 0xe7, 0xc7, 0xe6, 0xfe, 0x7c, 0xfe, 0xe7, 0xc7, 0xc7, 0xff, 0x7e };
-static const uint8_t PROGMEM bitmap_9[] = { 0x3e, 0x7f, 0xe7, 0xe3, 0xe3, 0xe7, 0xff, 0x7e, 0x70, 0x38, 0x38, 0x1c, 0x1e };
-static const uint8_t PROGMEM bitmap_plus[] = { 0x0, 0x0, 0x0, 0x18, 0x18, 0x18, 0xff, 0xff, 0x18, 0x18, 0x18, 0x0, 0x0 };
-static const uint8_t PROGMEM bitmap_minus[] = { 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x7e, 0x7e, 0x0, 0x0, 0x0, 0x0, 0x0 };
-static const uint8_t PROGMEM bitmap_dot[] = { 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x1c, 0x1c, 0x1c };
-static const uint8_t PROGMEM bitmap_percentage[] = { 0x86, 0xc9, 0x49, 0x66, 0x20, 0x30, 0x18, 0x8, 0xc, 0x66, 0x92, 0x93, 0x61 };
-static const uint8_t PROGMEM bitmap_degree[] = { 0x0, 0x18, 0x24, 0x24, 0x18, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 };
-static const uint8_t PROGMEM bitmap_hg[] = { 0x24, 0x24, 0x3c, 0x24, 0x24, 0x24, 0x0, 0x18, 0x24, 0x24, 0x38, 0x20, 0x18 };
-static const uint8_t PROGMEM bitmap_up[] = { 0x0, 0x10, 0x38, 0x7c, 0xfe, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0x0 };
-static const uint8_t PROGMEM bitmap_down[] = { 0x0, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0xfe, 0x7c, 0x38, 0x10, 0x0 };
+// Generated by tools/bitmap_converter.py (page-native format)
+static const uint8_t PROGMEM numeric_font_bitmaps[] = {
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, // ' '
+    0x6, 0x9, 0x9, 0xc6, 0x60, 0x38, 0xe, 0x3, 0x18, 0xe, 0x3, 0x1, 0xc, 0x12, 0x12, 0xc, // '%'
+    0x0, 0x0, 0xc, 0x12, 0x12, 0xc, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, // '*'
+    0xc0, 0xc0, 0xc0, 0xf8, 0xf8, 0xc0, 0xc0, 0xc0, 0x0, 0x0, 0x0, 0x7, 0x7, 0x0, 0x0, 0x0, // '+'
+    0x0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, // '-'
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x1c, 0x1c, 0x1c, 0x0, 0x0, 0x0, // '.'
+    0xfc, 0xfe, 0xff, 0x3, 0x3, 0x7, 0xff, 0xfe, 0x7, 0x1f, 0x1f, 0x18, 0x18, 0x18, 0x1f, 0xf, // '0'
+    0x1e, 0xe, 0x7, 0xff, 0xff, 0x0, 0x0, 0x0, 0x18, 0x18, 0x18, 0x1f, 0x1f, 0x18, 0x18, 0x18, // '1'
+    0x1e, 0x1f, 0x7, 0x83, 0xc3, 0xff, 0x7e, 0x1c, 0x1c, 0x1e, 0x1f, 0x1f, 0x19, 0x18, 0x18, 0x18, // '2'
+    0x3, 0x3, 0x73, 0x7b, 0x7f, 0xef, 0xcf, 0x80, 0x1c, 0x1c, 0x18, 0x18, 0x18, 0x1f, 0x1f, 0x7, // '3'
+    0x80, 0xe0, 0xf0, 0x7c, 0x1f, 0xcf, 0xc3, 0xc1, 0x7, 0x7, 0x7, 0x7, 0x7, 0x1f, 0x1f, 0x1f, // '4'
+    0xff, 0xff, 0xff, 0x63, 0x63, 0x63, 0xe3, 0xc3, 0xc, 0x1c, 0x1c, 0x18, 0x18, 0x1c, 0x1f, 0xf, // '5'
+    0xe0, 0xf0, 0xfc, 0x7f, 0x6f, 0xe3, 0xe0, 0x80, 0xf, 0x1f, 0x18, 0x18, 0x18, 0x1f, 0x1f, 0xf, // '6'
+    0x1f, 0x1f, 0x3, 0xc3, 0xe3, 0xff, 0x3f, 0xf, 0x0, 0x18, 0x1f, 0x1f, 0x7, 0x0, 0x0, 0x0, // '7'
+    0xc, 0xbe, 0xff, 0xe3, 0xe3, 0xf7, 0xff, 0xbe, 0xf, 0x1f, 0x1f, 0x18, 0x18, 0x19, 0x1f, 0xf, // '8'
+    0x7e, 0xff, 0xe7, 0xc3, 0xc3, 0xff, 0xfe, 0x7c, 0x0, 0x10, 0x18, 0x1e, 0x1f, 0x7, 0x1, 0x0, // '9'
+    0x0, 0x10, 0x18, 0xfc, 0xfe, 0xfc, 0x18, 0x10, 0x0, 0x0, 0x0, 0xf, 0xf, 0xf, 0x0, 0x0, // '<'
+    0x0, 0x0, 0x0, 0xfe, 0xfe, 0xfe, 0x0, 0x0, 0x0, 0x1, 0x3, 0x7, 0xf, 0x7, 0x3, 0x1, // '>'
+    0x0, 0x0, 0x3f, 0x84, 0x84, 0x3f, 0x0, 0x0, 0x0, 0x0, 0x3, 0x14, 0x14, 0xf, 0x0, 0x0, // 'h'
+};
 
-static const ssd1306_letter_t data[] = {
-    {' ', bitmap_space},
-    {'0', bitmap_0},
-    {'1', bitmap_1},
-    {'2', bitmap_2},
-    {'3', bitmap_3},
-    {'4', bitmap_4},
-    {'5', bitmap_5},
-    {'6', bitmap_6},
-    {'7', bitmap_7},
-    {'8', bitmap_8},
-    {'9', bitmap_9},
-    {'+', bitmap_plus},
-    {'-', bitmap_minus},
-    {'.', bitmap_dot},
-    {'%', bitmap_percentage},
-    {'*', bitmap_degree},
-    {'h', bitmap_hg},
-    {'<', bitmap_up},
-    {'>', bitmap_down},
+// Offset of the glyph in numeric_font_bitmaps for every char from 0x20 to 0x68
+static const uint16_t PROGMEM numeric_font_offsets[] = {
+    0, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, 16, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING,
+    SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, 32, 48, SSD1306_GLYPH_MISSING, 64, 80, SSD1306_GLYPH_MISSING,
+    96, 112, 128, 144, 160, 176, 192, 208,
+    224, 240, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, 256, SSD1306_GLYPH_MISSING, 272, SSD1306_GLYPH_MISSING,
+    SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING,
+    SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING,
+    SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING,
+    SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING,
+    SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING, SSD1306_GLYPH_MISSING,
+    288,
 };
 
 const ssd1306_font_t numeric_font = {
     .width = 8,
     .height = 13,
-    .size = sizeof(data) / sizeof(ssd1306_letter_t),
     .letter_spacing = 1,
-    .data = data
+    .format = SSD1306_BITMAP_PAGED,
+    .first_char = 0x20,
+    .last_char = 0x68,
+    .offsets = numeric_font_offsets,
+    .bitmaps = numeric_font_bitmaps
 };
 
-#endif // FONT_BINARY_H
+#endif // NUMERIC_FONT_H
\ No newline at end of file
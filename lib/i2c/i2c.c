@@ -1,18 +1,42 @@
+#ifndef I2C_STUB // See i2c_stub.c, the native build runs it on the simulated TWI (i2c_native.c)
+
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <avr/io.h>
 #include <util/twi.h>
 #include <util/delay.h>
+#include <util/atomic.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include <avr/sfr_defs.h>
+#include <avr/pgmspace.h>
 #include "i2c_def.h"
+#include "i2c_profile.h"
 
 #define I2C_FREQ 400000   // 2C bus frequency (in Hz)
 #define I2C_PRESCALER_VALUE 1 // Prescaler value (TWPS0/TWPS1)
 
 #define I2C_NACK _BV(TWINT) | _BV(TWEN) // Interrupt flag + Enable bit
 #define I2C_ACK _BV(TWINT) | _BV(TWEN) | _BV(TWEA) // Interrupt flag + Enable bit + Enable Acknowledge bit
+#define I2C_START _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) // Interrupt flag + Start bit + Enable bit
+#define I2C_STOP _BV(TWINT) | _BV(TWSTO) | _BV(TWEN) // Interrupt flag + Stop bit + Enable bit
 
 static bool i2c_ready = false;
-static uint8_t i2c_error = 0; // See: Table 22-2. Status codes for Master Transmitter Mode
+static uint8_t i2c_error = I2C_NO_ERROR; // See: Table 22-2. Status codes for Master Transmitter Mode
+
+// Queue of transactions driven by the TWI interrupt
+static i2c_transaction_t* volatile i2c_queue[I2C_QUEUE_SIZE];
+static volatile uint8_t i2c_queue_head = 0;
+static volatile uint8_t i2c_queue_count = 0;
+static volatile bool i2c_queue_running = false; // TWI is owned by the interrupt
+static volatile uint8_t i2c_index = 0; // Position in the write/read buffer
+static volatile bool i2c_reading = false; // Read phase of the current transaction
+static volatile bool i2c_bus_held = false; // Last transaction ended without STOP (I2C_FLAG_NO_STOP)
+
+// Transaction of the blocking API, one at a time
+static i2c_transaction_t i2c_sync;
+static uint8_t i2c_sync_byte;
 
 void i2c_init(void) {
     // Calculate the TWBR value (bitrate register) for a given I2C frequency
@@ -20,78 +44,415 @@ void i2c_init(void) {
     i2c_ready = true;
 };
 
-static void i2c_wait(void) {
-    // Wait clear TWINT flag (from 1 to 0)
-    loop_until_bit_is_set(TWCR, TWINT);
-};
+static void i2c_queue_complete(uint8_t error);
 
-bool i2c_start(uint8_t address, i2c_mode_t mode) {
+// Next byte of the write phase, then the read phase or the completion
+static void i2c_write_next(i2c_transaction_t* transaction) {
+    if (i2c_index < transaction->write_length) {
+        const uint8_t* data = transaction->write_buffer;
+        if (!(transaction->flags & I2C_FLAG_WRITE_REPEAT)) {
+            data += i2c_index;
+        }
+        TWDR = transaction->flags & I2C_FLAG_WRITE_P ? pgm_read_byte(data) : *data;
+        i2c_index++;
+        TWCR = I2C_NACK | _BV(TWIE);
+    }
+    else if (transaction->read_length > 0) {
+        // Repeated START for the read phase
+        i2c_index = 0;
+        i2c_reading = true;
+        i2c_profile_start(I2C_TRANSACTION_CALLER(transaction), true);
+        TWCR = I2C_START | _BV(TWIE);
+    }
+    else {
+        i2c_queue_complete(I2C_NO_ERROR);
+    }
+}
+
+// Receive the next byte: ACK every byte but the last one (unless I2C_FLAG_ACK_LAST)
+static void i2c_read_next(const i2c_transaction_t* transaction) {
+    const bool is_last = i2c_index + 1 >= transaction->read_length;
+    TWCR = (is_last && !(transaction->flags & I2C_FLAG_ACK_LAST) ? I2C_NACK : I2C_ACK) | _BV(TWIE);
+}
+
+/**
+ * Start the transaction at the head of the queue
+ * While the bus is held only a transaction with I2C_FLAG_CONTINUE can start.
+ * Must be called with interrupts disabled.
+ * @param is_stopping STOP of the previous transaction followed by START
+ * @return false if there is nothing to start
+*/
+static bool i2c_queue_start(bool is_stopping) {
+    i2c_transaction_t* transaction = i2c_queue[i2c_queue_head];
+    if (i2c_queue_count == 0 || (i2c_bus_held && !(transaction->flags & I2C_FLAG_CONTINUE))) {
+        i2c_queue_running = false;
+        return false;
+    }
+    const bool is_repeated = i2c_bus_held;
+    transaction->status = I2C_TRANSACTION_BUSY;
+    i2c_index = 0;
+    i2c_bus_held = false;
+    i2c_queue_running = true;
+    if (is_repeated && (transaction->flags & I2C_FLAG_NO_START)) {
+        // SCL is held low after the previous byte, the transfer goes on from there
+        i2c_reading = transaction->read_length > 0;
+        if (i2c_reading) {
+            i2c_read_next(transaction);
+        }
+        else {
+            i2c_write_next(transaction);
+        }
+        return true;
+    }
+    i2c_reading = (transaction->flags & I2C_FLAG_READ) || (transaction->write_length == 0 && transaction->read_length > 0);
+    i2c_profile_start(I2C_TRANSACTION_CALLER(transaction), is_repeated);
+    if (is_stopping) {
+        TWCR = I2C_STOP | _BV(TWSTA) | _BV(TWIE);
+    }
+    else {
+        if (!is_repeated) {
+            // Wait for the STOP of the last transaction
+            loop_until_bit_is_clear(TWCR, TWSTO);
+        }
+        TWCR = I2C_START | _BV(TWIE);
+    }
+    return true;
+}
+
+/**
+ * Release the bus after the last step: STOP followed by START of the next transaction
+ * After a bus error the lines are already released (TWSTO without STOP), the next transaction starts anew.
+ * Must be called with interrupts disabled.
+ * @param error TW_STATUS of the failed step or I2C_NO_ERROR
+*/
+static void i2c_queue_release(uint8_t error) {
+    i2c_bus_held = false;
+    if (error == TW_BUS_ERROR) {
+        i2c_queue_start(false);
+    }
+    else if (!i2c_queue_start(true)) {
+        TWCR = I2C_STOP;
+    }
+}
+
+/**
+ * Complete the transaction at the head of the queue and start the next one
+ * @param error TW_STATUS of the failed step or I2C_NO_ERROR
+*/
+static void i2c_queue_complete(uint8_t error) {
+    i2c_transaction_t* transaction = i2c_queue[i2c_queue_head];
+    i2c_queue_head = (i2c_queue_head + 1) % I2C_QUEUE_SIZE;
+    i2c_queue_count--;
+
+    const i2c_caller_t caller = I2C_TRANSACTION_CALLER(transaction);
+    i2c_profile_bytes(caller, i2c_reading ? transaction->write_length : i2c_index, i2c_reading ? i2c_index : 0);
+    if (error != I2C_NO_ERROR) {
+        i2c_profile_error(caller, error);
+    }
+
+    if (error == I2C_NO_ERROR && (transaction->flags & I2C_FLAG_NO_STOP)) {
+        // TWINT stays set and holds SCL low until the next transaction
+        TWCR = _BV(TWEN);
+        i2c_bus_held = true;
+        i2c_queue_start(false);
+    }
+    else {
+        i2c_profile_stop(caller);
+        i2c_queue_release(error);
+    }
+
+    transaction->error = error;
+    transaction->status = error == I2C_NO_ERROR ? I2C_TRANSACTION_DONE : I2C_TRANSACTION_ERROR;
+    if (error != I2C_NO_ERROR) {
+        i2c_error = error;
+    }
+    if (transaction->callback != NULL) {
+        transaction->callback(transaction);
+    }
+}
+
+// State machine of the queued transactions
+ISR(TWI_vect) {
+    i2c_transaction_t* transaction = i2c_queue[i2c_queue_head];
+    const uint8_t status = TW_STATUS;
+
+    switch (status) {
+        case TW_START:
+        case TW_REP_START:
+            TWDR = (transaction->address << 1) | (i2c_reading ? I2C_MODE_READ : I2C_MODE_WRITE); // SLA + (R/W)
+            TWCR = I2C_NACK | _BV(TWIE);
+            break;
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            i2c_write_next(transaction);
+            break;
+        case TW_MR_SLA_ACK:
+            if (transaction->read_length > 0) {
+                i2c_read_next(transaction);
+            }
+            else {
+                i2c_queue_complete(I2C_NO_ERROR); // Address only (I2C_FLAG_READ)
+            }
+            break;
+        case TW_MR_DATA_ACK:
+            transaction->read_buffer[i2c_index++] = TWDR;
+            if (i2c_index < transaction->read_length) {
+                i2c_read_next(transaction);
+            }
+            else {
+                i2c_queue_complete(I2C_NO_ERROR); // I2C_FLAG_ACK_LAST
+            }
+            break;
+        case TW_MR_DATA_NACK:
+            transaction->read_buffer[i2c_index++] = TWDR;
+            i2c_queue_complete(I2C_NO_ERROR);
+            break;
+        case TW_BUS_ERROR:
+            // Illegal START or STOP: TWSTO releases the lines, no STOP is sent
+            TWCR = I2C_STOP;
+            i2c_queue_complete(TW_BUS_ERROR);
+            break;
+        default:
+            i2c_queue_complete(status);
+            break;
+    }
+}
+
+/**
+ * Submit transaction to the queue
+ * The transaction is executed by the TWI interrupt (interrupts must be enabled).
+ * Completion is reported by transaction->status and the optional callback.
+ * A transaction with I2C_FLAG_CONTINUE goes before the queued ones, the last place of the queue
+ * is kept for it: the sequence holding the bus can always go on to its STOP.
+ * @return false if the queue is full or the bus is not initialized
+*/
+bool i2c_submit(i2c_transaction_t* transaction) {
     if (!i2c_ready) {
         return i2c_ready;
     }
-    bool is_ok;
-    // Start condition
-    // Interrupt flag + Start bit + Enable bit
-    TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN);
-    i2c_wait();
-    is_ok = TW_STATUS == TW_START || TW_STATUS == TW_REP_START;
-    if (!is_ok) {
-        i2c_error = TW_STATUS;
-        return is_ok;
-    }
-    // Send Address
-    TWDR = (address << 1) | mode; // SLA + (R/W)
-    TWCR = I2C_NACK;
-    i2c_wait();
-    is_ok = (mode == I2C_MODE_WRITE && TW_STATUS == TW_MT_SLA_ACK) || (mode == I2C_MODE_READ && TW_STATUS == TW_MR_SLA_ACK);
-    if (!is_ok) {
-        i2c_error = TW_STATUS;
+    bool is_ok = false;
+    const uint8_t size = transaction->flags & I2C_FLAG_CONTINUE ? I2C_QUEUE_SIZE : I2C_QUEUE_SIZE - 1;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (i2c_queue_count < size) {
+            transaction->status = I2C_TRANSACTION_QUEUED;
+            transaction->error = I2C_NO_ERROR;
+#ifdef I2C_PROFILE
+            transaction->caller = i2c_profile_get_caller();
+#endif
+            if (transaction->flags & I2C_FLAG_CONTINUE) {
+                i2c_queue_head = (i2c_queue_head + I2C_QUEUE_SIZE - 1) % I2C_QUEUE_SIZE;
+                i2c_queue[i2c_queue_head] = transaction;
+            }
+            else {
+                i2c_queue[(i2c_queue_head + i2c_queue_count) % I2C_QUEUE_SIZE] = transaction;
+            }
+            i2c_queue_count++;
+            if (!i2c_queue_running) {
+                i2c_queue_start(false);
+            }
+            is_ok = true;
+        }
     }
+    i2c_profile_set_caller(I2C_CALLER_OTHER);
     return is_ok;
-};
+}
 
-bool i2c_write_byte(uint8_t data) {
+bool i2c_is_busy(void) {
+    return i2c_queue_count > 0;
+}
+
+/**
+ * Wait until the transaction is complete
+ * The CPU sleeps (idle mode) between TWI interrupts. Interrupts are enabled while waiting,
+ * the caller gets them back as they were.
+ * @return true if the transaction is done without errors
+*/
+bool i2c_wait_transaction(const i2c_transaction_t* transaction) {
+    const uint8_t sreg = SREG;
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (true) {
+        // The status is checked with interrupts disabled, so the completion
+        // can't be missed between the check and the sleep instruction
+        cli();
+        if (transaction->status != I2C_TRANSACTION_QUEUED && transaction->status != I2C_TRANSACTION_BUSY) {
+            break;
+        }
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+    SREG = sreg;
+    return transaction->status == I2C_TRANSACTION_DONE;
+}
+
+/**
+ * Submit transaction and wait until it is complete
+*/
+bool i2c_transfer(i2c_transaction_t* transaction) {
+    return i2c_submit(transaction) && i2c_wait_transaction(transaction);
+}
+
+/**
+ * Step of the blocking API as a transaction on the queue
+ * Every step but i2c_stop() holds the bus for the next one, after an error the bus is released
+ * and the steps up to i2c_stop() fail.
+*/
+static bool i2c_sync_transfer(uint8_t flags, const uint8_t* write_buffer, uint8_t write_length, uint8_t* read_buffer, uint8_t read_length) {
+    if (i2c_bus_held) {
+        flags |= I2C_FLAG_CONTINUE;
+    }
+    else if (flags & I2C_FLAG_NO_START) {
+        return false;
+    }
+    i2c_sync.write_buffer = write_buffer;
+    i2c_sync.write_length = write_length;
+    i2c_sync.read_buffer = read_buffer;
+    i2c_sync.read_length = read_length;
+    i2c_sync.flags = flags;
+    // The caller of the profile stays until i2c_stop()
+    const i2c_caller_t caller = i2c_profile_get_caller();
+    const bool is_ok = i2c_transfer(&i2c_sync);
+    i2c_profile_set_caller(caller);
+    return is_ok;
+}
+
+/**
+ * Single byte step of the blocking API on the held bus
+ * A transaction costs more than the byte: TWINT is polled with the TWI interrupt disabled, the CPU
+ * doesn't sleep and interrupts are left as they are. After an error the bus is released as by a transaction.
+ * TWDR must be written first for a byte to send.
+ * @param control I2C_NACK to send a byte or read the last one, I2C_ACK to read a byte followed by more
+ * @param status TW_STATUS of the successful step
+*/
+static bool i2c_sync_poll(uint8_t control, uint8_t status) {
+    TWCR = control;
+    loop_until_bit_is_set(TWCR, TWINT);
+    const uint8_t result = TW_STATUS;
+    const i2c_caller_t caller = i2c_profile_get_caller();
+    if (result == status) {
+        i2c_profile_bytes(caller, status == TW_MT_DATA_ACK, status != TW_MT_DATA_ACK);
+        return true;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (result == TW_BUS_ERROR) {
+            TWCR = I2C_STOP;
+        }
+        i2c_profile_error(caller, result);
+        i2c_profile_stop(caller);
+        i2c_error = result;
+        i2c_queue_release(result);
+    }
+    return false;
+}
+
+// Bytes of a step in transactions of up to 255 bytes
+static bool i2c_sync_write(const uint8_t* data, uint16_t length, uint8_t flags) {
+    bool is_ok = true;
+    while (is_ok && length > 0) {
+        const uint8_t chunk = length > UINT8_MAX ? UINT8_MAX : length;
+        is_ok = i2c_sync_transfer(I2C_FLAG_NO_START | I2C_FLAG_NO_STOP | flags, data, chunk, NULL, 0);
+        if (!(flags & I2C_FLAG_WRITE_REPEAT)) {
+            data += chunk;
+        }
+        length -= chunk;
+    }
+    return is_ok;
+}
+
+/**
+ * START (or repeated START) and address
+ * The blocking API is a sequence of transactions on the queue (see i2c_sync_transfer()),
+ * the CPU sleeps while they are on the bus. Single bytes are polled (see i2c_sync_poll()).
+ * @param address
+ * @param mode
+*/
+bool i2c_start(uint8_t address, i2c_mode_t mode) {
     if (!i2c_ready) {
         return i2c_ready;
     }
-    TWDR = data;
-    TWCR = I2C_NACK;
-    i2c_wait();
-    bool is_ok = TW_STATUS == TW_MT_DATA_ACK;
-    if (!is_ok) {
-        i2c_error = TW_STATUS;
+    i2c_sync.address = address;
+    return i2c_sync_transfer(I2C_FLAG_NO_STOP | (mode == I2C_MODE_READ ? I2C_FLAG_READ : 0), NULL, 0, NULL, 0);
+};
+
+bool i2c_write_byte(uint8_t data) {
+    if (!i2c_bus_held) {
+        return false;
     }
-    return is_ok;
+    TWDR = data;
+    return i2c_sync_poll(I2C_NACK, TW_MT_DATA_ACK);
 };
 
 bool i2c_read_byte_ACK(uint8_t* byte) {
+    if (!i2c_bus_held || !i2c_sync_poll(I2C_ACK, TW_MR_DATA_ACK)) {
+        return false;
+    }
+    *byte = TWDR;
+    return true;
+}
+
+bool i2c_read_byte_NACK(uint8_t* byte) {
+    if (!i2c_bus_held || !i2c_sync_poll(I2C_NACK, TW_MR_DATA_NACK)) {
+        return false;
+    }
+    *byte = TWDR;
+    return true;
+}
+
+/**
+ * Write bytes
+ * Stops at the first byte that is not acknowledged.
+ * @param data
+ * @param length
+*/
+bool i2c_write_buffer(const uint8_t* data, uint16_t length) {
     if (!i2c_ready) {
         return i2c_ready;
     }
-    TWCR = I2C_ACK;
-    i2c_wait();
-    bool is_ok = TW_STATUS == TW_MR_DATA_ACK;
-    if (is_ok) {
-        *byte = TWDR;
-    }
-    else {
-        i2c_error = TW_STATUS;
+    return i2c_sync_write(data, length, 0);
+}
+
+/**
+ * Write bytes from PROGMEM
+ * @param data (from PROGMEM)
+ * @param length
+*/
+bool i2c_write_buffer_P(const uint8_t* data, uint16_t length) {
+    if (!i2c_ready) {
+        return i2c_ready;
     }
-    return is_ok;
+    return i2c_sync_write(data, length, I2C_FLAG_WRITE_P);
 }
 
-bool i2c_read_byte_NACK(uint8_t* byte) {
+/**
+ * Write the same byte count times
+ * @param data
+ * @param count
+*/
+bool i2c_write_repeat(uint8_t data, uint16_t count) {
     if (!i2c_ready) {
         return i2c_ready;
     }
-    TWCR = I2C_NACK;
-    i2c_wait();
-    bool is_ok = TW_STATUS == TW_MR_DATA_NACK;
-    if (is_ok) {
-        *byte = TWDR;
+    i2c_sync_byte = data;
+    return i2c_sync_write(&i2c_sync_byte, count, I2C_FLAG_WRITE_REPEAT);
+}
+
+/**
+ * Read bytes
+ * Every byte but the last one is acknowledged (ACK), the last one is not (NACK).
+ * @param data
+ * @param length
+*/
+bool i2c_read_buffer(uint8_t* data, uint16_t length) {
+    if (!i2c_ready) {
+        return i2c_ready;
     }
-    else {
-        i2c_error = TW_STATUS;
+    bool is_ok = true;
+    while (is_ok && length > 0) {
+        const uint8_t chunk = length > UINT8_MAX ? UINT8_MAX : length;
+        length -= chunk;
+        is_ok = i2c_sync_transfer(I2C_FLAG_NO_START | I2C_FLAG_NO_STOP | (length > 0 ? I2C_FLAG_ACK_LAST : 0), NULL, 0, data, chunk);
+        data += chunk;
     }
     return is_ok;
 }
@@ -100,10 +461,13 @@ void i2c_stop(void) {
     if (!i2c_ready) {
         return;
     }
-    // Stop condition: Interrupt flag + Stop bit + Enable bit
-    TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN);
+    // STOP, then the transactions queued meanwhile
+    i2c_sync_transfer(I2C_FLAG_NO_START, NULL, 0, NULL, 0);
+    i2c_profile_set_caller(I2C_CALLER_OTHER);
 };
 
 uint8_t i2c_get_error() {
     return i2c_error;
 }
+
+#endif // !NATIVE && !I2C_STUB
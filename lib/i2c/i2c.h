@@ -4,13 +4,22 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "i2c_def.h"
+#include "i2c_profile.h"
 
 void i2c_init(void);
 bool i2c_start(uint8_t address, i2c_mode_t mode);
 bool i2c_write_byte(uint8_t byte);
 bool i2c_read_byte_ACK(uint8_t* byte);
 bool i2c_read_byte_NACK(uint8_t* byte);
+bool i2c_write_buffer(const uint8_t* data, uint16_t length);
+bool i2c_write_buffer_P(const uint8_t* data, uint16_t length);
+bool i2c_write_repeat(uint8_t data, uint16_t count);
+bool i2c_read_buffer(uint8_t* data, uint16_t length);
 void i2c_stop(void);
 uint8_t i2c_get_error();
+bool i2c_submit(i2c_transaction_t* transaction);
+bool i2c_is_busy(void);
+bool i2c_wait_transaction(const i2c_transaction_t* transaction);
+bool i2c_transfer(i2c_transaction_t* transaction);
 
 #endif // I2C_H
\ No newline at end of file
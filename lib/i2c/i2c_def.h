@@ -4,9 +4,63 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#define I2C_QUEUE_SIZE 8 // Max queued transactions
+#define I2C_NO_ERROR 0xFF // Error of a transaction without errors, TW_STATUS has the low 3 bits cleared (TW_BUS_ERROR is 0)
+
 typedef enum {
     I2C_MODE_WRITE = 0,
     I2C_MODE_READ = 1,
 } i2c_mode_t;
 
-#endif // I2C_DEF_H
\ No newline at end of file
+typedef enum {
+    I2C_TRANSACTION_IDLE = 0, // Not submitted
+    I2C_TRANSACTION_QUEUED = 1,
+    I2C_TRANSACTION_BUSY = 2,
+    I2C_TRANSACTION_DONE = 3,
+    I2C_TRANSACTION_ERROR = 4, // See error
+} i2c_transaction_status_t;
+
+// Owner of the bus time in the profile, see i2c_profile.h
+typedef enum {
+    I2C_CALLER_OTHER = 0,
+    I2C_CALLER_SSD1306_COMMAND = 1,
+    I2C_CALLER_SSD1306_DATA = 2,
+    I2C_CALLER_BMP180 = 3,
+    I2C_CALLER_COUNT
+} i2c_caller_t;
+
+// Flags of a transaction, the blocking API (i2c_start() ... i2c_stop()) is a sequence of transactions holding the bus
+#define I2C_FLAG_NO_STOP (1 << 0) // Hold the bus after the last byte for a transaction with I2C_FLAG_CONTINUE
+#define I2C_FLAG_CONTINUE (1 << 1) // Continue on the held bus, goes before the queued transactions
+#define I2C_FLAG_NO_START (1 << 2) // With I2C_FLAG_CONTINUE: no repeated START and address, the bytes follow the previous ones
+#define I2C_FLAG_READ (1 << 3) // Address for reading without read bytes (the next transaction reads)
+#define I2C_FLAG_ACK_LAST (1 << 4) // Acknowledge the last read byte, the next transaction reads more
+#define I2C_FLAG_WRITE_P (1 << 5) // write_buffer is in PROGMEM
+#define I2C_FLAG_WRITE_REPEAT (1 << 6) // write_buffer[0] is written write_length times
+
+typedef struct i2c_transaction i2c_transaction_t;
+
+// Called from the TWI interrupt when the transaction is complete
+typedef void (*i2c_callback_t)(i2c_transaction_t* transaction);
+
+/**
+ * Transaction: START, write buffer, (repeated START, read buffer), STOP
+ * The buffers must stay valid until the transaction is complete.
+*/
+struct i2c_transaction {
+    uint8_t address;
+    const uint8_t* write_buffer;
+    uint8_t write_length; // 0 = read only
+    uint8_t* read_buffer;
+    uint8_t read_length; // 0 = write only
+    uint8_t flags; // I2C_FLAG_*, 0 = the whole transaction from START to STOP
+    i2c_callback_t callback; // Optional
+    void* context; // Data for callback
+    volatile i2c_transaction_status_t status;
+    volatile uint8_t error; // TW_STATUS of the failed step or I2C_NO_ERROR
+#ifdef I2C_PROFILE
+    i2c_caller_t caller; // Set by i2c_submit()
+#endif
+};
+
+#endif // I2C_DEF_H
@@ -0,0 +1,66 @@
+/**
+ * Native backend of the I2C bus
+ * The firmware runs i2c.c on the simulated TWI of native/src/native.c, which moves the bytes
+ * between the TWI registers and the devices attached by i2c_native_attach().
+*/
+
+#ifdef NATIVE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "i2c_def.h"
+#include "i2c_native.h"
+
+static i2c_device_t* i2c_devices[I2C_NATIVE_MAX_DEVICES];
+static uint8_t i2c_device_count = 0;
+static i2c_device_t* i2c_device = NULL; // Addressed device, NULL = no device acknowledged
+
+/**
+ * Attach device to the bus
+ * @param device Must stay valid, its address must be unique
+ * @return false if there are too many devices
+*/
+bool i2c_native_attach(i2c_device_t* device) {
+    if (i2c_device_count >= I2C_NATIVE_MAX_DEVICES) {
+        return false;
+    }
+    i2c_devices[i2c_device_count++] = device;
+    return true;
+}
+
+/**
+ * Address byte after START or repeated START
+ * @return true if a device acknowledged
+*/
+bool i2c_native_start(uint8_t address, i2c_mode_t mode) {
+    i2c_device = NULL;
+    for (uint8_t i = 0; i < i2c_device_count; i++) {
+        if (i2c_devices[i]->address == address) {
+            i2c_device = i2c_devices[i];
+        }
+    }
+    if (i2c_device != NULL && !i2c_device->start(i2c_device->context, mode)) {
+        i2c_device = NULL;
+    }
+    return i2c_device != NULL;
+}
+
+// Returns true if the byte is acknowledged
+bool i2c_native_write(uint8_t byte) {
+    return i2c_device != NULL && i2c_device->write(i2c_device->context, byte);
+}
+
+// ack = the master acknowledges the byte and wants more
+uint8_t i2c_native_read(bool ack) {
+    return i2c_device != NULL ? i2c_device->read(i2c_device->context, ack) : 0xFF; // Released bus
+}
+
+void i2c_native_stop(void) {
+    if (i2c_device != NULL) {
+        i2c_device->stop(i2c_device->context);
+        i2c_device = NULL;
+    }
+}
+
+#endif // NATIVE
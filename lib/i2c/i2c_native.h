@@ -0,0 +1,35 @@
+/**
+ * Native backend of the I2C bus
+ * Devices simulated on the host are attached to the bus behind the simulated TWI.
+*/
+
+#ifndef I2C_NATIVE_H
+#define I2C_NATIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "i2c_def.h"
+
+#define I2C_NATIVE_MAX_DEVICES 8
+
+/**
+ * Device on the bus, called in bus order: start, write or read bytes, (repeated start...), stop
+*/
+typedef struct {
+    uint8_t address;
+    bool (*start)(void* context, i2c_mode_t mode); // false = address is not acknowledged
+    bool (*write)(void* context, uint8_t byte); // false = byte is not acknowledged
+    uint8_t (*read)(void* context, bool ack); // ack = master wants more bytes
+    void (*stop)(void* context);
+    void* context;
+} i2c_device_t;
+
+bool i2c_native_attach(i2c_device_t* device);
+
+// Bus conditions for the simulated TWI
+bool i2c_native_start(uint8_t address, i2c_mode_t mode);
+bool i2c_native_write(uint8_t byte);
+uint8_t i2c_native_read(bool ack);
+void i2c_native_stop(void);
+
+#endif // I2C_NATIVE_H
@@ -0,0 +1,143 @@
+/**
+ * Profile of the I2C bus
+ * The bus time is read from Timer1, which runs all the time the CPU is awake (see lib/power).
+ * One transaction is on the bus at a time: queued transactions wait for the blocking one and back.
+ * The resolution is one tick of Timer1: lib/power runs it at F_CPU / 8 in I2C_PROFILE builds (8 cycles, 0.5 us),
+ * a transaction must be shorter than 65536 ticks (32.8 ms).
+*/
+
+#ifdef I2C_PROFILE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "i2c_def.h"
+#include "i2c_profile.h"
+
+static i2c_profile_t i2c_profile;
+static i2c_caller_t i2c_caller = I2C_CALLER_OTHER; // Caller of the next blocking transaction
+static uint16_t i2c_start_ticks; // TCNT1 at the START of the transaction
+
+#define I2C_PROFILE_NAME_LENGTH 9
+
+static const char caller_names[I2C_CALLER_COUNT][I2C_PROFILE_NAME_LENGTH] PROGMEM = {
+    "other",
+    "ssd1306c", // Commands
+    "ssd1306d", // Display data
+    "bmp180",
+};
+
+// Cycles per tick of Timer1 by the clock select bits, 0 = stopped
+static uint16_t i2c_profile_get_prescaler(void) {
+    static const uint16_t prescalers[] PROGMEM = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+    return pgm_read_word(&prescalers[TCCR1B & 0x07]);
+}
+
+/**
+ * Set caller of the following blocking transactions
+ * It is reset to I2C_CALLER_OTHER by i2c_stop() and i2c_submit().
+ * @param caller
+*/
+void i2c_profile_set_caller(i2c_caller_t caller) {
+    i2c_caller = caller < I2C_CALLER_COUNT ? caller : I2C_CALLER_OTHER;
+}
+
+i2c_caller_t i2c_profile_get_caller(void) {
+    return i2c_caller;
+}
+
+/**
+ * Copy the profile
+ * The counters are updated by TWI_vect, they are copied with interrupts disabled so no value is half-updated.
+ * @param profile
+*/
+void i2c_profile_get(i2c_profile_t* profile) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        memcpy(profile, &i2c_profile, sizeof(i2c_profile_t));
+    }
+}
+
+void i2c_profile_reset(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        memset(&i2c_profile, 0, sizeof(i2c_profile_t));
+    }
+}
+
+void i2c_profile_start(i2c_caller_t caller, bool is_repeated) {
+    i2c_profile_counters_t* counters = &i2c_profile.callers[caller];
+    if (is_repeated) {
+        counters->repeated_starts++;
+        return;
+    }
+    counters->starts++;
+    i2c_start_ticks = TCNT1;
+}
+
+void i2c_profile_bytes(i2c_caller_t caller, uint16_t written, uint16_t read) {
+    i2c_profile.callers[caller].bytes_written += written;
+    i2c_profile.callers[caller].bytes_read += read;
+}
+
+void i2c_profile_error(i2c_caller_t caller, uint8_t status) {
+    i2c_profile.callers[caller].errors++;
+    i2c_profile.errors[(status >> 3) % I2C_PROFILE_STATUS_COUNT]++;
+}
+
+void i2c_profile_stop(i2c_caller_t caller) {
+    i2c_profile_counters_t* counters = &i2c_profile.callers[caller];
+    const uint32_t cycles = (uint32_t)(uint16_t)(TCNT1 - i2c_start_ticks) * i2c_profile_get_prescaler();
+    counters->stops++;
+    counters->transactions++;
+    counters->cycles += cycles;
+    if (cycles > counters->max_cycles) {
+        counters->max_cycles = cycles;
+    }
+}
+
+/**
+ * Format line of the profile for serial output
+ * Every caller has two lines: "I2C <caller> T <transactions> <starts> <repeated starts> <stops> <errors>"
+ * and "I2C <caller> B <bytes written> <bytes read> <cycles> <max cycles>", the last line
+ * is "I2C E <TW_STATUS>:<count>..." with the errors by status.
+ * @param profile Copy from i2c_profile_get(), the same copy for all lines
+ * @param line Index of the line from 0
+ * @param text
+ * @param size At least I2C_PROFILE_LINE_LENGTH
+ * @return Length of the line, 0 after the last line
+*/
+uint8_t i2c_profile_format(const i2c_profile_t* profile, uint8_t line, char* text, uint8_t size) {
+    const uint8_t caller = line / 2;
+    int length;
+    if (caller < I2C_CALLER_COUNT) {
+        const i2c_profile_counters_t* counters = &profile->callers[caller];
+        char name[I2C_PROFILE_NAME_LENGTH];
+        strcpy_P(name, caller_names[caller]);
+        if (line % 2 == 0) {
+            length = snprintf_P(text, size, PSTR("I2C %s T %u %u %u %u %u\r\n"), name, counters->transactions,
+                counters->starts, counters->repeated_starts, counters->stops, counters->errors);
+        }
+        else {
+            length = snprintf_P(text, size, PSTR("I2C %s B %lu %lu %lu %lu\r\n"), name, (unsigned long)counters->bytes_written,
+                (unsigned long)counters->bytes_read, (unsigned long)counters->cycles, (unsigned long)counters->max_cycles);
+        }
+    }
+    else if (caller == I2C_CALLER_COUNT && line % 2 == 0) {
+        length = snprintf_P(text, size, PSTR("I2C E"));
+        for (uint8_t i = 0; i < I2C_PROFILE_STATUS_COUNT && length + 12 < size; i++) {
+            if (profile->errors[i] != 0) {
+                length += snprintf_P(text + length, size - length, PSTR(" %02X:%u"), i << 3, profile->errors[i]);
+            }
+        }
+        length += snprintf_P(text + length, size - length, PSTR("\r\n"));
+    }
+    else {
+        return 0;
+    }
+    return length < size ? length : size - 1;
+}
+
+#endif // I2C_PROFILE
@@ -0,0 +1,66 @@
+/**
+ * Profile of the I2C bus
+ * Built with I2C_PROFILE, the bus driver counts conditions, bytes, errors and the bus time
+ * of every transaction for the caller set by i2c_profile_set_caller(). Without I2C_PROFILE
+ * the hooks are empty and compile to nothing.
+*/
+
+#ifndef I2C_PROFILE_H
+#define I2C_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "i2c_def.h"
+
+#define I2C_PROFILE_STATUS_COUNT 32 // Errors by TW_STATUS >> 3
+#define I2C_PROFILE_LINE_LENGTH 64
+
+typedef struct {
+    uint16_t transactions;
+    uint16_t starts;
+    uint16_t repeated_starts;
+    uint16_t stops;
+    uint16_t errors;
+    uint32_t bytes_written;
+    uint32_t bytes_read;
+    // Time of the transactions (in CPU cycles), Timer1 ticks times its prescaler: lib/power runs Timer1 at F_CPU / 8
+    // in I2C_PROFILE builds, 8 cycles (0.5 us) of resolution, transactions up to 32.8 ms (a whole display is 23 ms)
+    uint32_t cycles;
+    uint32_t max_cycles; // Longest transaction
+} i2c_profile_counters_t;
+
+typedef struct {
+    i2c_profile_counters_t callers[I2C_CALLER_COUNT];
+    uint16_t errors[I2C_PROFILE_STATUS_COUNT];
+} i2c_profile_t;
+
+#ifdef I2C_PROFILE
+
+#define I2C_TRANSACTION_CALLER(transaction) ((transaction)->caller)
+
+void i2c_profile_set_caller(i2c_caller_t caller);
+i2c_caller_t i2c_profile_get_caller(void);
+void i2c_profile_get(i2c_profile_t* profile);
+void i2c_profile_reset(void);
+uint8_t i2c_profile_format(const i2c_profile_t* profile, uint8_t line, char* text, uint8_t size);
+
+// Hooks of the bus driver
+void i2c_profile_start(i2c_caller_t caller, bool is_repeated);
+void i2c_profile_bytes(i2c_caller_t caller, uint16_t written, uint16_t read);
+void i2c_profile_error(i2c_caller_t caller, uint8_t status);
+void i2c_profile_stop(i2c_caller_t caller);
+
+#else
+
+#define I2C_TRANSACTION_CALLER(transaction) I2C_CALLER_OTHER
+
+static inline void i2c_profile_set_caller(i2c_caller_t caller) {}
+static inline i2c_caller_t i2c_profile_get_caller(void) { return I2C_CALLER_OTHER; }
+static inline void i2c_profile_start(i2c_caller_t caller, bool is_repeated) {}
+static inline void i2c_profile_bytes(i2c_caller_t caller, uint16_t written, uint16_t read) {}
+static inline void i2c_profile_error(i2c_caller_t caller, uint8_t status) {}
+static inline void i2c_profile_stop(i2c_caller_t caller) {}
+
+#endif // I2C_PROFILE
+
+#endif // I2C_PROFILE_H
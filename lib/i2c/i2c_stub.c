@@ -0,0 +1,139 @@
+/**
+ * Stub backend of the I2C bus for the benchmarks
+ * Implements i2c.h without TWI: the bus takes no time and never fails.
+*/
+
+#ifdef I2C_STUB
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include "i2c_def.h"
+#include "i2c.h"
+#include "i2c_stub.h"
+
+static const uint8_t* i2c_read_data = NULL;
+static uint8_t i2c_read_length = 0;
+static uint8_t i2c_read_index = 0;
+static uint32_t i2c_bytes = 0; // Address and data bytes
+
+/**
+ * Set bytes returned by reads
+ * Reads start from the first byte after every START and repeat the buffer, 0xFF without data.
+ * @param data Must stay valid
+ * @param length
+*/
+void i2c_stub_set_read_data(const uint8_t* data, uint8_t length) {
+    i2c_read_data = data;
+    i2c_read_length = length;
+    i2c_read_index = 0;
+}
+
+/**
+ * Get bytes sent on the bus since i2c_stub_reset_bytes() (addresses included)
+*/
+uint32_t i2c_stub_get_bytes(void) {
+    return i2c_bytes;
+}
+
+void i2c_stub_reset_bytes(void) {
+    i2c_bytes = 0;
+}
+
+void i2c_init(void) {}
+
+bool i2c_start(uint8_t address, i2c_mode_t mode) {
+    (void)address;
+    (void)mode;
+    i2c_read_index = 0;
+    i2c_bytes++;
+    return true;
+}
+
+bool i2c_write_byte(uint8_t byte) {
+    (void)byte;
+    i2c_bytes++;
+    return true;
+}
+
+static bool i2c_read_byte(uint8_t* byte) {
+    *byte = i2c_read_length > 0 ? i2c_read_data[i2c_read_index++ % i2c_read_length] : 0xFF;
+    i2c_bytes++;
+    return true;
+}
+
+bool i2c_read_byte_ACK(uint8_t* byte) {
+    return i2c_read_byte(byte);
+}
+
+bool i2c_read_byte_NACK(uint8_t* byte) {
+    return i2c_read_byte(byte);
+}
+
+bool i2c_write_buffer(const uint8_t* data, uint16_t length) {
+    (void)data;
+    i2c_bytes += length;
+    return true;
+}
+
+bool i2c_write_buffer_P(const uint8_t* data, uint16_t length) {
+    bool is_ok = true;
+    while (is_ok && length--) {
+        is_ok = i2c_write_byte(pgm_read_byte(data++)); // Same flash reads as the real driver
+    }
+    return is_ok;
+}
+
+bool i2c_write_repeat(uint8_t data, uint16_t count) {
+    (void)data;
+    i2c_bytes += count;
+    return true;
+}
+
+bool i2c_read_buffer(uint8_t* data, uint16_t length) {
+    while (length--) {
+        i2c_read_byte(data++);
+    }
+    return true;
+}
+
+void i2c_stop(void) {}
+
+uint8_t i2c_get_error() {
+    return I2C_NO_ERROR;
+}
+
+bool i2c_submit(i2c_transaction_t* transaction) {
+    // Executed at once as by an idle bus with an instant interrupt
+    transaction->error = I2C_NO_ERROR;
+    transaction->status = I2C_TRANSACTION_BUSY;
+    i2c_start(transaction->address, transaction->write_length > 0 ? I2C_MODE_WRITE : I2C_MODE_READ);
+    i2c_write_buffer(transaction->write_buffer, transaction->write_length);
+    if (transaction->read_length > 0) {
+        if (transaction->write_length > 0) {
+            i2c_start(transaction->address, I2C_MODE_READ);
+        }
+        i2c_read_buffer(transaction->read_buffer, transaction->read_length);
+    }
+    transaction->status = I2C_TRANSACTION_DONE;
+    if (transaction->callback != NULL) {
+        transaction->callback(transaction);
+    }
+    i2c_profile_set_caller(I2C_CALLER_OTHER);
+    return true;
+}
+
+bool i2c_is_busy(void) {
+    return false;
+}
+
+bool i2c_wait_transaction(const i2c_transaction_t* transaction) {
+    return transaction->status == I2C_TRANSACTION_DONE;
+}
+
+bool i2c_transfer(i2c_transaction_t* transaction) {
+    return i2c_submit(transaction) && i2c_wait_transaction(transaction);
+}
+
+#endif // I2C_STUB
@@ -0,0 +1,16 @@
+/**
+ * Stub backend of the I2C bus for the benchmarks
+ * Every address and byte is acknowledged at once, so only the CPU time of the drivers is measured.
+ * Bytes on the bus are counted, read bytes are taken from the buffer set by i2c_stub_set_read_data().
+*/
+
+#ifndef I2C_STUB_H
+#define I2C_STUB_H
+
+#include <stdint.h>
+
+void i2c_stub_set_read_data(const uint8_t* data, uint8_t length);
+uint32_t i2c_stub_get_bytes(void);
+void i2c_stub_reset_bytes(void);
+
+#endif // I2C_STUB_H
@@ -0,0 +1,198 @@
+/**
+ * C Library for power-down sleep between measurements
+ *
+ * The MCU sleeps in power-down and is woken by the watchdog. The watchdog oscillator is only
+ * accurate to about 10 %, so its tick is calibrated against Timer1 running from the crystal.
+ * Timer1 also measures the active time of every period. Timer2 is not used: it keeps running in
+ * power-save only with a 32 kHz watch crystal, which the board does not have.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include "bitwise.h"
+#include "power.h"
+
+#define POWER_MAX_PRESCALER WDTO_8S // 512 ticks
+#define POWER_CALIBRATION_PRESCALER WDTO_1S // 64 ticks
+#define POWER_WAKEUP_US 1000 // Crystal start-up after power-down, 16K CK at 16 MHz
+#define POWER_CYCLES_PER_US (F_CPU / 1000000UL)
+#ifdef I2C_PROFILE
+// Timer1 also times the I2C transactions (lib/i2c/i2c_profile.c): 0.5 us ticks, overflows every 32.8 ms
+#define POWER_TIMER_PRESCALER 8
+#define POWER_TIMER_CLOCK _BV(CS11)
+#else
+#define POWER_TIMER_PRESCALER 256 // 16 us ticks, overflows every 1.05 s
+#define POWER_TIMER_CLOCK _BV(CS12)
+#endif
+
+static volatile bool is_watchdog_fired;
+static volatile uint16_t timer_overflows;
+
+ISR(WDT_vect) {
+    is_watchdog_fired = true;
+}
+
+ISR(TIMER1_OVF_vect) {
+    timer_overflows++;
+}
+
+// Watchdog in interrupt mode, the period is 2^prescaler ticks
+static void power_start_watchdog(uint8_t prescaler) {
+    const uint8_t config = _BV(WDIE) | (prescaler & 0x08 ? _BV(WDP3) : 0) | (prescaler & 0x07);
+    cli();
+    wdt_reset();
+    clear_bit(MCUSR, WDRF);
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = config;
+    is_watchdog_fired = false;
+    sei();
+}
+
+static void power_wait_watchdog(uint8_t sleep_mode) {
+    set_sleep_mode(sleep_mode);
+    while (!is_watchdog_fired) {
+        cli();
+        if (!is_watchdog_fired) {
+            sleep_enable();
+#if defined(BODS) && defined(BODSE)
+            sleep_bod_disable(); // Brown-out detector is off while sleeping
+#endif
+            sei();
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+    wdt_disable();
+}
+
+// Timer1 at F_CPU / POWER_TIMER_PRESCALER measures the active time
+static void power_start_timer(void) {
+    TCCR1A = 0;
+    TCCR1B = 0;
+    TCNT1 = 0;
+    timer_overflows = 0;
+    set_bit(TIFR1, TOV1);
+    set_bit(TIMSK1, TOIE1);
+    TCCR1B = POWER_TIMER_CLOCK;
+}
+
+static uint32_t power_stop_timer(void) {
+    TCCR1B = 0;
+    clear_bit(TIMSK1, TOIE1);
+    uint32_t ticks = ((uint32_t)timer_overflows << 16) | TCNT1;
+    if (bit_is_set(TIFR1, TOV1)) {
+        ticks += 1UL << 16;
+    }
+    return ticks * POWER_TIMER_PRESCALER / POWER_CYCLES_PER_US;
+}
+
+/**
+ * Init power
+ * Disables unused ADC and analog comparator, calibrates the watchdog and starts measuring the active time.
+ * @param power
+*/
+void power_init(power_t* power) {
+    memset(power, 0, sizeof(power_t));
+    clear_bit(ADCSRA, ADEN);
+    set_bit(ACSR, ACD);
+    power_calibrate(power);
+    power_start_timer();
+}
+
+/**
+ * Calibrate watchdog
+ * Measures one 1 s watchdog period with Timer1 at F_CPU / 1024, the CPU waits in idle mode.
+ * Stops measuring the active time.
+ * @param power
+*/
+void power_calibrate(power_t* power) {
+    TCCR1B = 0;
+    clear_bit(TIMSK1, TOIE1);
+    TCCR1A = 0;
+    power_start_watchdog(POWER_CALIBRATION_PRESCALER);
+    TCNT1 = 0;
+    TCCR1B = _BV(CS12) | _BV(CS10);
+    power_wait_watchdog(SLEEP_MODE_IDLE);
+    const uint32_t period_us = (uint32_t)TCNT1 * 1024 / POWER_CYCLES_PER_US;
+    TCCR1B = 0;
+
+    power->tick_us = period_us >> POWER_CALIBRATION_PRESCALER;
+    power->calibration_age_ms = 0;
+}
+
+// Sleeps at most the duration with the longest watchdog periods first, returns the elapsed time
+static uint32_t power_sleep_for(power_t* power, int32_t duration_us) {
+    uint32_t elapsed_us = 0;
+
+    // Calibration takes one 1 s watchdog period, it must fit into the duration
+    const int32_t calibration_us = (int32_t)power->tick_us << POWER_CALIBRATION_PRESCALER;
+    if (power->calibration_age_ms >= POWER_CALIBRATION_INTERVAL_MS && duration_us > calibration_us + calibration_us / 8) {
+        power_calibrate(power);
+        elapsed_us = (uint32_t)power->tick_us << POWER_CALIBRATION_PRESCALER;
+        power->active_us += elapsed_us;
+    }
+
+    int32_t remaining_us = duration_us - (int32_t)elapsed_us;
+    uint8_t prescaler = POWER_MAX_PRESCALER;
+    while (remaining_us >= (int32_t)power->tick_us + POWER_WAKEUP_US) {
+        const int32_t sleep_us = ((int32_t)power->tick_us << prescaler) + POWER_WAKEUP_US;
+        if (sleep_us > remaining_us) {
+            prescaler--;
+            continue;
+        }
+        power_start_watchdog(prescaler);
+        power_wait_watchdog(SLEEP_MODE_PWR_DOWN);
+        remaining_us -= sleep_us;
+        power->sleep_us += sleep_us;
+        elapsed_us += sleep_us;
+    }
+    power->calibration_age_ms += elapsed_us / 1000;
+    return elapsed_us;
+}
+
+/**
+ * Sleep in power-down
+ * Sleeps whole watchdog periods that fit into the duration, the caller keeps the rest of the time.
+ * The statistics are accumulated.
+ * @param power
+ * @param duration_us
+ * @return Elapsed time (in us)
+*/
+uint32_t power_down(power_t* power, uint32_t duration_us) {
+    power->active_us += power_stop_timer();
+    const uint32_t elapsed_us = power_sleep_for(power, duration_us > INT32_MAX ? INT32_MAX : (int32_t)duration_us);
+    power_start_timer();
+    return elapsed_us;
+}
+
+/**
+ * Get average current (in uA)
+ * Estimated from the active and sleep time and POWER_ACTIVE_UA, POWER_SLEEP_UA.
+ * @param power
+*/
+uint16_t power_get_average_current(const power_t* power) {
+    const uint32_t active_ms = power->active_us / 1000;
+    const uint32_t sleep_ms = power->sleep_us / 1000;
+    if (active_ms + sleep_ms == 0) {
+        return POWER_ACTIVE_UA;
+    }
+    return (active_ms * POWER_ACTIVE_UA + sleep_ms * POWER_SLEEP_UA) / (active_ms + sleep_ms);
+}
+
+/**
+ * Reset active and sleep time
+ * @param power
+*/
+void power_reset_statistics(power_t* power) {
+    power->active_us = 0;
+    power->sleep_us = 0;
+    power_start_timer();
+}
@@ -0,0 +1,34 @@
+/**
+ * C Library for power-down sleep between measurements
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef POWER_ACTIVE_UA
+#define POWER_ACTIVE_UA 10000 // Current of active MCU and sensors at 16 MHz, 5 V (in uA)
+#endif
+#ifndef POWER_SLEEP_UA
+#define POWER_SLEEP_UA 10 // Current in power-down with watchdog, BMP180 in standby (in uA)
+#endif
+#define POWER_CALIBRATION_INTERVAL_MS 3600000UL // Time between watchdog calibrations (temperature drift)
+
+typedef struct {
+    uint16_t tick_us; // Measured duration of the nominal 16 ms watchdog tick
+    uint32_t calibration_age_ms; // Time since the last calibration
+    uint32_t active_us; // Active time since the statistics were reset
+    uint32_t sleep_us; // Sleep time since the statistics were reset
+} power_t;
+
+void power_init(power_t* power);
+void power_calibrate(power_t* power);
+uint32_t power_down(power_t* power, uint32_t duration_us);
+uint16_t power_get_average_current(const power_t* power);
+void power_reset_statistics(power_t* power);
+
+#endif // POWER_H
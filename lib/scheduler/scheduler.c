@@ -0,0 +1,227 @@
+/**
+ * C Library for cooperative task scheduler
+ *
+ * Timer0 gives a 1 ms tick. Ready tasks run to completion, the one with the earliest deadline first.
+ * When nothing is ready the CPU sleeps: in idle mode until the next tick for short waits,
+ * in power-down with the watchdog for long ones, the slept time is then added to the tick.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "bitwise.h"
+#include "power.h"
+#include "scheduler.h"
+
+#define SCHEDULER_TIMER_PRESCALER 64
+#define SCHEDULER_TIMER_TOP (F_CPU / SCHEDULER_TIMER_PRESCALER / 1000 - 1) // 1 ms
+
+static volatile uint32_t scheduler_ticks;
+
+ISR(TIMER0_COMPA_vect) {
+    scheduler_ticks++;
+}
+
+static bool scheduler_is_before(uint32_t time, uint32_t other) {
+    return (int32_t)(time - other) < 0;
+}
+
+/**
+ * Init scheduler
+ * Starts the 1 ms tick on Timer0.
+ * @param scheduler
+ * @param power Initialized power for sleeping in power-down (NULL = only idle mode)
+*/
+void scheduler_init(scheduler_t* scheduler, power_t* power) {
+    memset(scheduler, 0, sizeof(scheduler_t));
+    scheduler->power = power;
+
+    TCCR0A = _BV(WGM01); // CTC
+    TCCR0B = _BV(CS01) | _BV(CS00); // F_CPU / 64
+    OCR0A = SCHEDULER_TIMER_TOP;
+    set_bit(TIMSK0, OCIE0A);
+    sei();
+}
+
+/**
+ * Set check of peripherals that stop in power-down
+ * While it returns true, the CPU waits in idle mode, e.g. until UART sends its buffer.
+ * @param scheduler
+ * @param is_busy
+*/
+void scheduler_set_busy(scheduler_t* scheduler, scheduler_busy_t is_busy) {
+    scheduler->is_busy = is_busy;
+}
+
+/**
+ * Get time since the scheduler was started (in ms)
+*/
+uint32_t scheduler_get_time(void) {
+    uint32_t time;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        time = scheduler_ticks;
+    }
+    return time;
+}
+
+static uint8_t scheduler_add(scheduler_t* scheduler, scheduler_callback_t callback, void* context, uint32_t delay_ms, uint32_t period_ms, uint32_t deadline_ms) {
+    for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        scheduler_task_t* task = &scheduler->tasks[i];
+        if (task->callback == NULL) {
+            task->callback = callback;
+            task->context = context;
+            task->release_ms = scheduler_get_time() + delay_ms;
+            task->period_ms = period_ms;
+            task->deadline_ms = deadline_ms;
+            task->runs = 0;
+            task->misses = 0;
+            return i;
+        }
+    }
+    return SCHEDULER_NO_TASK;
+}
+
+/**
+ * Add periodic task
+ * The first run is right away, the next ones are one period apart from the previous release.
+ * @param scheduler
+ * @param callback
+ * @param context Passed to the callback
+ * @param period_ms
+ * @param deadline_ms Time after the release when the task must be started
+ * @return Task id or SCHEDULER_NO_TASK
+*/
+uint8_t scheduler_add_periodic(scheduler_t* scheduler, scheduler_callback_t callback, void* context, uint32_t period_ms, uint32_t deadline_ms) {
+    return scheduler_add(scheduler, callback, context, 0, period_ms == 0 ? 1 : period_ms, deadline_ms);
+}
+
+/**
+ * Add one-shot task
+ * The task is removed after it runs.
+ * @param scheduler
+ * @param callback
+ * @param context Passed to the callback
+ * @param delay_ms
+ * @param deadline_ms Time after the release when the task must be started
+ * @return Task id or SCHEDULER_NO_TASK
+*/
+uint8_t scheduler_add_once(scheduler_t* scheduler, scheduler_callback_t callback, void* context, uint32_t delay_ms, uint32_t deadline_ms) {
+    return scheduler_add(scheduler, callback, context, delay_ms, 0, deadline_ms);
+}
+
+void scheduler_cancel(scheduler_t* scheduler, uint8_t task) {
+    if (task < SCHEDULER_MAX_TASKS) {
+        scheduler->tasks[task].callback = NULL;
+    }
+}
+
+const scheduler_task_t* scheduler_get_task(const scheduler_t* scheduler, uint8_t task) {
+    return task < SCHEDULER_MAX_TASKS ? &scheduler->tasks[task] : NULL;
+}
+
+/**
+ * Run ready tasks
+ * Tasks run in order of their deadlines, a task added by a running task waits for the next call.
+ * @param scheduler
+ * @return true if any task was run
+*/
+bool scheduler_run_ready(scheduler_t* scheduler) {
+    const uint32_t now = scheduler_get_time();
+    uint8_t ready[SCHEDULER_MAX_TASKS];
+    uint8_t count = 0;
+
+    // Run-queue sorted by the absolute deadline
+    for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        const scheduler_task_t* task = &scheduler->tasks[i];
+        if (task->callback == NULL || scheduler_is_before(now, task->release_ms)) {
+            continue;
+        }
+        const uint32_t deadline = task->release_ms + task->deadline_ms;
+        uint8_t j = count++;
+        while (j > 0 && scheduler_is_before(deadline, scheduler->tasks[ready[j - 1]].release_ms + scheduler->tasks[ready[j - 1]].deadline_ms)) {
+            ready[j] = ready[j - 1];
+            j--;
+        }
+        ready[j] = i;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        scheduler_task_t* task = &scheduler->tasks[ready[i]];
+        if (task->callback == NULL) {
+            continue; // Cancelled by a previous task
+        }
+        const scheduler_callback_t callback = task->callback;
+        void* context = task->context;
+
+        if (scheduler_is_before(task->release_ms + task->deadline_ms, scheduler_get_time())) {
+            task->misses++;
+        }
+        task->runs++;
+        if (task->period_ms == 0) {
+            task->callback = NULL;
+        }
+        else {
+            // Next release keeps the rate, releases missed by a long stall are skipped
+            task->release_ms += task->period_ms;
+            if (scheduler_is_before(task->release_ms, now)) {
+                task->release_ms = now;
+            }
+        }
+        callback(context);
+    }
+    return count > 0;
+}
+
+/**
+ * Sleep until the next task is ready
+ * @param scheduler
+*/
+void scheduler_sleep(scheduler_t* scheduler) {
+    const uint32_t now = scheduler_get_time();
+    bool has_task = false;
+    uint32_t release = 0;
+    for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        const scheduler_task_t* task = &scheduler->tasks[i];
+        if (task->callback != NULL && (!has_task || scheduler_is_before(task->release_ms, release))) {
+            has_task = true;
+            release = task->release_ms;
+        }
+    }
+    if (has_task && !scheduler_is_before(now, release)) {
+        return;
+    }
+
+    const uint32_t wait_ms = release - now;
+    const bool is_busy = scheduler->is_busy != NULL && scheduler->is_busy();
+    if (scheduler->power != NULL && !is_busy && (!has_task || wait_ms > SCHEDULER_POWER_DOWN_MS)) {
+        // Timer0 stops in power-down, the tick is moved by the slept time
+        const uint32_t wait_us = has_task ? (wait_ms - 1) * 1000 : UINT32_MAX;
+        scheduler->carry_us += power_down(scheduler->power, wait_us - scheduler->carry_us);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            scheduler_ticks += scheduler->carry_us / 1000;
+        }
+        scheduler->carry_us %= 1000;
+        return;
+    }
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode(); // Woken by the next tick
+}
+
+/**
+ * Run tasks forever
+ * @param scheduler
+*/
+void scheduler_run(scheduler_t* scheduler) {
+    while (1) {
+        if (!scheduler_run_ready(scheduler)) {
+            scheduler_sleep(scheduler);
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/**
+ * C Library for cooperative task scheduler
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "power.h"
+
+#define SCHEDULER_MAX_TASKS 8
+#define SCHEDULER_NO_TASK 0xFF
+#define SCHEDULER_POWER_DOWN_MS 40 // Shorter waits are spent in idle mode, the tick keeps running
+
+typedef void (*scheduler_callback_t)(void* context);
+typedef bool (*scheduler_busy_t)(void); // Peripherals that stop in power-down are busy
+
+typedef struct {
+    scheduler_callback_t callback; // NULL = free slot
+    void* context;
+    uint32_t release_ms; // Time when the task is ready
+    uint32_t period_ms; // 0 = one-shot task
+    uint32_t deadline_ms; // Time after the release when the task must be started
+    uint16_t runs;
+    uint16_t misses; // Runs started after the deadline
+} scheduler_task_t;
+
+typedef struct {
+    scheduler_task_t tasks[SCHEDULER_MAX_TASKS];
+    power_t* power; // NULL = only idle mode between tasks
+    scheduler_busy_t is_busy; // Power-down waits until it returns false (NULL = never busy)
+    uint32_t carry_us; // Sleep time that is not a whole tick yet
+} scheduler_t;
+
+void scheduler_init(scheduler_t* scheduler, power_t* power);
+void scheduler_set_busy(scheduler_t* scheduler, scheduler_busy_t is_busy);
+uint32_t scheduler_get_time(void);
+uint8_t scheduler_add_periodic(scheduler_t* scheduler, scheduler_callback_t callback, void* context, uint32_t period_ms, uint32_t deadline_ms);
+uint8_t scheduler_add_once(scheduler_t* scheduler, scheduler_callback_t callback, void* context, uint32_t delay_ms, uint32_t deadline_ms);
+void scheduler_cancel(scheduler_t* scheduler, uint8_t task);
+const scheduler_task_t* scheduler_get_task(const scheduler_t* scheduler, uint8_t task);
+bool scheduler_run_ready(scheduler_t* scheduler);
+void scheduler_sleep(scheduler_t* scheduler);
+void scheduler_run(scheduler_t* scheduler);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,231 @@
+/**
+ * C Library for pipelined measurement of several BMP180 sensors
+ * Conversions of all sensors run at the same time: a conversion is started on every sensor,
+ * then the sensors are polled and served in the order their conversions complete.
+ * A cycle of N sensors takes about one temperature and one pressure conversion time, not N.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <util/delay.h>
+#include "i2c.h"
+#include "bmp180.h"
+#include "sensor_array.h"
+
+/**
+ * Init sensor array
+ * @param array
+ * @param select Selects channel of the I2C mux (NULL = sensors have different addresses)
+ * @param context Passed to select
+ * @param max_disagreement Pressure deviation from the median that makes a sensor an outlier (in Pa)
+*/
+void sensor_array_init(sensor_array_t* array, sensor_array_select_t select, void* context, int32_t max_disagreement) {
+    memset(array, 0, sizeof(sensor_array_t));
+    array->select = select;
+    array->context = context;
+    array->max_disagreement = max_disagreement;
+}
+
+/**
+ * Add sensor
+ * The sensor must be initialized by bmp180_init() with its channel selected.
+ * @param array
+ * @param sensor
+ * @param channel Channel of the mux (SENSOR_ARRAY_NO_CHANNEL = no mux)
+*/
+bool sensor_array_add(sensor_array_t* array, bmp180_t* sensor, uint8_t channel) {
+    if (array->count >= SENSOR_ARRAY_MAX_SENSORS) {
+        return false;
+    }
+    sensor_array_entry_t* entry = &array->entries[array->count++];
+    entry->sensor = sensor;
+    entry->channel = channel;
+    return true;
+}
+
+bool sensor_array_is_healthy(const sensor_array_t* array, uint8_t index) {
+    return index < array->count && array->entries[index].consecutive_errors < SENSOR_ARRAY_MAX_ERRORS;
+}
+
+static bool sensor_array_select(const sensor_array_t* array, const sensor_array_entry_t* entry) {
+    if (array->select == NULL || entry->channel == SENSOR_ARRAY_NO_CHANNEL) {
+        return true;
+    }
+    return array->select(entry->channel, array->context);
+}
+
+static bool sensor_array_needs_temperature(const bmp180_t* sensor) {
+    return sensor->B5_max_age == 0 || bmp180_is_temperature_stale(sensor);
+}
+
+static void sensor_array_start(const sensor_array_t* array, sensor_array_entry_t* entry) {
+    bool is_ok = sensor_array_select(array, entry);
+    if (sensor_array_needs_temperature(entry->sensor)) {
+        is_ok = is_ok && bmp180_start_temperature(entry->sensor, NULL);
+        entry->state = is_ok ? SENSOR_ARRAY_TEMPERATURE : SENSOR_ARRAY_FAILED;
+    }
+    else {
+        entry->temp = entry->sensor->temperature;
+        is_ok = is_ok && bmp180_start_pressure(entry->sensor, NULL);
+        entry->state = is_ok ? SENSOR_ARRAY_PRESSURE : SENSOR_ARRAY_FAILED;
+    }
+}
+
+// Serves the sensor if its conversion is complete, returns true if the sensor is still busy
+static bool sensor_array_serve(const sensor_array_t* array, sensor_array_entry_t* entry) {
+    bool is_ready = false;
+    bool is_ok = sensor_array_select(array, entry);
+    is_ok = is_ok && bmp180_poll(entry->sensor, &is_ready);
+    if (!is_ok) {
+        entry->state = SENSOR_ARRAY_FAILED;
+        return false;
+    }
+    if (!is_ready) {
+        return true;
+    }
+
+    if (entry->state == SENSOR_ARRAY_TEMPERATURE) {
+        // Pressure conversion of this sensor overlaps with the conversions of the others
+        is_ok = bmp180_read_result(entry->sensor, &entry->temp);
+        is_ok = is_ok && bmp180_start_pressure(entry->sensor, NULL);
+        entry->state = is_ok ? SENSOR_ARRAY_PRESSURE : SENSOR_ARRAY_FAILED;
+        return is_ok;
+    }
+
+    is_ok = bmp180_read_result(entry->sensor, &entry->press);
+    entry->state = is_ok ? SENSOR_ARRAY_DONE : SENSOR_ARRAY_FAILED;
+    return false;
+}
+
+static int32_t sensor_array_median(int32_t* values, uint8_t length) {
+    for (uint8_t i = 1; i < length; i++) {
+        const int32_t value = values[i];
+        uint8_t j = i;
+        while (j > 0 && values[j - 1] > value) {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = value;
+    }
+    if (length % 2 == 0) {
+        return (values[length / 2 - 1] + values[length / 2] + 1) / 2;
+    }
+    return values[length / 2];
+}
+
+/**
+ * Compares valid sensors with the median
+ * The result is the mean of the sensors that agree with the median. When none agrees (e.g. two sensors
+ * further apart than twice max_disagreement) the outlier can't be told, the result is the median pressure
+ * and the mean temperature of all valid sensors, every sensor is reported as an outlier.
+ * @return false if no sensor is valid
+*/
+static bool sensor_array_check_agreement(sensor_array_t* array, int32_t* temp, int32_t* press) {
+    int32_t values[SENSOR_ARRAY_MAX_SENSORS];
+    uint8_t valid = 0;
+    for (uint8_t i = 0; i < array->count; i++) {
+        if (array->entries[i].is_valid) {
+            values[valid++] = array->entries[i].press;
+        }
+    }
+    array->spread = 0;
+    if (valid == 0) {
+        return false;
+    }
+    const int32_t median = sensor_array_median(values, valid);
+    array->spread = values[valid - 1] - values[0];
+
+    int32_t temp_sum = 0;
+    int32_t press_sum = 0;
+    int32_t valid_temp_sum = 0;
+    uint8_t agreed = 0;
+    for (uint8_t i = 0; i < array->count; i++) {
+        sensor_array_entry_t* entry = &array->entries[i];
+        if (!entry->is_valid) {
+            continue;
+        }
+        entry->deviation = entry->press - median;
+        entry->is_outlier = entry->deviation > array->max_disagreement || entry->deviation < -array->max_disagreement;
+        valid_temp_sum += entry->temp;
+        if (!entry->is_outlier) {
+            temp_sum += entry->temp;
+            press_sum += entry->press;
+            agreed++;
+        }
+    }
+    if (agreed == 0) {
+        *temp = (valid_temp_sum + valid / 2) / valid;
+        *press = median;
+        return true;
+    }
+    *temp = (temp_sum + agreed / 2) / agreed;
+    *press = (press_sum + agreed / 2) / agreed;
+    return true;
+}
+
+/**
+ * Measure all sensors
+ * Every sensor gets a temperature (if needed) and a pressure conversion,
+ * results are read in completion order.
+ * Per-sensor results, health and disagreement are stored in the entries.
+ * @param array
+ * @param temp Mean temperature of the sensors that agree (in 0.1 C)
+ * @param press Mean pressure of the sensors that agree (in Pa), the median if none agrees
+ * @return false if no sensor has a valid result
+*/
+bool sensor_array_measure(sensor_array_t* array, int32_t* temp, int32_t* press) {
+    for (uint8_t i = 0; i < array->count; i++) {
+        sensor_array_start(array, &array->entries[i]);
+    }
+
+    bool is_busy = true;
+    for (uint8_t poll = 0; poll < SENSOR_ARRAY_MAX_POLLS && is_busy; poll++) {
+        _delay_us(SENSOR_ARRAY_POLL_US);
+        is_busy = false;
+        for (uint8_t i = 0; i < array->count; i++) {
+            sensor_array_entry_t* entry = &array->entries[i];
+            if (entry->state == SENSOR_ARRAY_TEMPERATURE || entry->state == SENSOR_ARRAY_PRESSURE) {
+                is_busy = sensor_array_serve(array, entry) || is_busy;
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < array->count; i++) {
+        sensor_array_entry_t* entry = &array->entries[i];
+        entry->is_valid = entry->state == SENSOR_ARRAY_DONE;
+        entry->is_outlier = false;
+        entry->deviation = 0;
+        entry->cycles++;
+        if (entry->is_valid) {
+            entry->consecutive_errors = 0;
+        }
+        else {
+            // Timed out or failed, the conversion is abandoned
+            entry->sensor->conversion = BMP180_CONVERSION_NONE;
+            entry->errors++;
+            if (entry->consecutive_errors < UINT8_MAX) {
+                entry->consecutive_errors++;
+            }
+        }
+        entry->state = SENSOR_ARRAY_IDLE;
+    }
+
+    return sensor_array_check_agreement(array, temp, press);
+}
+
+/**
+ * Select channel of TCA9548A I2C mux
+ * @param channel (0-7)
+ * @param context Pointer to I2C address of the mux (uint8_t)
+*/
+bool sensor_array_select_tca9548a(uint8_t channel, void* context) {
+    const uint8_t address = *(const uint8_t*)context;
+    bool is_ok;
+    is_ok = i2c_start(address, I2C_MODE_WRITE);
+    is_ok = is_ok && i2c_write_byte(1 << channel);
+    i2c_stop();
+    return is_ok;
+}
@@ -0,0 +1,68 @@
+/**
+ * C Library for pipelined measurement of several BMP180 sensors
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef SENSOR_ARRAY_H
+#define SENSOR_ARRAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bmp180_def.h"
+
+#define SENSOR_ARRAY_MAX_SENSORS 4
+#define SENSOR_ARRAY_MAX_ERRORS 3 // Consecutive errors of an unhealthy sensor
+#define SENSOR_ARRAY_POLL_US 500 // Interval of polling the conversions
+#define SENSOR_ARRAY_MAX_POLLS 120 // Timeout of a measurement cycle (60 ms)
+#define SENSOR_ARRAY_NO_CHANNEL 0xFF // Sensor is not behind the mux
+
+/**
+ * Select channel of I2C mux
+ * @param channel
+ * @param context
+*/
+typedef bool (*sensor_array_select_t)(uint8_t channel, void* context);
+
+typedef enum {
+    SENSOR_ARRAY_IDLE = 0,
+    SENSOR_ARRAY_TEMPERATURE = 1, // Temperature conversion in flight
+    SENSOR_ARRAY_PRESSURE = 2, // Pressure conversion in flight
+    SENSOR_ARRAY_DONE = 3,
+    SENSOR_ARRAY_FAILED = 4,
+} sensor_array_state_t;
+
+typedef struct {
+    bmp180_t* sensor;
+    uint8_t channel; // Channel of the mux (SENSOR_ARRAY_NO_CHANNEL = no mux)
+    sensor_array_state_t state;
+
+    // Result of the last cycle
+    bool is_valid;
+    int32_t temp; // Temperature in 0.1 C
+    int32_t press; // Pressure in Pa
+    int32_t deviation; // Pressure minus the median of all valid sensors (in Pa)
+    bool is_outlier; // Deviation is larger than max_disagreement
+
+    // Health
+    uint16_t cycles;
+    uint16_t errors;
+    uint8_t consecutive_errors;
+} sensor_array_entry_t;
+
+typedef struct {
+    sensor_array_entry_t entries[SENSOR_ARRAY_MAX_SENSORS];
+    uint8_t count;
+    sensor_array_select_t select;
+    void* context;
+    int32_t max_disagreement; // In Pa
+    int32_t spread; // Max minus min pressure of the valid sensors in the last cycle (in Pa)
+} sensor_array_t;
+
+void sensor_array_init(sensor_array_t* array, sensor_array_select_t select, void* context, int32_t max_disagreement);
+bool sensor_array_add(sensor_array_t* array, bmp180_t* sensor, uint8_t channel);
+bool sensor_array_measure(sensor_array_t* array, int32_t* temp, int32_t* press);
+bool sensor_array_is_healthy(const sensor_array_t* array, uint8_t index);
+bool sensor_array_select_tca9548a(uint8_t channel, void* context);
+
+#endif // SENSOR_ARRAY_H
@@ -0,0 +1,195 @@
+/**
+ * Sparkline: auto-scaled history chart for SSD1306 OLED Display
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "ssd1306.h"
+#include "sparkline.h"
+
+#define SPARKLINE_CHUNK 16 // Columns sent in one data transaction
+
+static uint8_t ring_index(uint8_t head, uint8_t offset) {
+    return (uint8_t)((head + offset) % SPARKLINE_CAPACITY);
+}
+
+/**
+ * Init sparkline
+ * The sparkline takes about 650 bytes of RAM, so it should be a static variable.
+ * @param sparkline
+ * @param start_page (0-7)
+ * @param end_page (0-7) Up to SPARKLINE_MAX_PAGES pages
+ * @param start_column (0-127)
+ * @param width Columns (1 - SPARKLINE_CAPACITY)
+ * @param interval Values averaged into one sample (1 = every value is a sample)
+*/
+void sparkline_init(sparkline_t* sparkline, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t width, uint8_t interval) {
+    memset(sparkline, 0, sizeof(sparkline_t));
+    sparkline->start_page = start_page;
+    sparkline->end_page = end_page;
+    sparkline->start_column = start_column;
+    sparkline->width = width > SPARKLINE_CAPACITY ? SPARKLINE_CAPACITY : width;
+    sparkline->interval = interval == 0 ? 1 : interval;
+    memset(sparkline->heights, SPARKLINE_NOT_DRAWN, SPARKLINE_CAPACITY);
+}
+
+static void sparkline_push(sparkline_t* sparkline, int32_t value) {
+    if (sparkline->count == 0) {
+        sparkline->base = value;
+    }
+
+    int32_t delta = value - sparkline->base;
+    if (delta > INT16_MAX) {
+        delta = INT16_MAX;
+    }
+    else if (delta < INT16_MIN) {
+        delta = INT16_MIN;
+    }
+
+    // Drop the oldest sample, it leaves the queues if it is their front
+    if (sparkline->count == sparkline->width) {
+        const uint8_t oldest = sparkline->head;
+        if (sparkline->min_count > 0 && sparkline->min_queue[sparkline->min_head] == oldest) {
+            sparkline->min_head = ring_index(sparkline->min_head, 1);
+            sparkline->min_count--;
+        }
+        if (sparkline->max_count > 0 && sparkline->max_queue[sparkline->max_head] == oldest) {
+            sparkline->max_head = ring_index(sparkline->max_head, 1);
+            sparkline->max_count--;
+        }
+        sparkline->head = ring_index(sparkline->head, 1);
+        sparkline->count--;
+    }
+
+    const uint8_t position = ring_index(sparkline->head, sparkline->count);
+    sparkline->samples[position] = (int16_t)delta;
+    sparkline->count++;
+
+    // Samples that can't be min/max anymore leave the back of the queues,
+    // every sample enters and leaves a queue once: O(1) amortized
+    while (sparkline->min_count > 0 &&
+           sparkline->samples[sparkline->min_queue[ring_index(sparkline->min_head, sparkline->min_count - 1)]] >= delta) {
+        sparkline->min_count--;
+    }
+    sparkline->min_queue[ring_index(sparkline->min_head, sparkline->min_count++)] = position;
+
+    while (sparkline->max_count > 0 &&
+           sparkline->samples[sparkline->max_queue[ring_index(sparkline->max_head, sparkline->max_count - 1)]] <= delta) {
+        sparkline->max_count--;
+    }
+    sparkline->max_queue[ring_index(sparkline->max_head, sparkline->max_count++)] = position;
+}
+
+/**
+ * Add value
+ * @return true if a new sample is added (the chart needs to be drawn)
+*/
+bool sparkline_add(sparkline_t* sparkline, int32_t value) {
+    sparkline->accumulator += value;
+    sparkline->accumulated++;
+    if (sparkline->accumulated < sparkline->interval) {
+        return false;
+    }
+    sparkline_push(sparkline, sparkline->accumulator / sparkline->accumulated);
+    sparkline->accumulator = 0;
+    sparkline->accumulated = 0;
+    return true;
+}
+
+int32_t sparkline_get_min(const sparkline_t* sparkline) {
+    if (sparkline->count == 0) {
+        return 0;
+    }
+    return sparkline->base + sparkline->samples[sparkline->min_queue[sparkline->min_head]];
+}
+
+int32_t sparkline_get_max(const sparkline_t* sparkline) {
+    if (sparkline->count == 0) {
+        return 0;
+    }
+    return sparkline->base + sparkline->samples[sparkline->max_queue[sparkline->max_head]];
+}
+
+/**
+ * Height of the bar in pixels (1 - height of the chart), 0 for a column without sample
+*/
+static uint8_t sparkline_bar_height(const sparkline_t* sparkline, uint8_t column, int16_t min, int16_t max, uint8_t height) {
+    const uint8_t empty = sparkline->width - sparkline->count;
+    if (column < empty) {
+        return 0;
+    }
+    const int16_t value = sparkline->samples[ring_index(sparkline->head, column - empty)];
+    if (max == min) {
+        return height / 2;
+    }
+    return 1 + (uint8_t)((int32_t)(value - min) * (height - 1) / (max - min));
+}
+
+static bool sparkline_draw_columns(const ssd1306_t* ssd1306, const sparkline_t* sparkline, uint8_t start, uint8_t length) {
+    const uint8_t pages = sparkline->end_page - sparkline->start_page + 1;
+    const uint8_t height = pages * SSD1306_BITS_PER_COLUMN;
+    uint8_t buff[SPARKLINE_CHUNK * SPARKLINE_MAX_PAGES];
+
+    for (uint8_t i = 0; i < length; i++) {
+        // Bar from the bottom of the chart, bit 0 is the top pixel of a page
+        const uint8_t top = height - sparkline->heights[start + i];
+        for (uint8_t page = 0; page < pages; page++) {
+            const uint8_t page_top = page * SSD1306_BITS_PER_COLUMN;
+            uint8_t value = 0x00;
+            if (top <= page_top) {
+                value = 0xFF;
+            }
+            else if (top < page_top + SSD1306_BITS_PER_COLUMN) {
+                value = (uint8_t)(0xFF << (top - page_top));
+            }
+            buff[page * length + i] = value;
+        }
+    }
+    return ssd1306_draw_buffer(ssd1306, sparkline->start_page, sparkline->start_column + start, length, height, buff);
+}
+
+/**
+ * Draw sparkline
+ * The chart is scaled to min/max of the samples. Only the columns whose bar
+ * has changed are sent, runs of changed columns in one transaction each.
+ * @param ssd1306
+ * @param sparkline
+*/
+bool sparkline_draw(const ssd1306_t* ssd1306, sparkline_t* sparkline) {
+    const uint8_t pages = sparkline->end_page - sparkline->start_page + 1;
+    if (pages > SPARKLINE_MAX_PAGES || sparkline->end_page < sparkline->start_page) {
+        return false;
+    }
+    const uint8_t height = pages * SSD1306_BITS_PER_COLUMN;
+    const int16_t min = sparkline->count > 0 ? sparkline->samples[sparkline->min_queue[sparkline->min_head]] : 0;
+    const int16_t max = sparkline->count > 0 ? sparkline->samples[sparkline->max_queue[sparkline->max_head]] : 0;
+
+    bool is_ok = true;
+    uint8_t run_start = 0;
+    uint8_t run_length = 0;
+    for (uint8_t column = 0; column <= sparkline->width; column++) {
+        bool is_changed = false;
+        if (column < sparkline->width) {
+            const uint8_t bar_height = sparkline_bar_height(sparkline, column, min, max, height);
+            is_changed = bar_height != sparkline->heights[column];
+            sparkline->heights[column] = bar_height;
+        }
+        if (is_changed) {
+            if (run_length == 0) {
+                run_start = column;
+            }
+            run_length++;
+        }
+        if (run_length > 0 && (!is_changed || run_length == SPARKLINE_CHUNK)) {
+            is_ok = is_ok && sparkline_draw_columns(ssd1306, sparkline, run_start, run_length);
+            if (!is_ok) {
+                memset(&sparkline->heights[run_start], SPARKLINE_NOT_DRAWN, run_length); // Redraw next time
+            }
+            run_length = 0;
+        }
+    }
+    return is_ok;
+}
@@ -0,0 +1,53 @@
+/**
+ * Sparkline: auto-scaled history chart for SSD1306 OLED Display
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef SPARKLINE_H
+#define SPARKLINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306_def.h"
+
+#define SPARKLINE_CAPACITY 128 // Samples in the ring buffer (one sample per column)
+#define SPARKLINE_MAX_PAGES 2 // Max height of the chart in pages
+#define SPARKLINE_NOT_DRAWN 0xFF // Height of a column that is not on the display yet
+
+typedef struct {
+    // Chart area of the display
+    uint8_t start_page;
+    uint8_t end_page;
+    uint8_t start_column;
+    uint8_t width; // Columns (1 - SPARKLINE_CAPACITY)
+
+    // Averaging of input values, one sample per interval values
+    uint8_t interval;
+    uint8_t accumulated;
+    int32_t accumulator;
+
+    // Ring buffer of samples, stored as deltas from the first value
+    int32_t base;
+    int16_t samples[SPARKLINE_CAPACITY];
+    uint8_t head; // Position of the oldest sample
+    uint8_t count;
+
+    // Monotonic queues of sample positions, the front is the position of min/max sample
+    uint8_t min_queue[SPARKLINE_CAPACITY];
+    uint8_t min_head;
+    uint8_t min_count;
+    uint8_t max_queue[SPARKLINE_CAPACITY];
+    uint8_t max_head;
+    uint8_t max_count;
+
+    uint8_t heights[SPARKLINE_CAPACITY]; // Bar heights on the display
+} sparkline_t;
+
+void sparkline_init(sparkline_t* sparkline, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t width, uint8_t interval);
+bool sparkline_add(sparkline_t* sparkline, int32_t value);
+int32_t sparkline_get_min(const sparkline_t* sparkline);
+int32_t sparkline_get_max(const sparkline_t* sparkline);
+bool sparkline_draw(const ssd1306_t* ssd1306, sparkline_t* sparkline);
+
+#endif // SPARKLINE_H
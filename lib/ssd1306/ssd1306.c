@@ -8,6 +8,7 @@
 #include <avr/pgmspace.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include "i2c.h"
 #include "bitwise.h"
 #include "ssd1306_def.h"
@@ -16,23 +17,23 @@ static uint8_t div_ceil(uint8_t a, uint8_t b) {
     return (a / b + (a % b > 0 ? 1 : 0));
 }
 
-static bool ssd1306_send_command(const ssd1306_t* ssd1306, uint8_t command) {
+static bool ssd1306_send_commands(const ssd1306_t* ssd1306, const uint8_t* commands, uint8_t length) {
     bool is_ok;
+    i2c_profile_set_caller(I2C_CALLER_SSD1306_COMMAND);
     is_ok = i2c_start(ssd1306->i2c_address, I2C_MODE_WRITE);
     is_ok = is_ok && i2c_write_byte(SSD1306_SEND_COMMAND);
-    is_ok = is_ok && i2c_write_byte(command);
+    is_ok = is_ok && i2c_write_buffer(commands, length);
     i2c_stop();
     return is_ok;
 }
 
+static bool ssd1306_send_command(const ssd1306_t* ssd1306, uint8_t command) {
+    return ssd1306_send_commands(ssd1306, &command, 1);
+}
+
 static bool ssd1306_send_command_value(const ssd1306_t* ssd1306, uint8_t command, uint8_t value) {
-    bool is_ok;
-    is_ok = i2c_start(ssd1306->i2c_address, I2C_MODE_WRITE);
-    is_ok = is_ok & i2c_write_byte(SSD1306_SEND_COMMAND);
-    is_ok = is_ok & i2c_write_byte(command);
-    is_ok = is_ok & i2c_write_byte(value);
-    i2c_stop();
-    return is_ok;
+    const uint8_t commands[] = { command, value };
+    return ssd1306_send_commands(ssd1306, commands, sizeof(commands));
 }
 
 /**
@@ -280,42 +281,241 @@ static bool is_valid_column(uint8_t column) {
  * @param end_column (0-127)
 */
 static bool ssd1306_set_area(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column) {
-    bool is_ok;
-    is_ok = i2c_start(ssd1306->i2c_address, I2C_MODE_WRITE);
-    is_ok = is_ok && i2c_write_byte(SSD1306_SEND_COMMAND);
-    is_ok = is_ok && i2c_write_byte(SSD1306_DISPLAY_START_LINE_COMMAND); // Reset start line
+    uint8_t commands[7];
+    uint8_t length = 0;
+    commands[length++] = SSD1306_DISPLAY_START_LINE_COMMAND; // Reset start line
 
     if (is_valid_page(start_page) && is_valid_page(end_page)) {
-        is_ok = is_ok && i2c_write_byte(SSD1306_PAGE_START_END_ADDRESS_COMMAND);
-        is_ok = is_ok && i2c_write_byte(start_page);
-        is_ok = is_ok && i2c_write_byte(end_page);
+        commands[length++] = SSD1306_PAGE_START_END_ADDRESS_COMMAND;
+        commands[length++] = start_page;
+        commands[length++] = end_page;
     }
 
     if (is_valid_column(start_column) && is_valid_column(end_column)) {
-        is_ok = is_ok && i2c_write_byte(SSD1306_COLUMN_START_END_ADDRESS_COMMAND);
-        is_ok = is_ok && i2c_write_byte(start_column);
-        is_ok = is_ok && i2c_write_byte(end_column);
+        commands[length++] = SSD1306_COLUMN_START_END_ADDRESS_COMMAND;
+        commands[length++] = start_column;
+        commands[length++] = end_column;
     }
 
-    i2c_stop();
-    return is_ok;
+    return ssd1306_send_commands(ssd1306, commands, length);
 }
 
-bool ssd1306_clear_display(const ssd1306_t* ssd1306) {
-    bool is_ok = ssd1306_set_area(ssd1306, SSD1306_PAGE_START_ADDRESS, SSD1306_PAGE_END_ADDRESS, SSD1306_COLUMN_START_ADDRESS, SSD1306_COLUMN_END_ADDRESS);
-
-    // Reset Display
+/**
+ * Begin writing data to the area
+ * In framebuffer mode the data goes to RAM, so nothing is sent to the display.
+ * @param ssd1306
+ * @param start_page (0-7)
+ * @param end_page (0-7)
+ * @param start_column (0-127)
+ * @param end_column (0-127)
+*/
+static bool ssd1306_begin_data(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column) {
+    if (ssd1306->framebuffer != NULL) {
+        return true;
+    }
+    bool is_ok;
+    is_ok = ssd1306_set_area(ssd1306, start_page, end_page, start_column, end_column);
+    i2c_profile_set_caller(I2C_CALLER_SSD1306_DATA);
     is_ok = is_ok && i2c_start(ssd1306->i2c_address, I2C_MODE_WRITE);
     is_ok = is_ok && i2c_write_byte(SSD1306_SEND_DATA);
-    for (int i = 0; i < SSD1306_DISPLAY_BYTES; i++) {
-        is_ok = is_ok && i2c_write_byte(0x00);
+    return is_ok;
+}
+
+static void ssd1306_mark_dirty(ssd1306_framebuffer_t* framebuffer, uint8_t page, uint8_t column) {
+    if (framebuffer->dirty_start[page] == SSD1306_DIRTY_NONE || column < framebuffer->dirty_start[page]) {
+        framebuffer->dirty_start[page] = column;
     }
-    i2c_stop();
+    if (column > framebuffer->dirty_end[page]) {
+        framebuffer->dirty_end[page] = column;
+    }
+}
+
+/**
+ * Write one byte (8 vertical pixels) of the area
+ * In framebuffer mode the column is marked dirty only if its value has changed.
+ * @param ssd1306
+ * @param page (0-7) Page of the byte (used in framebuffer mode)
+ * @param column (0-127) Column of the byte (used in framebuffer mode)
+ * @param value
+*/
+static bool ssd1306_write_data(const ssd1306_t* ssd1306, uint8_t page, uint8_t column, uint8_t value) {
+    ssd1306_framebuffer_t* framebuffer = ssd1306->framebuffer;
+    if (framebuffer == NULL) {
+        return i2c_write_byte(value);
+    }
+    if (!is_valid_page(page) || !is_valid_column(column)) {
+        return true; // Clipped
+    }
+    uint8_t* byte = &framebuffer->data[page * SSD1306_WIDTH + column];
+    if (*byte != value) {
+        *byte = value;
+        ssd1306_mark_dirty(framebuffer, page, column);
+    }
+    return true;
+}
+
+/**
+ * Write a run of bytes to one page of the area
+ * Without framebuffer the bytes are streamed to the display in one burst.
+ * @param ssd1306
+ * @param page (0-7) Page of the run (used in framebuffer mode)
+ * @param column (0-127) First column of the run (used in framebuffer mode)
+ * @param data
+ * @param length
+*/
+static bool ssd1306_write_row(const ssd1306_t* ssd1306, uint8_t page, uint8_t column, const uint8_t* data, uint8_t length) {
+    if (ssd1306->framebuffer == NULL) {
+        return i2c_write_buffer(data, length);
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        ssd1306_write_data(ssd1306, page, column + i, data[i]);
+    }
+    return true;
+}
+
+/**
+ * Write a run of bytes from PROGMEM to one page of the area
+ * See: ssd1306_write_row()
+*/
+static bool ssd1306_write_row_P(const ssd1306_t* ssd1306, uint8_t page, uint8_t column, const uint8_t* data, uint8_t length) {
+    if (ssd1306->framebuffer == NULL) {
+        return i2c_write_buffer_P(data, length);
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        ssd1306_write_data(ssd1306, page, column + i, pgm_read_byte(&data[i]));
+    }
+    return true;
+}
+
+/**
+ * Write the same byte to a run of columns of one page of the area
+ * See: ssd1306_write_row()
+*/
+static bool ssd1306_write_repeat(const ssd1306_t* ssd1306, uint8_t page, uint8_t column, uint8_t value, uint8_t length) {
+    if (ssd1306->framebuffer == NULL) {
+        return i2c_write_repeat(value, length);
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        ssd1306_write_data(ssd1306, page, column + i, value);
+    }
+    return true;
+}
+
+static void ssd1306_end_data(const ssd1306_t* ssd1306) {
+    if (ssd1306->framebuffer == NULL) {
+        i2c_stop();
+    }
+}
+
+static void ssd1306_mark_clean(ssd1306_framebuffer_t* framebuffer, uint8_t page) {
+    framebuffer->dirty_start[page] = SSD1306_DIRTY_NONE;
+    framebuffer->dirty_end[page] = SSD1306_COLUMN_START_ADDRESS;
+}
+
+/**
+ * Use framebuffer
+ * All drawing goes to RAM until ssd1306_flush() is called.
+ * The whole display is marked dirty, so the first flush repaints it.
+ * @param ssd1306
+ * @param framebuffer (NULL = draw directly to the display)
+*/
+void ssd1306_set_framebuffer(ssd1306_t* ssd1306, ssd1306_framebuffer_t* framebuffer) {
+    ssd1306->framebuffer = framebuffer;
+    if (framebuffer == NULL) {
+        return;
+    }
+    for (uint16_t i = 0; i < SSD1306_DISPLAY_BYTES; i++) {
+        framebuffer->data[i] = 0x00;
+    }
+    for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+        framebuffer->dirty_start[page] = SSD1306_COLUMN_START_ADDRESS;
+        framebuffer->dirty_end[page] = SSD1306_COLUMN_END_ADDRESS;
+    }
+}
+
+/**
+ * Send changed regions of the framebuffer to the display
+ * Every dirty page costs one area setup and one data transaction
+ * with the changed column range only.
+ * Without framebuffer does nothing.
+*/
+bool ssd1306_flush(const ssd1306_t* ssd1306) {
+    ssd1306_framebuffer_t* framebuffer = ssd1306->framebuffer;
+    if (framebuffer == NULL) {
+        return true;
+    }
+
+    bool is_ok = true;
+    for (uint8_t page = 0; page < SSD1306_PAGES && is_ok; page++) {
+        const uint8_t start_column = framebuffer->dirty_start[page];
+        const uint8_t end_column = framebuffer->dirty_end[page];
+        if (start_column == SSD1306_DIRTY_NONE) {
+            continue;
+        }
+
+        is_ok = ssd1306_set_area(ssd1306, page, page, start_column, end_column);
+        i2c_profile_set_caller(I2C_CALLER_SSD1306_DATA);
+        is_ok = is_ok && i2c_start(ssd1306->i2c_address, I2C_MODE_WRITE);
+        is_ok = is_ok && i2c_write_byte(SSD1306_SEND_DATA);
+        is_ok = is_ok && i2c_write_buffer(&framebuffer->data[page * SSD1306_WIDTH + start_column], end_column - start_column + 1);
+        i2c_stop();
+
+        if (is_ok) {
+            ssd1306_mark_clean(framebuffer, page);
+        }
+    }
+    return is_ok;
+}
+
+/**
+ * Fill area
+ * The area is clipped at the edges of the display.
+ * @param ssd1306
+ * @param start_page (0-7)
+ * @param end_page (0-7)
+ * @param start_column (0-127)
+ * @param end_column (0-127)
+ * @param pattern Byte for every column of the pages (0x00 = all pixels off, 0xFF = all pixels on)
+*/
+bool ssd1306_fill_rect(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column, uint8_t pattern) {
+    if (end_page > SSD1306_PAGE_END_ADDRESS) {
+        end_page = SSD1306_PAGE_END_ADDRESS;
+    }
+    if (end_column > SSD1306_COLUMN_END_ADDRESS) {
+        end_column = SSD1306_COLUMN_END_ADDRESS;
+    }
+    if (start_page > end_page || start_column > end_column) {
+        return true; // Nothing to fill
+    }
+
+    const uint8_t width = end_column - start_column + 1;
+    bool is_ok = ssd1306_begin_data(ssd1306, start_page, end_page, start_column, end_column);
+    for (uint8_t page = start_page; page <= end_page; page++) {
+        is_ok = is_ok && ssd1306_write_repeat(ssd1306, page, start_column, pattern, width);
+    }
+    ssd1306_end_data(ssd1306);
     return is_ok;
 }
 
 /**
- * Draw Bitmap
+ * Clear area
+ * @param ssd1306
+ * @param start_page (0-7)
+ * @param end_page (0-7)
+ * @param start_column (0-127)
+ * @param end_column (0-127)
+*/
+bool ssd1306_clear_rect(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column) {
+    return ssd1306_fill_rect(ssd1306, start_page, end_page, start_column, end_column, 0x00);
+}
+
+bool ssd1306_clear_display(const ssd1306_t* ssd1306) {
+    return ssd1306_clear_rect(ssd1306, SSD1306_PAGE_START_ADDRESS, SSD1306_PAGE_END_ADDRESS, SSD1306_COLUMN_START_ADDRESS, SSD1306_COLUMN_END_ADDRESS);
+}
+
+/**
+ * Draw Bitmap (row-major format)
+ * Every 8x8 block is transposed to the columns of the display.
  * @param ssd1306
  * @param start_page (0-7)
  * @param start_column (0-127)
@@ -327,10 +527,7 @@ bool ssd1306_draw_bitmap(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t s
     bool is_ok;
     const uint8_t end_page = height / SSD1306_BITS_PER_COLUMN + start_page;
     const uint8_t end_column = start_column + width - 1;
-    is_ok = ssd1306_set_area(ssd1306, start_page, end_page, start_column, end_column);
-
-    is_ok = is_ok && i2c_start(ssd1306->i2c_address, I2C_MODE_WRITE);
-    is_ok = is_ok && i2c_write_byte(SSD1306_SEND_DATA);
+    is_ok = ssd1306_begin_data(ssd1306, start_page, end_page, start_column, end_column);
 
     const uint8_t x_len = div_ceil(width, SSD1306_BITS_IN_BYTE);
     const uint8_t y_len = div_ceil(height, SSD1306_BITS_IN_BYTE);
@@ -352,14 +549,136 @@ bool ssd1306_draw_bitmap(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t s
                     const uint8_t src_bit = col;
                     copy_bit(src_value, dst_value, src_bit, bit);
                 }
-                is_ok = is_ok && i2c_write_byte(dst_value);
+                is_ok = is_ok && ssd1306_write_data(ssd1306, start_page + y, start_column + x * SSD1306_BITS_IN_BYTE + col, dst_value);
             }
         }
     }
-    i2c_stop();
+    ssd1306_end_data(ssd1306);
     return is_ok;
 };
 
+/**
+ * Draw Bitmap (page-native format)
+ * Bytes are stored in the display RAM order, so they are sent without transposing.
+ * See: tools/bitmap_converter.py
+ * @param ssd1306
+ * @param start_page (0-7)
+ * @param start_column (0-127)
+ * @param width Width bitmap
+ * @param height Height bitmap
+ * @param bitmap Bitmap (from PROGMEM)
+*/
+bool ssd1306_draw_paged_bitmap(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t start_column, uint8_t width, uint8_t height, ssd1306_bitmap_t bitmap) {
+    bool is_ok;
+    const uint8_t pages = div_ceil(height, SSD1306_BITS_PER_COLUMN);
+    const uint8_t end_page = start_page + pages - 1;
+    const uint8_t end_column = start_column + width - 1;
+    is_ok = ssd1306_begin_data(ssd1306, start_page, end_page, start_column, end_column);
+
+    for (uint8_t page = 0; page < pages; page++) {
+        is_ok = is_ok && ssd1306_write_row_P(ssd1306, start_page + page, start_column, bitmap, width);
+        bitmap += width;
+    }
+    ssd1306_end_data(ssd1306);
+    return is_ok;
+}
+
+/**
+ * Draw Bitmap (page-native format) from RAM
+ * @param ssd1306
+ * @param start_page (0-7)
+ * @param start_column (0-127)
+ * @param width Width bitmap
+ * @param height Height bitmap
+ * @param bitmap Bitmap (from RAM)
+*/
+bool ssd1306_draw_buffer(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t start_column, uint8_t width, uint8_t height, const uint8_t* bitmap) {
+    bool is_ok;
+    const uint8_t pages = div_ceil(height, SSD1306_BITS_PER_COLUMN);
+    const uint8_t end_page = start_page + pages - 1;
+    const uint8_t end_column = start_column + width - 1;
+    is_ok = ssd1306_begin_data(ssd1306, start_page, end_page, start_column, end_column);
+
+    for (uint8_t page = 0; page < pages; page++) {
+        is_ok = is_ok && ssd1306_write_row(ssd1306, start_page + page, start_column, bitmap, width);
+        bitmap += width;
+    }
+    ssd1306_end_data(ssd1306);
+    return is_ok;
+}
+
+/**
+ * Deactivate Scroll (RESET)
+*/
+bool ssd1306_scroll_deactivate(const ssd1306_t* ssd1306) {
+    return ssd1306_send_command(ssd1306, SSD1306_DEACTIVATE_SCROLL_COMMAND);
+}
+
+// Moves the framebuffer copy of the area by one column, dirty_from..dirty_to columns are sent by the next flush
+static void ssd1306_scroll_framebuffer(ssd1306_framebuffer_t* framebuffer, ssd1306_scroll_direction_t direction, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column, uint8_t dirty_from, uint8_t dirty_to) {
+    for (uint8_t page = start_page; page <= end_page; page++) {
+        uint8_t* data = &framebuffer->data[page * SSD1306_WIDTH];
+        if (direction == SSD1306_SCROLL_LEFT) {
+            memmove(&data[start_column], &data[start_column + 1], end_column - start_column);
+        }
+        else {
+            memmove(&data[start_column + 1], &data[start_column], end_column - start_column);
+        }
+        ssd1306_mark_dirty(framebuffer, page, dirty_from);
+        ssd1306_mark_dirty(framebuffer, page, dirty_to);
+    }
+}
+
+/**
+ * Content Scroll
+ * Scrolls the area by one column, the vacated column is not defined and must be redrawn.
+ * The content scroll commands (0x2C/0x2D) are not in the command table of the original SSD1306,
+ * only of the later controllers (SSD1306B, SSD1309, SSD1315). The original one takes their parameters
+ * as other commands, so they are sent only when built with SSD1306_CONTENT_SCROLL. Otherwise in
+ * framebuffer mode the whole area is redrawn by the next flush, in direct mode false is returned.
+ * The display needs at least 2 frames between two content scroll commands.
+ * In framebuffer mode pending changes are flushed first and the framebuffer is scrolled too.
+ * @param ssd1306
+ * @param direction
+ * @param start_page (0-7)
+ * @param end_page (0-7)
+ * @param start_column (0-127)
+ * @param end_column (0-127)
+*/
+bool ssd1306_scroll_content(const ssd1306_t* ssd1306, ssd1306_scroll_direction_t direction, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column) {
+    if (!is_valid_page(start_page) || !is_valid_page(end_page) || start_page > end_page ||
+        !is_valid_column(start_column) || !is_valid_column(end_column) || start_column >= end_column) {
+        return false;
+    }
+    ssd1306_framebuffer_t* framebuffer = ssd1306->framebuffer;
+
+#ifndef SSD1306_CONTENT_SCROLL
+    if (framebuffer == NULL) {
+        return false; // The caller redraws the area
+    }
+    ssd1306_scroll_framebuffer(framebuffer, direction, start_page, end_page, start_column, end_column, start_column, end_column);
+    return true;
+#else
+    const uint8_t commands[] = {
+        direction == SSD1306_SCROLL_LEFT ? SSD1306_LEFT_CONTENT_SCROLL_COMMAND : SSD1306_RIGHT_CONTENT_SCROLL_COMMAND,
+        SSD1306_SCROLL_DUMMY_BYTE_00,
+        start_page,
+        SSD1306_SCROLL_DUMMY_BYTE_01,
+        end_page,
+        start_column,
+        end_column,
+    };
+    bool is_ok = ssd1306_flush(ssd1306);
+    is_ok = is_ok && ssd1306_send_commands(ssd1306, commands, sizeof(commands));
+    if (is_ok && framebuffer != NULL) {
+        // Only the vacated column differs from the display
+        const uint8_t vacated = direction == SSD1306_SCROLL_LEFT ? end_column : start_column;
+        ssd1306_scroll_framebuffer(framebuffer, direction, start_page, end_page, start_column, end_column, vacated, vacated);
+    }
+    return is_ok;
+#endif
+}
+
 ssd1306_config_t ssd1306_create_config(uint8_t i2c_address) {
     ssd1306_config_t settings = { .i2c_address = i2c_address };
 
@@ -368,7 +687,7 @@ ssd1306_config_t ssd1306_create_config(uint8_t i2c_address) {
     settings.inverse = false;
 
     // 2. Scrolling Command
-    // ...
+    // Scrolling is deactivated by ssd1306_init()
 
     // 3. Addressing Setting Command
     settings.memory_addressing_mode = SSD1306_MEMORY_ADDRESSING_MODE_HORIZONTAL;
@@ -399,7 +718,7 @@ ssd1306_config_t ssd1306_create_config(uint8_t i2c_address) {
 }
 
 ssd1306_t ssd1306_create(const ssd1306_config_t* settings) {
-    ssd1306_t ssd1306 = { .i2c_address = settings->i2c_address, .font = NULL };
+    ssd1306_t ssd1306 = { .i2c_address = settings->i2c_address, .font = NULL, .framebuffer = NULL };
     return ssd1306;
 };
 
@@ -419,29 +738,37 @@ bool ssd1306_init(const ssd1306_t* ssd1306, const ssd1306_config_t* config) {
     is_ok = is_ok && ssd1306_set_com_pins_hardware_config(ssd1306, config->com_alt_pin_config, config->com_disable_left_right_remap);
     is_ok = is_ok && ssd1306_set_segment_re_map(ssd1306, config->segment_re_map_inverse);
     is_ok = is_ok && ssd1306_set_charge_pump(ssd1306, config->charge_pump);
+    is_ok = is_ok && ssd1306_scroll_deactivate(ssd1306); // Scrolling survives MCU reset
     is_ok = is_ok && ssd1306_display_on(ssd1306);
     return is_ok;
 }
 
+/**
+ * Find glyph of the char
+ * @return Glyph (from PROGMEM) or NULL if the font has no glyph for the char
+*/
 ssd1306_bitmap_t ssd1306_find_char(char chr, const ssd1306_font_t* font) {
-    for (uint8_t i = 0; i < font->size; i++) {
-        if (font->data[i].letter == chr) {
-            return font->data[i].bitmap;
-        }
+    const uint8_t code = (uint8_t)chr;
+    if (code < font->first_char || code > font->last_char) {
+        return NULL;
+    }
+    const uint16_t offset = pgm_read_word(&font->offsets[code - font->first_char]);
+    if (offset == SSD1306_GLYPH_MISSING) {
+        return NULL;
     }
-    return NULL;
+    return font->bitmaps + offset;
 }
 
 void ssd1306_set_font(ssd1306_t* ssd1306, const ssd1306_font_t* font) {
     ssd1306->font = font;
 }
 
-bool ssd1306_print(ssd1306_t* ssd1306, const char* text, uint8_t start_page, uint8_t start_column) {
+/**
+ * Print text (row-major font)
+ * Every char is drawn as separate bitmap.
+*/
+static bool ssd1306_print_row_major(const ssd1306_t* ssd1306, const char* text, uint8_t start_page, uint8_t start_column) {
     const ssd1306_font_t* font = ssd1306->font;
-    if (font == NULL) {
-        return false;
-    }
-
     bool is_ok = true;
     uint8_t i = 0;
 
@@ -455,3 +782,149 @@ bool ssd1306_print(ssd1306_t* ssd1306, const char* text, uint8_t start_page, uin
     }
     return is_ok;
 }
+
+/**
+ * Print text to a field of fixed width
+ * With page-native font the area is set once for the whole field and all glyphs
+ * (letter spacing included) are sent in one data transaction.
+ * A shorter text is padded with blank cells, so it overwrites the previous value
+ * without clearing the display. Chars without glyph are printed as blank cells.
+ * The field is clipped at the right edge.
+ * @param ssd1306
+ * @param text
+ * @param width Width of the field in chars (a longer text is cut)
+ * @param start_page (0-7)
+ * @param start_column (0-127)
+*/
+bool ssd1306_print_field(const ssd1306_t* ssd1306, const char* text, uint8_t width, uint8_t start_page, uint8_t start_column) {
+    const ssd1306_font_t* font = ssd1306->font;
+    if (font == NULL) {
+        return false;
+    }
+    if (width == 0) {
+        return true;
+    }
+
+    const uint8_t pages = div_ceil(font->height, SSD1306_BITS_PER_COLUMN);
+    const uint8_t end_page = start_page + pages - 1;
+    uint16_t end_column = start_column + width * (font->width + font->letter_spacing) - font->letter_spacing - 1;
+    if (end_column > SSD1306_COLUMN_END_ADDRESS) {
+        end_column = SSD1306_COLUMN_END_ADDRESS;
+    }
+
+    uint8_t length = strlen(text);
+    if (length > width) {
+        length = width;
+    }
+
+    if (font->format != SSD1306_BITMAP_PAGED) {
+        char buff[length + 1];
+        memcpy(buff, text, length);
+        buff[length] = '\0';
+        const uint8_t padding_column = start_column + length * (font->width + font->letter_spacing);
+        bool is_ok = ssd1306_print_row_major(ssd1306, buff, start_page, start_column);
+        if (length < width) {
+            is_ok = is_ok && ssd1306_clear_rect(ssd1306, start_page, end_page, padding_column, end_column);
+        }
+        return is_ok;
+    }
+
+    bool is_ok = ssd1306_begin_data(ssd1306, start_page, end_page, start_column, end_column);
+    for (uint8_t page = 0; page < pages; page++) {
+        uint16_t column = start_column;
+        for (uint8_t i = 0; i < width && column <= end_column; i++) {
+            ssd1306_bitmap_t bitmap = i < length ? ssd1306_find_char(text[i], font) : NULL;
+            uint8_t glyph_width = font->width;
+            if (column + glyph_width > end_column + 1) {
+                glyph_width = end_column + 1 - column; // Clipped
+            }
+            if (bitmap != NULL) {
+                is_ok = is_ok && ssd1306_write_row_P(ssd1306, start_page + page, column, bitmap + page * font->width, glyph_width);
+            }
+            else {
+                is_ok = is_ok && ssd1306_write_repeat(ssd1306, start_page + page, column, 0x00, glyph_width);
+            }
+            column += glyph_width;
+
+            uint8_t spacing = font->letter_spacing;
+            if (column + spacing > end_column + 1) {
+                spacing = end_column + 1 - column;
+            }
+            is_ok = is_ok && ssd1306_write_repeat(ssd1306, start_page + page, column, 0x00, spacing);
+            column += spacing;
+        }
+    }
+    ssd1306_end_data(ssd1306);
+    return is_ok;
+}
+
+/**
+ * Print text
+ * See: ssd1306_print_field()
+ * @param ssd1306
+ * @param text
+ * @param start_page (0-7)
+ * @param start_column (0-127)
+*/
+bool ssd1306_print(const ssd1306_t* ssd1306, const char* text, uint8_t start_page, uint8_t start_column) {
+    return ssd1306_print_field(ssd1306, text, strlen(text), start_page, start_column);
+}
+
+ssd1306_text_field_t ssd1306_create_text_field(uint8_t page, uint8_t column, uint8_t width) {
+    ssd1306_text_field_t field = {
+        .page = page,
+        .column = column,
+        .width = width > SSD1306_TEXT_FIELD_SIZE ? SSD1306_TEXT_FIELD_SIZE : width,
+        .is_drawn = false,
+    };
+    return field;
+}
+
+/**
+ * Update text field
+ * Only the cells whose chars have changed are sent, e.g. "+21.4*" -> "+21.5*" sends one glyph.
+ * Every run of changed cells costs one area setup and one data transaction.
+ * Works without framebuffer.
+ * @param ssd1306
+ * @param field
+ * @param text A longer text than the field is cut, a shorter one is padded with blank cells
+*/
+bool ssd1306_update_text_field(const ssd1306_t* ssd1306, ssd1306_text_field_t* field, const char* text) {
+    const ssd1306_font_t* font = ssd1306->font;
+    if (font == NULL) {
+        return false;
+    }
+
+    const uint8_t cell_width = font->width + font->letter_spacing;
+    bool is_ok = true;
+    bool is_end = false;
+    uint8_t run_start = 0;
+    uint8_t run_length = 0;
+    char run[SSD1306_TEXT_FIELD_SIZE + 1];
+
+    for (uint8_t i = 0; i <= field->width; i++) {
+        bool is_changed = false;
+        if (i < field->width) {
+            is_end = is_end || text[i] == '\0';
+            const char chr = is_end ? ' ' : text[i];
+            is_changed = !field->is_drawn || field->text[i] != chr;
+            if (is_changed) {
+                if (run_length == 0) {
+                    run_start = i;
+                }
+                run[run_length++] = chr;
+            }
+        }
+        if (run_length > 0 && !is_changed) {
+            run[run_length] = '\0';
+            const bool is_run_ok = ssd1306_print_field(ssd1306, run, run_length, field->page, field->column + run_start * cell_width);
+            if (is_run_ok) {
+                memcpy(&field->text[run_start], run, run_length);
+            }
+            is_ok = is_ok && is_run_ok;
+            run_length = 0;
+        }
+    }
+    field->is_drawn = field->is_drawn || is_ok;
+    return is_ok;
+}
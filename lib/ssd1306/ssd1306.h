@@ -33,9 +33,20 @@ bool ssd1306_set_segment_re_map(const ssd1306_t* ssd1306, bool inverse);
 bool ssd1306_set_com_output_scan_direction(const ssd1306_t* ssd1306, bool remapped);
 bool ssd1306_set_zoom(const ssd1306_t* ssd1306, bool enabled);
 bool ssd1306_set_fade_out_and_blinking(const ssd1306_t* ssd1306, ssd1306_fade_out_blinking_mode_t mode, uint8_t time_interval);
+void ssd1306_set_framebuffer(ssd1306_t* ssd1306, ssd1306_framebuffer_t* framebuffer);
+bool ssd1306_flush(const ssd1306_t* ssd1306);
+bool ssd1306_fill_rect(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column, uint8_t pattern);
+bool ssd1306_clear_rect(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column);
 bool ssd1306_clear_display(const ssd1306_t* ssd1306);
 bool ssd1306_draw_bitmap(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t start_column, uint8_t width, uint8_t height, ssd1306_bitmap_t bitmap);
+bool ssd1306_draw_paged_bitmap(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t start_column, uint8_t width, uint8_t height, ssd1306_bitmap_t bitmap);
+bool ssd1306_draw_buffer(const ssd1306_t* ssd1306, uint8_t start_page, uint8_t start_column, uint8_t width, uint8_t height, const uint8_t* bitmap);
+bool ssd1306_scroll_deactivate(const ssd1306_t* ssd1306);
+bool ssd1306_scroll_content(const ssd1306_t* ssd1306, ssd1306_scroll_direction_t direction, uint8_t start_page, uint8_t end_page, uint8_t start_column, uint8_t end_column);
 void ssd1306_set_font(ssd1306_t* ssd1306, const ssd1306_font_t* font);
 bool ssd1306_print(const ssd1306_t* ssd1306, const char* text, uint8_t start_page, uint8_t start_column);
+bool ssd1306_print_field(const ssd1306_t* ssd1306, const char* text, uint8_t width, uint8_t start_page, uint8_t start_column);
+ssd1306_text_field_t ssd1306_create_text_field(uint8_t page, uint8_t column, uint8_t width);
+bool ssd1306_update_text_field(const ssd1306_t* ssd1306, ssd1306_text_field_t* field, const char* text);
 
 #endif // SSD1306_H
@@ -33,7 +33,16 @@
 #define SSD1306_DISPLAY_ON_COMMAND 0xAF // Display ON in normal mode
 
 // 2. Scrolling Command
-// ...
+#define SSD1306_RIGHT_CONTENT_SCROLL_COMMAND 0x2C // Content Scroll Setup. Scroll by one column (right). Not in the original SSD1306, see SSD1306_CONTENT_SCROLL
+#define SSD1306_LEFT_CONTENT_SCROLL_COMMAND 0x2D // Content Scroll Setup. Scroll by one column (left). Not in the original SSD1306
+#define SSD1306_DEACTIVATE_SCROLL_COMMAND 0x2E // Stop scrolling. The RAM data needs to be rewritten after it (RESET)
+#define SSD1306_SCROLL_DUMMY_BYTE_00 0x00
+#define SSD1306_SCROLL_DUMMY_BYTE_01 0x01
+
+typedef enum {
+    SSD1306_SCROLL_RIGHT = 0, // Content moves to higher column addresses
+    SSD1306_SCROLL_LEFT = 1 // Content moves to lower column addresses
+} ssd1306_scroll_direction_t;
 
 // 3. Addressing Setting Command
 // - Set Lower Column Start Address for Page Addressing Mode. This command is only for page addressing mode. 0x00~0x0F (0-15)
@@ -126,7 +135,7 @@ typedef struct {
     bool inverse;
 
     // 2. Scrolling Command
-    // ...
+    // Scrolling is deactivated by ssd1306_init()
 
     // 3. Addressing Setting Command
     ssd1306_memory_addressing_mode_t memory_addressing_mode;
@@ -157,22 +166,50 @@ typedef struct {
 
 const typedef uint8_t* ssd1306_bitmap_t;
 
-const typedef struct {
-    const char letter;
-    const ssd1306_bitmap_t bitmap;
-} ssd1306_letter_t;
+typedef enum {
+    SSD1306_BITMAP_ROW_MAJOR = 0, // Rows of pixels, 1 byte = 8 horizontal pixels (bit 0 = left pixel)
+    SSD1306_BITMAP_PAGED = 1, // Page by page, 1 byte = 8 vertical pixels of a column (bit 0 = top pixel)
+} ssd1306_bitmap_format_t;
+
+#define SSD1306_GLYPH_MISSING 0xFFFF // Offset of a char without glyph
 
+// Font with glyphs for a dense range of chars, first_char..last_char
 const typedef struct {
     const uint8_t width;
     const uint8_t height;
-    const uint8_t size;
     const uint8_t letter_spacing;
-    const ssd1306_letter_t* data;
+    const ssd1306_bitmap_format_t format;
+    const uint8_t first_char;
+    const uint8_t last_char;
+    const uint16_t* offsets; // Offset of the glyph in bitmaps for every char (from PROGMEM)
+    const uint8_t* bitmaps; // Glyphs (from PROGMEM)
 } ssd1306_font_t;
 
+#define SSD1306_PAGES (SSD1306_HEIGHT / SSD1306_BITS_PER_COLUMN) // quantity pages (8 rows of pixels each)
+#define SSD1306_DIRTY_NONE 0xFF // Start column of a clean page
+
+// Shadow copy of the display RAM (GDDRAM) with dirty columns tracked for every page
+typedef struct {
+    uint8_t data[SSD1306_DISPLAY_BYTES]; // Page by page, one byte per column
+    uint8_t dirty_start[SSD1306_PAGES]; // First changed column (SSD1306_DIRTY_NONE = clean page)
+    uint8_t dirty_end[SSD1306_PAGES]; // Last changed column
+} ssd1306_framebuffer_t;
+
+#define SSD1306_TEXT_FIELD_SIZE 12 // Max width of a text field in chars
+
+// Text at a fixed place of the display that remembers what is drawn
+typedef struct {
+    uint8_t page;
+    uint8_t column;
+    uint8_t width; // Width in chars (1 - SSD1306_TEXT_FIELD_SIZE)
+    bool is_drawn; // false = the whole field is sent on the next update
+    char text[SSD1306_TEXT_FIELD_SIZE]; // Chars on the display, blank cells are spaces
+} ssd1306_text_field_t;
+
 typedef struct {
     const uint8_t i2c_address;
     const ssd1306_font_t* font;
+    ssd1306_framebuffer_t* framebuffer; // NULL = draw directly to the display
 } ssd1306_t;
 
 #endif // SSD1306_DEF_H
@@ -0,0 +1,124 @@
+/**
+ * C Library for telemetry frames over UART
+ *
+ * Payload (little-endian):
+ *   type u8, sequence u16, status u8, time u32, UT u16, UP u32, temperature i16 (0.1 C),
+ *   pressure i32 (Pa), current u16 (uA), CRC-16/CCITT-FALSE u16 of the preceding bytes
+ * The payload is COBS-encoded and terminated by a zero byte, so a receiver finds the next frame
+ * after a lost byte. See tools/telemetry_decoder.py.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+#include <avr/sfr_defs.h>
+#include <util/crc16.h>
+#include "uart.h"
+#include "telemetry.h"
+
+#define TELEMETRY_CRC_INIT 0xFFFF
+#define TELEMETRY_TEXT_SIZE 64
+
+void telemetry_init(telemetry_t* telemetry) {
+    telemetry->sequence = 0;
+    telemetry->is_boot = true;
+}
+
+static uint8_t telemetry_put(uint8_t* data, uint8_t offset, uint32_t value, uint8_t size) {
+    for (uint8_t i = 0; i < size; i++) {
+        data[offset + i] = (uint8_t)value;
+        value >>= 8;
+    }
+    return offset + size;
+}
+
+// Consistent Overhead Byte Stuffing: zero bytes are replaced by the distance to the next zero
+static uint8_t telemetry_cobs_encode(const uint8_t* data, uint8_t length, uint8_t* output) {
+    uint8_t code_offset = 0;
+    uint8_t code = 1;
+    uint8_t offset = 1;
+    for (uint8_t i = 0; i < length; i++) {
+        if (data[i] != 0) {
+            output[offset++] = data[i];
+            code++;
+        }
+        if (data[i] == 0 || code == 0xFF) {
+            output[code_offset] = code;
+            code_offset = offset++;
+            code = 1;
+        }
+    }
+    output[code_offset] = code;
+    return offset;
+}
+
+static uint8_t telemetry_get_status(telemetry_t* telemetry, const telemetry_measurement_t* measurement) {
+    uint8_t status = measurement->status;
+    if (telemetry->is_boot) {
+        status |= _BV(TELEMETRY_STATUS_BOOT);
+        telemetry->is_boot = false;
+    }
+    return status;
+}
+
+/**
+ * Encode measurement frame
+ * @param telemetry
+ * @param measurement
+ * @param frame Buffer of TELEMETRY_FRAME_SIZE bytes
+ * @return Length of the frame including the zero delimiter
+*/
+uint8_t telemetry_encode(telemetry_t* telemetry, const telemetry_measurement_t* measurement, uint8_t* frame) {
+    uint8_t payload[TELEMETRY_PAYLOAD_SIZE];
+    uint8_t offset = 0;
+    offset = telemetry_put(payload, offset, TELEMETRY_FRAME_MEASUREMENT, 1);
+    offset = telemetry_put(payload, offset, telemetry->sequence++, 2);
+    offset = telemetry_put(payload, offset, telemetry_get_status(telemetry, measurement), 1);
+    offset = telemetry_put(payload, offset, measurement->time, 4);
+    offset = telemetry_put(payload, offset, measurement->UT, 2);
+    offset = telemetry_put(payload, offset, (uint32_t)measurement->UP, 4);
+    offset = telemetry_put(payload, offset, (uint16_t)measurement->temp, 2);
+    offset = telemetry_put(payload, offset, (uint32_t)measurement->press, 4);
+    offset = telemetry_put(payload, offset, measurement->current, 2);
+
+    uint16_t crc = TELEMETRY_CRC_INIT;
+    for (uint8_t i = 0; i < offset; i++) {
+        crc = _crc_xmodem_update(crc, payload[i]);
+    }
+    offset = telemetry_put(payload, offset, crc, 2);
+
+    const uint8_t length = telemetry_cobs_encode(payload, offset, frame);
+    frame[length] = 0;
+    return length + 1;
+}
+
+/**
+ * Send measurement as binary frame
+ * Does not wait, the frame is dropped if the UART buffer is full (the sequence number shows the gap).
+ * @param telemetry
+ * @param measurement
+*/
+bool telemetry_send(telemetry_t* telemetry, const telemetry_measurement_t* measurement) {
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    const uint8_t length = telemetry_encode(telemetry, measurement, frame);
+    return uart_write(frame, length);
+}
+
+/**
+ * Send measurement as text line
+ * Fields are separated by spaces: sequence, status, time, UT, UP, temperature, pressure, current.
+ * @param telemetry
+ * @param measurement
+*/
+bool telemetry_print(telemetry_t* telemetry, const telemetry_measurement_t* measurement) {
+    char text[TELEMETRY_TEXT_SIZE];
+    const uint8_t status = telemetry_get_status(telemetry, measurement);
+    snprintf_P(text, sizeof(text), PSTR("%u %02X %lu %u %ld %c%d.%d %ld %u\r\n"), telemetry->sequence++, status,
+        (unsigned long)measurement->time, measurement->UT, (long)measurement->UP, measurement->temp < 0 ? '-' : '+',
+        abs(measurement->temp / 10), abs(measurement->temp % 10), (long)measurement->press, measurement->current);
+    return uart_print(text);
+}
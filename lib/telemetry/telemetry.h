@@ -0,0 +1,42 @@
+/**
+ * C Library for telemetry frames over UART
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TELEMETRY_FRAME_MEASUREMENT 1 // Type of the frame, first byte of the payload
+#define TELEMETRY_PAYLOAD_SIZE 24 // Including CRC
+#define TELEMETRY_FRAME_SIZE (TELEMETRY_PAYLOAD_SIZE + 2) // COBS overhead and delimiter
+
+// Status flags of the measurement
+#define TELEMETRY_STATUS_VALID 0 // Measurement succeeded, otherwise values are from the previous one
+#define TELEMETRY_STATUS_BOOT 1 // First frame after reset
+#define TELEMETRY_STATUS_TENDENCY 2 // Pressure tendency is known
+
+typedef struct {
+    uint32_t time; // Time of the measurement (in seconds)
+    uint16_t UT; // Uncompensated temperature
+    int32_t UP; // Uncompensated pressure
+    int16_t temp; // Temperature in 0.1 C
+    int32_t press; // Pressure in Pa
+    uint16_t current; // Average current (in uA)
+    uint8_t status; // TELEMETRY_STATUS_* bits
+} telemetry_measurement_t;
+
+typedef struct {
+    uint16_t sequence; // Increments with every frame, gaps show lost frames
+    bool is_boot;
+} telemetry_t;
+
+void telemetry_init(telemetry_t* telemetry);
+uint8_t telemetry_encode(telemetry_t* telemetry, const telemetry_measurement_t* measurement, uint8_t* frame);
+bool telemetry_send(telemetry_t* telemetry, const telemetry_measurement_t* measurement);
+bool telemetry_print(telemetry_t* telemetry, const telemetry_measurement_t* measurement);
+
+#endif // TELEMETRY_H
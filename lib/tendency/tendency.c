@@ -0,0 +1,194 @@
+/**
+ * C Library for barometric tendency and forecast
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "tendency.h"
+
+// Thresholds of the tendency over 3 hours (in Pa)
+#define TENDENCY_STEADY_PA 10
+#define TENDENCY_SLOWLY_PA 150
+#define TENDENCY_NORMAL_PA 350
+#define TENDENCY_QUICKLY_PA 600
+
+// Zambretti letters for the falling, steady and rising pressure
+static const char PROGMEM zambretti_falling[] = "ABDHORUXZ";
+static const char PROGMEM zambretti_steady[] = "ABEKNPSWXZ";
+static const char PROGMEM zambretti_rising[] = "ABCFGIJLMQTYZ";
+
+/**
+ * Init tendency
+ * @param tendency
+ * @param interval Values averaged into one sample (1 = every value is a sample)
+*/
+void tendency_init(tendency_t* tendency, uint8_t interval) {
+    memset(tendency, 0, sizeof(tendency_t));
+    tendency->interval = interval == 0 ? 1 : interval;
+}
+
+static void tendency_push(tendency_t* tendency, int32_t pressure) {
+    if (tendency->count == 0) {
+        tendency->base = pressure;
+    }
+
+    int32_t delta = pressure - tendency->base;
+    if (delta > INT16_MAX) {
+        delta = INT16_MAX;
+    }
+    else if (delta < INT16_MIN) {
+        delta = INT16_MIN;
+    }
+
+    if (tendency->count == TENDENCY_WINDOW) {
+        // The oldest sample leaves, the others move one position down
+        const int16_t oldest = tendency->samples[tendency->head];
+        tendency->sum_y -= oldest;
+        tendency->sum_xy -= tendency->sum_y;
+        tendency->head = (tendency->head + 1) % TENDENCY_WINDOW;
+        tendency->count--;
+    }
+
+    tendency->samples[(tendency->head + tendency->count) % TENDENCY_WINDOW] = (int16_t)delta;
+    tendency->sum_y += delta;
+    tendency->sum_xy += (int32_t)tendency->count * delta;
+    tendency->count++;
+}
+
+/**
+ * Add pressure
+ * Every sample costs O(1): the sums of the least squares line are updated, not recomputed.
+ * @param tendency
+ * @param pressure in Pa
+ * @return true if a new sample is added to the window
+*/
+bool tendency_add(tendency_t* tendency, int32_t pressure) {
+    tendency->accumulator += pressure;
+    tendency->accumulated++;
+    if (tendency->accumulated < tendency->interval) {
+        return false;
+    }
+    const int32_t sample = (tendency->accumulator + tendency->interval / 2) / tendency->interval;
+    tendency->accumulator = 0;
+    tendency->accumulated = 0;
+    tendency_push(tendency, sample);
+    return true;
+}
+
+/**
+ * Change of pressure over the window by the least squares line
+ * @param tendency
+ * @param change in Pa per TENDENCY_WINDOW samples (3 hours)
+ * @return false if there are not enough samples
+*/
+bool tendency_get_change(const tendency_t* tendency, int32_t* change) {
+    const int32_t n = tendency->count;
+    if (n < TENDENCY_MIN_SAMPLES) {
+        return false;
+    }
+    // slope = (n * Sxy - Sx * Sy) / (n * Sxx - Sx^2), where Sx = n(n-1)/2 and Sxx = (n-1)n(2n-1)/6
+    const int32_t sum_x = n * (n - 1) / 2;
+    const int32_t denominator = n * n * (n * n - 1) / 12;
+    int64_t numerator = ((int64_t)n * tendency->sum_xy - (int64_t)sum_x * tendency->sum_y) * TENDENCY_WINDOW;
+    numerator += numerator >= 0 ? denominator / 2 : -denominator / 2; // Rounded
+    *change = numerator / denominator;
+    return true;
+}
+
+/**
+ * Barometric tendency over 3 hours
+*/
+tendency_category_t tendency_get_category(const tendency_t* tendency) {
+    int32_t change;
+    if (!tendency_get_change(tendency, &change)) {
+        return TENDENCY_UNKNOWN;
+    }
+
+    const int32_t value = change < 0 ? -change : change;
+    tendency_category_t category;
+    if (value < TENDENCY_STEADY_PA) {
+        return TENDENCY_STEADY;
+    }
+    else if (value <= TENDENCY_SLOWLY_PA) {
+        category = TENDENCY_RISING_SLOWLY;
+    }
+    else if (value <= TENDENCY_NORMAL_PA) {
+        category = TENDENCY_RISING;
+    }
+    else if (value <= TENDENCY_QUICKLY_PA) {
+        category = TENDENCY_RISING_QUICKLY;
+    }
+    else {
+        category = TENDENCY_RISING_VERY_RAPIDLY;
+    }
+    if (change < 0) {
+        category += TENDENCY_FALLING_SLOWLY - TENDENCY_RISING_SLOWLY;
+    }
+    return category;
+}
+
+static char tendency_read_letter(const char* letters, uint8_t length, int32_t index) {
+    if (index < 0) {
+        index = 0;
+    }
+    else if (index >= length) {
+        index = length - 1;
+    }
+    return pgm_read_byte(&letters[index]);
+}
+
+/**
+ * Zambretti forecast
+ * Slow changes (up to 1.5 hPa in 3 hours) count as steady pressure.
+ * Seasonal and wind corrections are not applied.
+ * @param tendency
+ * @param sea_level_pressure in Pa
+ * @return Letter from 'A' (settled fine) to 'Z' (stormy, much rain), '\0' if the tendency is unknown
+*/
+char tendency_get_zambretti(const tendency_t* tendency, int32_t sea_level_pressure) {
+    int32_t change;
+    if (!tendency_get_change(tendency, &change)) {
+        return '\0';
+    }
+
+    // Z = 127 - 0.12 P (falling), 144 - 0.13 P (steady), 185 - 0.16 P (rising), P in hPa
+    if (change < -TENDENCY_SLOWLY_PA) {
+        const int32_t z = 127 - (sea_level_pressure * 12 + 5000) / 10000;
+        return tendency_read_letter(zambretti_falling, sizeof(zambretti_falling) - 1, z - 1);
+    }
+    if (change > TENDENCY_SLOWLY_PA) {
+        const int32_t z = 185 - (sea_level_pressure * 16 + 5000) / 10000;
+        return tendency_read_letter(zambretti_rising, sizeof(zambretti_rising) - 1, z - 20);
+    }
+    const int32_t z = 144 - (sea_level_pressure * 13 + 5000) / 10000;
+    return tendency_read_letter(zambretti_steady, sizeof(zambretti_steady) - 1, z - 10);
+}
+
+/**
+ * Forecast for the glyph
+ * Zambretti letters are grouped into five forecasts.
+ * Unknown tendency is reported as changeable.
+*/
+tendency_forecast_t tendency_get_forecast(const tendency_t* tendency, int32_t sea_level_pressure) {
+    const char letter = tendency_get_zambretti(tendency, sea_level_pressure);
+    if (letter == '\0') {
+        return TENDENCY_FORECAST_CHANGEABLE;
+    }
+    if (letter <= 'B') {
+        return TENDENCY_FORECAST_SETTLED;
+    }
+    if (letter <= 'F') {
+        return TENDENCY_FORECAST_FAIR;
+    }
+    if (letter <= 'M') {
+        return TENDENCY_FORECAST_CHANGEABLE;
+    }
+    if (letter <= 'T') {
+        return TENDENCY_FORECAST_RAIN;
+    }
+    return TENDENCY_FORECAST_STORMY;
+}
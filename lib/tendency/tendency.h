@@ -0,0 +1,62 @@
+/**
+ * C Library for barometric tendency and forecast
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef TENDENCY_H
+#define TENDENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TENDENCY_WINDOW 60 // Samples in the sliding window, 3 hours at one sample per 3 minutes
+#define TENDENCY_MIN_SAMPLES 10 // Samples needed for the tendency
+
+// Barometric tendency over 3 hours
+typedef enum {
+    TENDENCY_UNKNOWN = 0, // Not enough samples
+    TENDENCY_STEADY = 1, // Under 0.1 hPa
+    TENDENCY_RISING_SLOWLY = 2, // 0.1-1.5 hPa
+    TENDENCY_RISING = 3, // 1.6-3.5 hPa
+    TENDENCY_RISING_QUICKLY = 4, // 3.6-6.0 hPa
+    TENDENCY_RISING_VERY_RAPIDLY = 5, // Over 6.0 hPa
+    TENDENCY_FALLING_SLOWLY = 6,
+    TENDENCY_FALLING = 7,
+    TENDENCY_FALLING_QUICKLY = 8,
+    TENDENCY_FALLING_VERY_RAPIDLY = 9,
+} tendency_category_t;
+
+typedef enum {
+    TENDENCY_FORECAST_SETTLED = 0, // Zambretti A-B
+    TENDENCY_FORECAST_FAIR = 1, // C-F
+    TENDENCY_FORECAST_CHANGEABLE = 2, // G-M
+    TENDENCY_FORECAST_RAIN = 3, // N-T
+    TENDENCY_FORECAST_STORMY = 4, // U-Z
+} tendency_forecast_t;
+
+typedef struct {
+    // Averaging of input values, one sample per interval values
+    uint8_t interval;
+    uint8_t accumulated;
+    int32_t accumulator;
+
+    // Ring buffer of samples, stored as deltas from the first value
+    int32_t base;
+    int16_t samples[TENDENCY_WINDOW];
+    uint8_t head; // Position of the oldest sample
+    uint8_t count;
+
+    // Running sums for the least squares line, x is the position in the window (0 = oldest)
+    int32_t sum_y;
+    int32_t sum_xy;
+} tendency_t;
+
+void tendency_init(tendency_t* tendency, uint8_t interval);
+bool tendency_add(tendency_t* tendency, int32_t pressure);
+bool tendency_get_change(const tendency_t* tendency, int32_t* change);
+tendency_category_t tendency_get_category(const tendency_t* tendency);
+char tendency_get_zambretti(const tendency_t* tendency, int32_t sea_level_pressure);
+tendency_forecast_t tendency_get_forecast(const tendency_t* tendency, int32_t sea_level_pressure);
+
+#endif // TENDENCY_H
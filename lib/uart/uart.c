@@ -0,0 +1,105 @@
+/**
+ * C Library for interrupt-driven UART transmitter
+ * Bytes are queued in a ring buffer and sent by the Data Register Empty interrupt.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "bitwise.h"
+#include "uart.h"
+
+#define UART_TX_BUFFER_MASK (UART_TX_BUFFER_SIZE - 1)
+
+static uint8_t tx_buffer[UART_TX_BUFFER_SIZE];
+static volatile uint8_t tx_head; // Next byte to write
+static volatile uint8_t tx_tail; // Next byte to send
+static bool is_transmitting; // Last byte may still be in the shift register
+
+ISR(USART_UDRE_vect) {
+    if (tx_head == tx_tail) {
+        clear_bit(UCSR0B, UDRIE0);
+        return;
+    }
+    UDR0 = tx_buffer[tx_tail];
+    tx_tail = (tx_tail + 1) & UART_TX_BUFFER_MASK;
+}
+
+/**
+ * Init UART transmitter, 8N1 frame
+ * @param baud_rate
+*/
+void uart_init(uint32_t baud_rate) {
+    tx_head = 0;
+    tx_tail = 0;
+    is_transmitting = false;
+    UBRR0 = (F_CPU / 8 / baud_rate) - 1; // Double speed mode has lower error at 115200
+    UCSR0A = _BV(U2X0);
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+    UCSR0B = _BV(TXEN0);
+}
+
+/**
+ * Get free space of the buffer
+*/
+uint8_t uart_get_free(void) {
+    return UART_TX_BUFFER_MASK - ((tx_head - tx_tail) & UART_TX_BUFFER_MASK);
+}
+
+/**
+ * Queue data
+ * Does not wait, the data is queued only if it fits whole into the buffer.
+ * @param data
+ * @param length
+*/
+bool uart_write(const uint8_t* data, uint8_t length) {
+    if (length > uart_get_free()) {
+        return false;
+    }
+    uint8_t head = tx_head;
+    for (uint8_t i = 0; i < length; i++) {
+        tx_buffer[head] = data[i];
+        head = (head + 1) & UART_TX_BUFFER_MASK;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        tx_head = head;
+        set_bit(UCSR0A, TXC0); // Cleared by writing one
+        set_bit(UCSR0B, UDRIE0);
+    }
+    is_transmitting = true;
+    return true;
+}
+
+/**
+ * Queue text
+ * @param text
+*/
+bool uart_print(const char* text) {
+    return uart_write((const uint8_t*)text, strlen(text));
+}
+
+/**
+ * Check whether bytes are still being sent
+ * The UART stops in power-down, the CPU must not sleep while it is busy.
+*/
+bool uart_is_busy(void) {
+    if (tx_head != tx_tail) {
+        return true;
+    }
+    if (is_transmitting && bit_is_set(UCSR0A, TXC0)) {
+        is_transmitting = false;
+    }
+    return is_transmitting;
+}
+
+/**
+ * Wait until all queued bytes are sent
+*/
+void uart_flush(void) {
+    while (uart_is_busy()) {}
+}
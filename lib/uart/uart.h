@@ -0,0 +1,24 @@
+/**
+ * C Library for interrupt-driven UART transmitter
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef UART_TX_BUFFER_SIZE
+#define UART_TX_BUFFER_SIZE 64 // Power of two
+#endif
+
+void uart_init(uint32_t baud_rate);
+uint8_t uart_get_free(void);
+bool uart_write(const uint8_t* data, uint8_t length);
+bool uart_print(const char* text);
+bool uart_is_busy(void);
+void uart_flush(void);
+
+#endif // UART_H
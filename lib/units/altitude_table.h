@@ -0,0 +1,28 @@
+#ifndef ALTITUDE_TABLE_H
+#define ALTITUDE_TABLE_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// Generated by tools/units_table.py
+#define ALTITUDE_TABLE_RATIO_MIN 16384 // Q15 pressure ratio of the first entry
+#define ALTITUDE_TABLE_RATIO_MAX 36864 // Q15 pressure ratio of the last entry
+#define ALTITUDE_TABLE_STEP_SHIFT 8
+#define ALTITUDE_TABLE_SIZE 81
+
+// Altitude in 0.1 m for every step of the pressure ratio
+static const int32_t PROGMEM altitude_table[] = {
+    54780, 53632, 52498, 51378, 50272, 49179, 48098, 47030,
+    45974, 44929, 43897, 42875, 41865, 40865, 39875, 38896,
+    37927, 36968, 36018, 35077, 34146, 33223, 32310, 31405,
+    30508, 29619, 28739, 27866, 27001, 26144, 25294, 24451,
+    23616, 22787, 21966, 21151, 20343, 19541, 18746, 17957,
+    17174, 16398, 15627, 14862, 14103, 13350, 12602, 11859,
+    11122, 10391, 9664, 8943, 8227, 7516, 6809, 6108,
+    5411, 4719, 4032, 3349, 2670, 1996, 1327, 661,
+    0, -657, -1310, -1959, -2603, -3244, -3881, -4514,
+    -5144, -5769, -6391, -7010, -7624, -8235, -8843, -9447,
+    -10048,
+};
+
+#endif // ALTITUDE_TABLE_H
\ No newline at end of file
@@ -0,0 +1,125 @@
+/**
+ * C Library for conversion of pressure units
+ * Integer arithmetic only, the accuracy is checked by test/test_units.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "units.h"
+#include "altitude_table.h"
+
+#define UNITS_RATIO_SHIFT 15 // Pressure ratio is Q15
+#define UNITS_RECIPROCAL_SHIFT 20
+#define UNITS_MMHG_RECIPROCAL 7865UL // 2^20 / 133.322
+#define UNITS_INHG_RECIPROCAL 30964UL // 2^20 * 100 / 3386.389
+
+#define ALTITUDE_TABLE_STEP (1 << ALTITUDE_TABLE_STEP_SHIFT)
+
+static uint16_t units_get_ratio(int32_t pressure, int32_t sea_level_pressure) {
+    if (pressure <= 0 || sea_level_pressure <= 0) {
+        return ALTITUDE_TABLE_RATIO_MIN;
+    }
+    if (pressure >= (1L << 17)) {
+        return ALTITUDE_TABLE_RATIO_MAX; // Shift would overflow
+    }
+    const uint32_t ratio = (((uint32_t)pressure << UNITS_RATIO_SHIFT) + sea_level_pressure / 2) / sea_level_pressure;
+    if (ratio < ALTITUDE_TABLE_RATIO_MIN) {
+        return ALTITUDE_TABLE_RATIO_MIN;
+    }
+    if (ratio > ALTITUDE_TABLE_RATIO_MAX) {
+        return ALTITUDE_TABLE_RATIO_MAX;
+    }
+    return ratio;
+}
+
+static int32_t units_read_altitude(uint8_t index) {
+    return (int32_t)pgm_read_dword(&altitude_table[index]);
+}
+
+/**
+ * Pressure to altitude
+ * Linear interpolation of the international barometric formula,
+ * error is under 0.72 m from -1000 to 5400 m, outside the altitude is clamped.
+ * @param pressure in Pa
+ * @param sea_level_pressure in Pa (UNITS_STANDARD_PRESSURE or QNH)
+ * @return Altitude in 0.1 m
+*/
+int32_t units_pressure_to_altitude(int32_t pressure, int32_t sea_level_pressure) {
+    const uint16_t offset = units_get_ratio(pressure, sea_level_pressure) - ALTITUDE_TABLE_RATIO_MIN;
+    const uint8_t index = offset >> ALTITUDE_TABLE_STEP_SHIFT;
+    const uint16_t fraction = offset & (ALTITUDE_TABLE_STEP - 1);
+    const int32_t altitude = units_read_altitude(index);
+    if (fraction == 0) {
+        return altitude;
+    }
+    const int32_t delta = units_read_altitude(index + 1) - altitude;
+    return altitude + ((delta * fraction + ALTITUDE_TABLE_STEP / 2) >> ALTITUDE_TABLE_STEP_SHIFT);
+}
+
+/**
+ * Sea level reduction (QNH) for a station altitude
+ * The pressure ratio of the altitude is found once, so every reduction costs one division.
+ * @param altitude Station altitude in 0.1 m (-1000 to 5400 m)
+*/
+units_qnh_t units_qnh_create(int32_t altitude) {
+    units_qnh_t qnh = { .altitude = altitude, .ratio = ALTITUDE_TABLE_RATIO_MIN };
+    if (altitude <= units_read_altitude(ALTITUDE_TABLE_SIZE - 1)) {
+        qnh.ratio = ALTITUDE_TABLE_RATIO_MAX;
+    }
+    else if (altitude < units_read_altitude(0)) {
+        // Altitude decreases with the ratio
+        uint8_t index = 0;
+        while (units_read_altitude(index + 1) > altitude) {
+            index++;
+        }
+        const int32_t high = units_read_altitude(index);
+        const int32_t span = high - units_read_altitude(index + 1);
+        const int32_t fraction = ((high - altitude) * ALTITUDE_TABLE_STEP + span / 2) / span;
+        qnh.ratio = ALTITUDE_TABLE_RATIO_MIN + ((uint16_t)index << ALTITUDE_TABLE_STEP_SHIFT) + fraction;
+    }
+    return qnh;
+}
+
+/**
+ * Station pressure to sea level pressure (QNH)
+ * Error is under 6 Pa for 950-1050 hPa at sea level (3.3 Pa up to 1000 m).
+ * @param pressure Station pressure in Pa
+ * @param qnh See units_qnh_create()
+ * @return Sea level pressure in Pa
+*/
+int32_t units_pressure_to_sea_level(int32_t pressure, const units_qnh_t* qnh) {
+    if (pressure <= 0 || pressure >= (1L << 17)) {
+        return pressure;
+    }
+    return (((uint32_t)pressure << UNITS_RATIO_SHIFT) + qnh->ratio / 2) / qnh->ratio;
+}
+
+/**
+ * Pressure to mmHg
+ * Truncated like the integer division, off by one for 0.25% of values next to a whole mmHg.
+ * @param pressure in Pa (0-120000)
+*/
+uint16_t units_pressure_to_mmhg(int32_t pressure) {
+    return ((uint32_t)pressure * UNITS_MMHG_RECIPROCAL) >> UNITS_RECIPROCAL_SHIFT;
+}
+
+/**
+ * Pressure to inHg
+ * Truncated like the integer division, off by one for 3% of values next to a whole 0.01 inHg.
+ * @param pressure in Pa (0-120000)
+ * @return Pressure in 0.01 inHg
+*/
+uint16_t units_pressure_to_inhg(int32_t pressure) {
+    return ((uint32_t)pressure * UNITS_INHG_RECIPROCAL) >> UNITS_RECIPROCAL_SHIFT;
+}
+
+/**
+ * Pressure to hPa
+ * @param pressure in Pa
+ * @return Pressure in 0.1 hPa, rounded
+*/
+uint16_t units_pressure_to_hpa(int32_t pressure) {
+    return (pressure + 5) / 10;
+}
@@ -0,0 +1,26 @@
+/**
+ * C Library for conversion of pressure units
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef UNITS_H
+#define UNITS_H
+
+#include <stdint.h>
+
+#define UNITS_STANDARD_PRESSURE 101325 // Pa
+
+typedef struct {
+    int32_t altitude; // Station altitude in 0.1 m
+    uint16_t ratio; // Station pressure / sea level pressure (Q15)
+} units_qnh_t;
+
+int32_t units_pressure_to_altitude(int32_t pressure, int32_t sea_level_pressure);
+units_qnh_t units_qnh_create(int32_t altitude);
+int32_t units_pressure_to_sea_level(int32_t pressure, const units_qnh_t* qnh);
+uint16_t units_pressure_to_mmhg(int32_t pressure);
+uint16_t units_pressure_to_inhg(int32_t pressure);
+uint16_t units_pressure_to_hpa(int32_t pressure);
+
+#endif // UNITS_H
@@ -0,0 +1,20 @@
+/**
+ * Native build: EEPROM is simulated by native/src/native.c, a write takes 3.4 ms of virtual time
+*/
+
+#ifndef NATIVE_AVR_EEPROM_H
+#define NATIVE_AVR_EEPROM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define E2END 0x3FF
+#define EEMEM
+
+uint8_t eeprom_read_byte(const uint8_t* address);
+void eeprom_write_byte(uint8_t* address, uint8_t value);
+void eeprom_update_byte(uint8_t* address, uint8_t value);
+void eeprom_read_block(void* destination, const void* source, size_t length);
+void eeprom_update_block(const void* source, void* destination, size_t length);
+
+#endif // NATIVE_AVR_EEPROM_H
@@ -0,0 +1,20 @@
+/**
+ * Native build: interrupts
+ * An ISR is a plain function, it is called by native/src/native.c when the simulated peripheral fires.
+*/
+
+#ifndef NATIVE_AVR_INTERRUPT_H
+#define NATIVE_AVR_INTERRUPT_H
+
+#define ISR(vector, ...) void vector(void)
+
+#define TIMER0_COMPA_vect native_isr_timer0_compa
+#define TIMER1_OVF_vect native_isr_timer1_ovf
+#define WDT_vect native_isr_wdt
+#define USART_UDRE_vect native_isr_usart_udre
+#define TWI_vect native_isr_twi
+
+void sei(void);
+void cli(void);
+
+#endif // NATIVE_AVR_INTERRUPT_H
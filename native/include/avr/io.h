@@ -0,0 +1,94 @@
+/**
+ * Native build: registers of ATmega328P used by the firmware
+ * Registers are plain variables, peripherals that drive interrupts are simulated by native/src/native.c.
+*/
+
+#ifndef NATIVE_AVR_IO_H
+#define NATIVE_AVR_IO_H
+
+#include <stdint.h>
+#include <avr/sfr_defs.h>
+
+extern volatile uint8_t DDRB, PORTB, PINB;
+extern volatile uint8_t MCUSR, WDTCSR, ADCSRA, ACSR, SMCR, PRR;
+extern volatile uint8_t TCCR0A, TCCR0B, OCR0A, TIMSK0, TIFR0;
+extern volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TIFR1;
+extern volatile uint8_t UCSR0A, UCSR0B, UCSR0C;
+extern volatile uint16_t UBRR0;
+extern volatile uint8_t TWBR, TWSR, TWDR;
+extern volatile uint8_t SREG;
+
+// TWI operations start when the firmware writes TWINT, a busy wait on TWINT or TWSTO moves the clock to their end
+volatile uint8_t* native_twi_control(void);
+#define TWCR (*native_twi_control())
+
+// Timer1 is started and stopped by TCCR1B, the simulator looks at it on every access of the counter
+volatile uint16_t* native_timer1_counter(void);
+#define TCNT1 (*native_timer1_counter())
+
+// Only the USART interrupt writes the data register, every access starts sending the byte
+volatile uint8_t* native_uart_data(void);
+#define UDR0 (*native_uart_data())
+
+// SREG
+#define SREG_I 7
+
+// Port B
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+
+// MCUSR
+#define WDRF 3
+
+// WDTCSR
+#define WDP0 0
+#define WDP1 1
+#define WDP2 2
+#define WDE 3
+#define WDCE 4
+#define WDP3 5
+#define WDIE 6
+#define WDIF 7
+
+// ADCSRA, ACSR
+#define ADEN 7
+#define ACD 7
+
+// Timer0
+#define WGM00 0
+#define WGM01 1
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define OCIE0A 1
+#define OCF0A 1
+
+// Timer1
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define TOIE1 0
+#define TOV1 0
+
+// USART0
+#define U2X0 1
+#define UDRE0 5
+#define TXC0 6
+#define UCSZ00 1
+#define UCSZ01 2
+#define TXEN0 3
+#define UDRIE0 5
+
+// TWI
+#define TWIE 0
+#define TWEN 2
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+
+#endif // NATIVE_AVR_IO_H
@@ -0,0 +1,14 @@
+/**
+ * Native build: bit macros of avr-libc
+*/
+
+#ifndef NATIVE_AVR_SFR_DEFS_H
+#define NATIVE_AVR_SFR_DEFS_H
+
+#define _BV(bit) (1 << (bit))
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((sfr) & _BV(bit)))
+#define loop_until_bit_is_set(sfr, bit) do { } while (bit_is_clear(sfr, bit))
+#define loop_until_bit_is_clear(sfr, bit) do { } while (bit_is_set(sfr, bit))
+
+#endif // NATIVE_AVR_SFR_DEFS_H
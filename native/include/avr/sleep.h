@@ -0,0 +1,20 @@
+/**
+ * Native build: sleep moves the virtual clock to the next interrupt
+*/
+
+#ifndef NATIVE_AVR_SLEEP_H
+#define NATIVE_AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC 1
+#define SLEEP_MODE_PWR_DOWN 2
+#define SLEEP_MODE_PWR_SAVE 3
+#define SLEEP_MODE_STANDBY 6
+
+void set_sleep_mode(int mode);
+void sleep_cpu(void);
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_mode() sleep_cpu()
+
+#endif // NATIVE_AVR_SLEEP_H
@@ -0,0 +1,12 @@
+/**
+ * Native build: interrupts only run when the virtual clock moves, a block is always atomic
+*/
+
+#ifndef NATIVE_UTIL_ATOMIC_H
+#define NATIVE_UTIL_ATOMIC_H
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type) for (int native_atomic = 1; native_atomic; native_atomic = 0)
+
+#endif // NATIVE_UTIL_ATOMIC_H
@@ -0,0 +1,15 @@
+/**
+ * Native build: delays move the virtual clock, they don't wait
+*/
+
+#ifndef NATIVE_UTIL_DELAY_H
+#define NATIVE_UTIL_DELAY_H
+
+#include <stdint.h>
+
+void native_delay_ns(uint64_t ns);
+
+#define _delay_us(us) native_delay_ns((uint64_t)((us) * 1000.0))
+#define _delay_ms(ms) native_delay_ns((uint64_t)((ms) * 1000000.0))
+
+#endif // NATIVE_UTIL_DELAY_H
@@ -0,0 +1,652 @@
+/**
+ * Native build: simulated ATmega328P peripherals
+ *
+ * Timer0 and Timer1 stop in power-down, the watchdog keeps running with its oscillator error.
+ * The UART sends to NATIVE_UART (file or "-" for stdout), the EEPROM is kept in NATIVE_EEPROM.
+ * The run ends after NATIVE_DURATION seconds of virtual time, the display is then exported
+ * to NATIVE_PBM. The TWI runs lib/i2c/i2c.c as on the chip: every START, STOP and byte takes
+ * its bus time and sets TWINT, the devices behind it are configured by the NATIVE_BMP180_* variables,
+ * with NATIVE_BMP180_SENSORS > 1 the sensors are behind a TCA9548A mux, see README.md.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include <avr/eeprom.h>
+#include <util/twi.h>
+#include "bitwise.h"
+#include "i2c_native.h"
+#include "sim_bmp180.h"
+#include "sim_ssd1306.h"
+#include "sim_tca9548a.h"
+#include "native.h"
+
+#define NATIVE_NS_PER_S 1000000000ULL
+#define NATIVE_WDT_TICK_NS 16000000ULL // 2048 cycles of the 128 kHz oscillator
+#define NATIVE_UART_FRAME_BITS 10 // 8N1
+#define NATIVE_EEPROM_SIZE (E2END + 1)
+#define NATIVE_SSD1306_I2C_ADDRESS 0x3C
+#define NATIVE_BMP180_I2C_ADDRESS 0x77
+#define NATIVE_TCA9548A_I2C_ADDRESS 0x70
+#define NATIVE_MAX_BMP180 4 // Sensors behind the mux, see NATIVE_BMP180_SENSORS
+#define NATIVE_TWI_BYTE_NS 22500 // 9 bits at 400 kHz
+#define NATIVE_TWI_CONDITION_NS 2500 // START or STOP
+#define NATIVE_TWCR_UNWRITTEN _BV(1) // Reserved bit of TWCR, reads as one until the firmware writes the register
+
+// Bus phase of the TWI master
+typedef enum {
+    NATIVE_TWI_IDLE = 0, // No START or after STOP
+    NATIVE_TWI_ADDRESS = 1, // After START, TWDR is SLA+R/W
+    NATIVE_TWI_TRANSMIT = 2,
+    NATIVE_TWI_RECEIVE = 3,
+    NATIVE_TWI_BUS_ERROR = 4, // Until TWSTO releases the lines
+} native_twi_phase_t;
+
+volatile uint8_t DDRB, PORTB, PINB;
+volatile uint8_t MCUSR, WDTCSR, ADCSRA, ACSR, SMCR, PRR;
+volatile uint8_t TCCR0A, TCCR0B, OCR0A, TIMSK0, TIFR0;
+volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TIFR1;
+volatile uint8_t UCSR0A = _BV(UDRE0), UCSR0B, UCSR0C;
+volatile uint16_t UBRR0;
+volatile uint8_t TWBR, TWSR, TWDR;
+volatile uint8_t SREG;
+
+void native_isr_timer0_compa(void);
+void native_isr_timer1_ovf(void);
+void native_isr_wdt(void);
+void native_isr_usart_udre(void);
+void native_isr_twi(void);
+
+static uint64_t now_ns;
+static uint64_t duration_ns;
+static struct timespec host_start;
+static bool is_in_interrupt;
+static bool is_power_down;
+static int sleep_mode;
+static uint32_t interrupts;
+static uint32_t sleeps;
+static uint64_t power_down_ns;
+
+static uint64_t timer0_phase_ns;
+static volatile uint16_t timer1_count;
+static uint64_t timer1_phase_ns;
+static bool is_timer1_running;
+static uint64_t watchdog_phase_ns;
+static double watchdog_error;
+
+static volatile uint8_t uart_data;
+static bool is_uart_data_full; // UDR0 is written, not moved to the shift register yet
+static bool is_uart_shifting;
+static uint64_t uart_remaining_ns;
+static uint32_t uart_bytes;
+static FILE* uart_file;
+
+static volatile uint8_t twi_control = NATIVE_TWCR_UNWRITTEN; // TWCR as read by the firmware
+static bool is_twi_flag; // TWINT, the operation is complete
+static bool is_twi_running;
+static uint64_t twi_remaining_ns;
+static uint8_t twi_operation; // TWCR that started the running operation
+static native_twi_phase_t twi_phase;
+static bool is_twi_bus_error; // See native_twi_bus_error()
+
+static uint8_t eeprom[NATIVE_EEPROM_SIZE];
+static uint32_t eeprom_writes;
+static uint32_t eeprom_writes_left = NATIVE_EEPROM_NO_LOSS; // See native_eeprom_lose_writes()
+
+static sim_bmp180_t bmp180[NATIVE_MAX_BMP180];
+static uint8_t bmp180_count;
+static sim_ssd1306_t ssd1306;
+static sim_tca9548a_t tca9548a;
+static i2c_device_t bmp180_devices[NATIVE_MAX_BMP180];
+static i2c_device_t ssd1306_device;
+static i2c_device_t tca9548a_device;
+static i2c_device_t tca9548a_channel_device;
+
+static uint64_t native_min(uint64_t a, uint64_t b) {
+    return a < b ? a : b;
+}
+
+// Time of one count of the clock select bits CS2:0, 0 = stopped
+static uint64_t native_timer_tick_ns(uint8_t control) {
+    static const uint16_t prescalers[] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+    return (uint64_t)prescalers[control & 0x07] * NATIVE_NS_PER_S / F_CPU;
+}
+
+static uint64_t native_timer0_period_ns(void) {
+    return native_timer_tick_ns(TCCR0B) * (OCR0A + 1);
+}
+
+static uint64_t native_watchdog_period_ns(void) {
+    const uint8_t prescaler = (WDTCSR & 0x07) | (bit_is_set(WDTCSR, WDP3) ? 0x08 : 0);
+    return (uint64_t)((double)(NATIVE_WDT_TICK_NS << prescaler) * (1.0 + watchdog_error));
+}
+
+static uint64_t native_uart_byte_ns(void) {
+    const uint8_t divider = bit_is_set(UCSR0A, U2X0) ? 8 : 16;
+    return (uint64_t)divider * (UBRR0 + 1) * NATIVE_UART_FRAME_BITS * NATIVE_NS_PER_S / F_CPU;
+}
+
+// Timer1 is (re)started by the firmware after clearing TOV1, which is cleared by writing one
+static void native_timer1_update(void) {
+    const bool is_running = native_timer_tick_ns(TCCR1B) != 0;
+    if (is_running && !is_timer1_running) {
+        clear_bit(TIFR1, TOV1);
+        timer1_phase_ns = 0;
+    }
+    is_timer1_running = is_running;
+}
+
+volatile uint16_t* native_timer1_counter(void) {
+    native_timer1_update();
+    return &timer1_count;
+}
+
+volatile uint8_t* native_uart_data(void) {
+    is_uart_data_full = true;
+    clear_bit(UCSR0A, UDRE0);
+    return &uart_data;
+}
+
+// Moves the data register to the shift register, UDRE0 and TXC0 are read-only for the firmware
+static void native_uart_update(void) {
+    if (!is_uart_shifting && is_uart_data_full && bit_is_set(UCSR0B, TXEN0)) {
+        is_uart_data_full = false;
+        is_uart_shifting = true;
+        uart_remaining_ns = native_uart_byte_ns();
+        uart_bytes++;
+        if (uart_file != NULL) {
+            fputc(uart_data, uart_file);
+        }
+    }
+    if (is_uart_data_full) {
+        clear_bit(UCSR0A, UDRE0);
+    }
+    else {
+        set_bit(UCSR0A, UDRE0);
+    }
+    if (is_uart_shifting || is_uart_data_full) {
+        clear_bit(UCSR0A, TXC0);
+    }
+}
+
+// TWCR is written: TWINT starts the next operation (writing one clears the flag), other bits are taken as they are
+static void native_twi_update(void) {
+    if (twi_control & NATIVE_TWCR_UNWRITTEN) {
+        return;
+    }
+    const uint8_t control = twi_control;
+    twi_control = (control & ~_BV(TWINT)) | NATIVE_TWCR_UNWRITTEN;
+    if (bit_is_clear(control, TWINT)) {
+        if (is_twi_flag) {
+            set_bit(twi_control, TWINT);
+        }
+        return;
+    }
+    is_twi_flag = false;
+    if (twi_phase == NATIVE_TWI_BUS_ERROR && bit_is_set(control, TWSTO)) {
+        // The lines are released at once, no STOP is sent
+        i2c_native_stop();
+        twi_phase = NATIVE_TWI_IDLE;
+        clear_bit(twi_control, TWSTO);
+        return;
+    }
+    twi_operation = control;
+    is_twi_running = true;
+    if (bit_is_set(control, TWSTA)) {
+        twi_remaining_ns = bit_is_set(control, TWSTO) ? 2 * NATIVE_TWI_CONDITION_NS : NATIVE_TWI_CONDITION_NS;
+    }
+    else {
+        twi_remaining_ns = bit_is_set(control, TWSTO) ? NATIVE_TWI_CONDITION_NS : NATIVE_TWI_BYTE_NS;
+    }
+}
+
+// The condition or byte has reached the devices, TWINT is set (but not by STOP alone)
+static void native_twi_complete(void) {
+    const uint8_t control = twi_operation;
+    is_twi_running = false;
+    if (bit_is_set(control, TWSTO)) {
+        i2c_native_stop();
+        twi_phase = NATIVE_TWI_IDLE;
+        clear_bit(twi_control, TWSTO);
+        if (bit_is_clear(control, TWSTA)) {
+            return;
+        }
+    }
+    if (is_twi_bus_error || (twi_phase == NATIVE_TWI_IDLE && bit_is_clear(control, TWSTA))) {
+        // Injected by native_twi_bus_error() or a byte without START
+        is_twi_bus_error = false;
+        twi_phase = NATIVE_TWI_BUS_ERROR;
+        TWSR = TW_BUS_ERROR;
+    }
+    else if (bit_is_set(control, TWSTA)) {
+        TWSR = twi_phase == NATIVE_TWI_IDLE ? TW_START : TW_REP_START;
+        twi_phase = NATIVE_TWI_ADDRESS;
+    }
+    else if (twi_phase == NATIVE_TWI_ADDRESS) {
+        const i2c_mode_t mode = TWDR & 0x01 ? I2C_MODE_READ : I2C_MODE_WRITE;
+        const bool is_ack = i2c_native_start(TWDR >> 1, mode);
+        if (mode == I2C_MODE_READ) {
+            twi_phase = NATIVE_TWI_RECEIVE;
+            TWSR = is_ack ? TW_MR_SLA_ACK : TW_MR_SLA_NACK;
+        }
+        else {
+            twi_phase = NATIVE_TWI_TRANSMIT;
+            TWSR = is_ack ? TW_MT_SLA_ACK : TW_MT_SLA_NACK;
+        }
+    }
+    else if (twi_phase == NATIVE_TWI_TRANSMIT) {
+        TWSR = i2c_native_write(TWDR) ? TW_MT_DATA_ACK : TW_MT_DATA_NACK;
+    }
+    else {
+        const bool ack = bit_is_set(control, TWEA);
+        TWDR = i2c_native_read(ack);
+        TWSR = ack ? TW_MR_DATA_ACK : TW_MR_DATA_NACK;
+    }
+    is_twi_flag = true;
+    set_bit(twi_control, TWINT);
+}
+
+volatile uint8_t* native_twi_control(void) {
+    native_twi_update();
+    if (is_twi_running) {
+        native_delay_ns(twi_remaining_ns);
+    }
+    return &twi_control;
+}
+
+static bool native_is_twi_interrupt(void) {
+    native_twi_update();
+    return is_twi_flag && bit_is_set(twi_control, TWIE);
+}
+
+static uint64_t native_next_event_ns(void) {
+    uint64_t next = duration_ns > now_ns ? duration_ns - now_ns : 0;
+    if (bit_is_set(WDTCSR, WDIE)) {
+        next = native_min(next, native_watchdog_period_ns() - watchdog_phase_ns);
+    }
+    if (is_power_down) {
+        return next;
+    }
+    if (native_timer_tick_ns(TCCR0B) != 0) {
+        next = native_min(next, native_timer0_period_ns() - timer0_phase_ns);
+    }
+    native_timer1_update();
+    if (is_timer1_running) {
+        next = native_min(next, (0x10000 - timer1_count) * native_timer_tick_ns(TCCR1B) - timer1_phase_ns);
+    }
+    if (is_uart_shifting) {
+        next = native_min(next, uart_remaining_ns);
+    }
+    native_twi_update();
+    if (is_twi_running) {
+        next = native_min(next, twi_remaining_ns);
+    }
+    return next;
+}
+
+// Moves the clock at most to the next event, the interrupt flags are set but not served
+static void native_advance(uint64_t ns) {
+    now_ns += ns;
+    if (bit_is_set(WDTCSR, WDIE)) {
+        watchdog_phase_ns += ns;
+        if (watchdog_phase_ns >= native_watchdog_period_ns()) {
+            watchdog_phase_ns = 0;
+            set_bit(WDTCSR, WDIF);
+        }
+    }
+    if (is_power_down) {
+        power_down_ns += ns;
+    }
+    else {
+        if (native_timer_tick_ns(TCCR0B) != 0) {
+            timer0_phase_ns += ns;
+            if (timer0_phase_ns >= native_timer0_period_ns()) {
+                timer0_phase_ns = 0;
+                set_bit(TIFR0, OCF0A);
+            }
+        }
+        native_timer1_update();
+        if (is_timer1_running) {
+            const uint64_t tick_ns = native_timer_tick_ns(TCCR1B);
+            timer1_phase_ns += ns;
+            const uint32_t count = timer1_count + timer1_phase_ns / tick_ns;
+            timer1_phase_ns %= tick_ns;
+            if (count > 0xFFFF) {
+                set_bit(TIFR1, TOV1);
+            }
+            timer1_count = count;
+        }
+        if (is_uart_shifting) {
+            uart_remaining_ns -= ns;
+            if (uart_remaining_ns == 0) {
+                is_uart_shifting = false;
+                if (!is_uart_data_full) {
+                    set_bit(UCSR0A, TXC0);
+                }
+            }
+        }
+        if (is_twi_running) {
+            twi_remaining_ns -= ns;
+            if (twi_remaining_ns == 0) {
+                native_twi_complete();
+            }
+        }
+        native_uart_update();
+    }
+    if (now_ns >= duration_ns) {
+        native_exit();
+    }
+}
+
+static bool native_call_interrupt(void (*isr)(void)) {
+    is_in_interrupt = true;
+    clear_bit(SREG, SREG_I);
+    isr();
+    set_bit(SREG, SREG_I); // RETI
+    is_in_interrupt = false;
+    interrupts++;
+    return true;
+}
+
+// Serves one pending interrupt in order of the vector table
+static bool native_serve_interrupt(void) {
+    native_timer1_update();
+    native_uart_update();
+    if (bit_is_set(WDTCSR, WDIF) && bit_is_set(WDTCSR, WDIE)) {
+        clear_bit(WDTCSR, WDIF);
+        return native_call_interrupt(native_isr_wdt);
+    }
+    if (bit_is_set(TIFR1, TOV1) && bit_is_set(TIMSK1, TOIE1)) {
+        clear_bit(TIFR1, TOV1);
+        return native_call_interrupt(native_isr_timer1_ovf);
+    }
+    if (bit_is_set(TIFR0, OCF0A) && bit_is_set(TIMSK0, OCIE0A)) {
+        clear_bit(TIFR0, OCF0A);
+        return native_call_interrupt(native_isr_timer0_compa);
+    }
+    if (bit_is_set(UCSR0A, UDRE0) && bit_is_set(UCSR0B, UDRIE0)) {
+        return native_call_interrupt(native_isr_usart_udre);
+    }
+    if (native_is_twi_interrupt()) {
+        return native_call_interrupt(native_isr_twi); // TWINT is cleared by the ISR
+    }
+    return false;
+}
+
+static bool native_is_interrupt_pending(void) {
+    native_timer1_update();
+    native_uart_update();
+    return (bit_is_set(WDTCSR, WDIF) && bit_is_set(WDTCSR, WDIE))
+        || (bit_is_set(TIFR1, TOV1) && bit_is_set(TIMSK1, TOIE1))
+        || (bit_is_set(TIFR0, OCF0A) && bit_is_set(TIMSK0, OCIE0A))
+        || (bit_is_set(UCSR0A, UDRE0) && bit_is_set(UCSR0B, UDRIE0))
+        || native_is_twi_interrupt();
+}
+
+static void native_dispatch(void) {
+    if (bit_is_clear(SREG, SREG_I) || is_in_interrupt) {
+        return;
+    }
+    while (native_serve_interrupt()) {}
+}
+
+void sei(void) {
+    set_bit(SREG, SREG_I);
+    native_dispatch();
+}
+
+void cli(void) {
+    clear_bit(SREG, SREG_I);
+}
+
+uint64_t native_get_time_ns(void) {
+    return now_ns;
+}
+
+/**
+ * Busy wait, interrupts are served on time
+ * @param ns
+*/
+void native_delay_ns(uint64_t ns) {
+    while (ns > 0) {
+        const uint64_t step_ns = native_min(ns, native_next_event_ns());
+        native_advance(step_ns);
+        ns -= step_ns;
+        native_dispatch();
+    }
+}
+
+/**
+ * Make the next TWI operation end with a bus error (illegal START or STOP on the bus)
+*/
+void native_twi_bus_error(void) {
+    is_twi_bus_error = true;
+}
+
+void set_sleep_mode(int mode) {
+    sleep_mode = mode;
+}
+
+/**
+ * Sleep until an interrupt
+ * In power-down only the watchdog runs, the clock then needs NATIVE_WAKEUP_US to start.
+*/
+void sleep_cpu(void) {
+    if (bit_is_clear(SREG, SREG_I)) {
+        fprintf(stderr, "native: sleep with interrupts disabled never wakes up\n");
+        native_exit();
+    }
+    is_power_down = sleep_mode != SLEEP_MODE_IDLE && sleep_mode != SLEEP_MODE_ADC;
+    sleeps++;
+    while (!native_is_interrupt_pending()) {
+        native_advance(native_next_event_ns());
+    }
+    if (is_power_down) {
+        native_advance(NATIVE_WAKEUP_US * 1000ULL);
+        is_power_down = false;
+    }
+    native_dispatch();
+}
+
+void wdt_reset(void) {
+    watchdog_phase_ns = 0;
+}
+
+void wdt_disable(void) {
+    WDTCSR = 0;
+    watchdog_phase_ns = 0;
+}
+
+uint8_t eeprom_read_byte(const uint8_t* address) {
+    return eeprom[(uintptr_t)address % NATIVE_EEPROM_SIZE];
+}
+
+void eeprom_write_byte(uint8_t* address, uint8_t value) {
+    if (eeprom_writes_left == 0) {
+        return;
+    }
+    if (eeprom_writes_left != NATIVE_EEPROM_NO_LOSS) {
+        eeprom_writes_left--;
+    }
+    eeprom[(uintptr_t)address % NATIVE_EEPROM_SIZE] = value;
+    eeprom_writes++;
+    native_delay_ns(NATIVE_EEPROM_WRITE_US * 1000ULL);
+}
+
+void eeprom_update_byte(uint8_t* address, uint8_t value) {
+    if (eeprom_read_byte(address) != value) {
+        eeprom_write_byte(address, value);
+    }
+}
+
+void eeprom_read_block(void* destination, const void* source, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        ((uint8_t*)destination)[i] = eeprom_read_byte((const uint8_t*)source + i);
+    }
+}
+
+void eeprom_update_block(const void* source, void* destination, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        eeprom_update_byte((uint8_t*)destination + i, ((const uint8_t*)source)[i]);
+    }
+}
+
+/**
+ * Lose the EEPROM writes after the next ones, as if the power failed in the middle of a write
+ * @param writes Bytes that are still written (NATIVE_EEPROM_NO_LOSS = all, the power is back)
+*/
+void native_eeprom_lose_writes(uint32_t writes) {
+    eeprom_writes_left = writes;
+}
+
+// Bytes written to EEPROM, unchanged bytes of eeprom_update_byte() are not written
+uint32_t native_eeprom_get_writes(void) {
+    return eeprom_writes;
+}
+
+static double native_get_host_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - host_start.tv_sec) + (now.tv_nsec - host_start.tv_nsec) / 1e9;
+}
+
+/**
+ * End the run
+ * Exports the display, saves the EEPROM and prints the summary to stderr.
+*/
+void native_exit(void) {
+    const char* pbm_path = getenv("NATIVE_PBM");
+    if (pbm_path != NULL && !sim_ssd1306_export_pbm(&ssd1306, pbm_path)) {
+        fprintf(stderr, "native: can't write %s\n", pbm_path);
+    }
+    const char* eeprom_path = getenv("NATIVE_EEPROM");
+    if (eeprom_path != NULL) {
+        FILE* file = fopen(eeprom_path, "wb");
+        if (file != NULL) {
+            fwrite(eeprom, 1, sizeof(eeprom), file);
+            fclose(file);
+        }
+    }
+    if (uart_file != NULL) {
+        fflush(uart_file);
+    }
+    const double host_s = native_get_host_time();
+    const double virtual_s = (double)now_ns / NATIVE_NS_PER_S;
+    fprintf(stderr, "native: %.3f s in %.3f s (x%.0f), power-down %.1f %%, %u interrupts, %u sleeps\n",
+        virtual_s, host_s, host_s > 0 ? virtual_s / host_s : 0.0,
+        now_ns > 0 ? 100.0 * power_down_ns / now_ns : 0.0, interrupts, sleeps);
+    uint32_t conversions = 0;
+    for (uint8_t i = 0; i < bmp180_count; i++) {
+        conversions += bmp180[i].conversions;
+    }
+    fprintf(stderr, "native: BMP180 %u conversions, SSD1306 %u commands (%u unknown), %u data bytes, UART %u bytes, EEPROM %u writes\n",
+        conversions, ssd1306.commands, ssd1306.unknown_commands, ssd1306.data_bytes, uart_bytes, eeprom_writes);
+    exit(0);
+}
+
+static void native_parse(const char* name, double* values, uint8_t count) {
+    const char* text = getenv(name);
+    for (uint8_t i = 0; text != NULL && *text != '\0' && i < count; i++) {
+        char* end;
+        values[i] = strtod(text, &end);
+        if (end == text) {
+            fprintf(stderr, "native: bad value of %s\n", name);
+            exit(1);
+        }
+        text = *end == ',' ? end + 1 : end;
+    }
+}
+
+static sim_bmp180_trajectory_t native_parse_trajectory(const char* name, sim_bmp180_trajectory_t trajectory) {
+    double values[] = { trajectory.base, trajectory.slope, trajectory.amplitude, trajectory.period, trajectory.noise };
+    native_parse(name, values, 5);
+    return (sim_bmp180_trajectory_t){ values[0], values[1], values[2], values[3], values[4] };
+}
+
+// Devices are attached before main() of the firmware
+__attribute__((constructor))
+static void native_init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &host_start);
+
+    double duration_s = NATIVE_DURATION_S;
+    native_parse("NATIVE_DURATION", &duration_s, 1);
+    duration_ns = (uint64_t)(duration_s * NATIVE_NS_PER_S);
+    watchdog_error = NATIVE_WDT_ERROR;
+    native_parse("NATIVE_WDT_ERROR", &watchdog_error, 1);
+
+    const char* uart_path = getenv("NATIVE_UART");
+    if (uart_path != NULL) {
+        uart_file = strcmp(uart_path, "-") == 0 ? stdout : fopen(uart_path, "wb");
+        if (uart_file == NULL) {
+            fprintf(stderr, "native: can't write %s\n", uart_path);
+            exit(1);
+        }
+    }
+
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    const char* eeprom_path = getenv("NATIVE_EEPROM");
+    if (eeprom_path != NULL) {
+        FILE* file = fopen(eeprom_path, "rb");
+        if (file != NULL) {
+            fread(eeprom, 1, sizeof(eeprom), file);
+            fclose(file);
+        }
+    }
+
+    sim_bmp180_config_t bmp180_config = sim_bmp180_create_config();
+    double calibration[SIM_BMP180_CALIBRATION_SIZE];
+    for (uint8_t i = 0; i < SIM_BMP180_CALIBRATION_SIZE; i++) {
+        calibration[i] = bmp180_config.calibration[i];
+    }
+    native_parse("NATIVE_BMP180_CALIBRATION", calibration, SIM_BMP180_CALIBRATION_SIZE);
+    for (uint8_t i = 0; i < SIM_BMP180_CALIBRATION_SIZE; i++) {
+        bmp180_config.calibration[i] = (int32_t)calibration[i];
+    }
+    bmp180_config.temp = native_parse_trajectory("NATIVE_BMP180_TEMP", bmp180_config.temp);
+    bmp180_config.press = native_parse_trajectory("NATIVE_BMP180_PRESS", bmp180_config.press);
+    native_parse("NATIVE_BMP180_NOISE", bmp180_config.press_noise, SIM_BMP180_MODES);
+    double sensors = 1;
+    native_parse("NATIVE_BMP180_SENSORS", &sensors, 1);
+    bmp180_count = sensors < 1 ? 1 : sensors > NATIVE_MAX_BMP180 ? NATIVE_MAX_BMP180 : (uint8_t)sensors;
+    double offsets[NATIVE_MAX_BMP180] = {};
+    native_parse("NATIVE_BMP180_OFFSET", offsets, NATIVE_MAX_BMP180);
+    const double press_base = bmp180_config.press.base;
+    for (uint8_t i = 0; i < bmp180_count; i++) {
+        bmp180_config.press.base = press_base + offsets[i];
+        sim_bmp180_init(&bmp180[i], &bmp180_config);
+        bmp180[i].random += i; // Own noise of every sensor
+    }
+    sim_ssd1306_init(&ssd1306);
+    double content_scroll = 0; // Original SSD1306
+    native_parse("NATIVE_SSD1306_CONTENT_SCROLL", &content_scroll, 1);
+    ssd1306.has_content_scroll = content_scroll != 0;
+
+    for (uint8_t i = 0; i < bmp180_count; i++) {
+        bmp180_devices[i] = sim_bmp180_create_device(&bmp180[i], NATIVE_BMP180_I2C_ADDRESS);
+    }
+    if (bmp180_count > 1) {
+        // Sensors on channels 0...N-1 of the mux, see SENSOR_ARRAY
+        sim_tca9548a_init(&tca9548a);
+        for (uint8_t i = 0; i < bmp180_count; i++) {
+            sim_tca9548a_connect(&tca9548a, i, &bmp180_devices[i]);
+        }
+        tca9548a_device = sim_tca9548a_create_device(&tca9548a, NATIVE_TCA9548A_I2C_ADDRESS);
+        tca9548a_channel_device = sim_tca9548a_create_channel_device(&tca9548a, NATIVE_BMP180_I2C_ADDRESS);
+        i2c_native_attach(&tca9548a_device);
+        i2c_native_attach(&tca9548a_channel_device);
+    }
+    else {
+        i2c_native_attach(&bmp180_devices[0]);
+    }
+    ssd1306_device = sim_ssd1306_create_device(&ssd1306, NATIVE_SSD1306_I2C_ADDRESS);
+    i2c_native_attach(&ssd1306_device);
+}
@@ -0,0 +1,31 @@
+/**
+ * Native build: simulated ATmega328P peripherals
+ *
+ * Time is virtual: it moves only by delays, bus transfers, EEPROM writes and sleeping,
+ * so the firmware runs as fast as the host can execute it. Peripherals that fire
+ * interrupts (Timer0 compare, Timer1 overflow, watchdog, UART data register empty, TWI)
+ * are stepped along the virtual clock, their ISRs are called when interrupts are enabled.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NATIVE_DURATION_S 3600 // Default virtual run time, see NATIVE_DURATION
+#define NATIVE_WDT_ERROR 0.07 // Default error of the watchdog oscillator, see NATIVE_WDT_ERROR
+#define NATIVE_WAKEUP_US 1000 // Crystal start-up after power-down
+#define NATIVE_EEPROM_WRITE_US 3400
+#define NATIVE_EEPROM_NO_LOSS UINT32_MAX // See native_eeprom_lose_writes()
+
+uint64_t native_get_time_ns(void);
+void native_delay_ns(uint64_t ns);
+void native_twi_bus_error(void);
+void native_eeprom_lose_writes(uint32_t writes);
+uint32_t native_eeprom_get_writes(void);
+void native_exit(void);
+
+#endif // NATIVE_H
@@ -0,0 +1,213 @@
+/**
+ * Native build: simulated BMP180
+ * Conversions take the typical time of the datasheet, SCO of CTRL_MEAS is set until then.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <avr/sfr_defs.h>
+#include "bitwise.h"
+#include "bmp180_def.h"
+#include "native.h"
+#include "sim_bmp180.h"
+
+#define SIM_BMP180_NS_PER_HOUR 3600000000000.0
+
+// Typical conversion time (in us): temperature, pressure with oversampling 0-3
+static const uint32_t conversion_us[] = { 3000, 3000, 5000, 9000, 17000 };
+
+// Calibration of the example in the datasheet
+static const int32_t datasheet_calibration[SIM_BMP180_CALIBRATION_SIZE] = {
+    408, -72, -14383, 32741, 32757, 23153, 6190, 4, -32768, -8711, 2868
+};
+
+// Typical RMS noise of the pressure (in Pa) with oversampling 0-3, datasheet
+static const double datasheet_press_noise[SIM_BMP180_MODES] = { 6, 5, 4, 3 };
+
+enum { AC1, AC2, AC3, AC4, AC5, AC6, B1, B2, MB, MC, MD };
+
+sim_bmp180_config_t sim_bmp180_create_config(void) {
+    sim_bmp180_config_t config = {
+        .temp = { .base = 21.5, .slope = 0, .amplitude = 3, .period = 24, .noise = 0.05 },
+        .press = { .base = 101325, .slope = -40, .amplitude = 150, .period = 12, .noise = 0 },
+    };
+    memcpy(config.calibration, datasheet_calibration, sizeof(datasheet_calibration));
+    memcpy(config.press_noise, datasheet_press_noise, sizeof(datasheet_press_noise));
+    return config;
+}
+
+/**
+ * Init BMP180
+ * The calibration is stored big-endian from BMP180_EPROM_AC1 like in the sensor.
+ * @param bmp180
+ * @param config
+*/
+void sim_bmp180_init(sim_bmp180_t* bmp180, const sim_bmp180_config_t* config) {
+    memset(bmp180, 0, sizeof(sim_bmp180_t));
+    bmp180->config = *config;
+    bmp180->random = SIM_BMP180_SEED;
+    for (uint8_t i = 0; i < SIM_BMP180_CALIBRATION_SIZE; i++) {
+        bmp180->registers[BMP180_EPROM_AC1 + i * 2] = (uint16_t)config->calibration[i] >> 8;
+        bmp180->registers[BMP180_EPROM_AC1 + i * 2 + 1] = (uint16_t)config->calibration[i] & 0xFF;
+    }
+    bmp180->registers[BMP180_REGISTER_CHIP_ID] = SIM_BMP180_CHIP_ID;
+}
+
+// Normal distribution by Box-Muller from xorshift32
+static double sim_bmp180_gauss(sim_bmp180_t* bmp180) {
+    double uniform[2];
+    for (uint8_t i = 0; i < 2; i++) {
+        bmp180->random ^= bmp180->random << 13;
+        bmp180->random ^= bmp180->random >> 17;
+        bmp180->random ^= bmp180->random << 5;
+        uniform[i] = (bmp180->random + 1.0) / 4294967297.0;
+    }
+    return sqrt(-2 * log(uniform[0])) * cos(2 * M_PI * uniform[1]);
+}
+
+double sim_bmp180_get_value(sim_bmp180_t* bmp180, const sim_bmp180_trajectory_t* trajectory, uint64_t time_ns) {
+    const double hours = time_ns / SIM_BMP180_NS_PER_HOUR;
+    double value = trajectory->base + trajectory->slope * hours;
+    if (trajectory->period != 0) {
+        value += trajectory->amplitude * sin(2 * M_PI * hours / trajectory->period);
+    }
+    return value + trajectory->noise * sim_bmp180_gauss(bmp180);
+}
+
+/**
+ * Compensate temperature as in the datasheet
+ * @return Temperature in 0.1 C
+*/
+int32_t sim_bmp180_compensate_temperature(const sim_bmp180_t* bmp180, int32_t UT, int32_t* B5) {
+    const int32_t* c = bmp180->config.calibration;
+    const int32_t X1 = (UT - c[AC6]) * c[AC5] / 32768;
+    const int32_t X2 = c[MC] * 2048 / (X1 + c[MD]);
+    *B5 = X1 + X2;
+    return (*B5 + 8) / 16;
+}
+
+/**
+ * Compensate pressure as in the datasheet
+ * @return Pressure in Pa
+*/
+int32_t sim_bmp180_compensate_pressure(const sim_bmp180_t* bmp180, int32_t UP, int32_t B5, uint8_t oss) {
+    const int32_t* c = bmp180->config.calibration;
+    const int32_t B6 = B5 - 4000;
+    int32_t X1 = (c[B2] * (B6 * B6 / 4096)) / 2048;
+    int32_t X2 = c[AC2] * B6 / 2048;
+    int32_t X3 = X1 + X2;
+    const int32_t B3 = (((c[AC1] * 4 + X3) << oss) + 2) / 4;
+    X1 = c[AC3] * B6 / 8192;
+    X2 = (c[B1] * (B6 * B6 / 4096)) / 65536;
+    X3 = (X1 + X2 + 2) / 4;
+    const uint32_t B4 = (uint32_t)c[AC4] * (uint32_t)(X3 + 32768) / 32768;
+    const uint32_t B7 = ((uint32_t)UP - B3) * (50000 >> oss);
+    int32_t p = B7 < 0x80000000 ? (int32_t)(B7 * 2 / B4) : (int32_t)(B7 / B4 * 2);
+    X1 = (p / 256) * (p / 256);
+    X1 = (X1 * 3038) / 65536;
+    X2 = (-7357 * p) / 65536;
+    return p + (X1 + X2 + 3791) / 16;
+}
+
+// Uncompensated value closest to the target, the compensation grows with it
+static int32_t sim_bmp180_invert(const sim_bmp180_t* bmp180, int32_t target, int32_t maximum, int32_t B5, int8_t oss) {
+    int32_t low = 0;
+    int32_t high = maximum;
+    while (low < high) {
+        const int32_t middle = low + (high - low) / 2;
+        int32_t value_B5;
+        const int32_t value = oss < 0 ? sim_bmp180_compensate_temperature(bmp180, middle, &value_B5) : sim_bmp180_compensate_pressure(bmp180, middle, B5, oss);
+        if (value < target) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static void sim_bmp180_start_conversion(sim_bmp180_t* bmp180, uint8_t command) {
+    const uint64_t now_ns = native_get_time_ns();
+    int32_t B5;
+    if (command == BMP180_START_MEASURE_TEMPERATURE) {
+        const double temp = sim_bmp180_get_value(bmp180, &bmp180->config.temp, now_ns);
+        bmp180->UT = sim_bmp180_invert(bmp180, (int32_t)lround(temp * 10), 0xFFFF, 0, -1);
+        bmp180->result = (uint32_t)bmp180->UT << 8;
+        bmp180->conversion_end_ns = now_ns + conversion_us[0] * 1000ULL;
+    }
+    else if ((command & 0x3F) == BMP180_START_MEASURE_PRESSURE) {
+        const uint8_t oss = command >> 6;
+        double press = sim_bmp180_get_value(bmp180, &bmp180->config.press, now_ns);
+        press += bmp180->config.press_noise[oss] * sim_bmp180_gauss(bmp180);
+        sim_bmp180_compensate_temperature(bmp180, bmp180->UT, &B5);
+        const int32_t UP = sim_bmp180_invert(bmp180, (int32_t)lround(press), (0x10000L << oss) - 1, B5, oss);
+        bmp180->result = (uint32_t)UP << (8 - oss);
+        bmp180->conversion_end_ns = now_ns + conversion_us[1 + oss] * 1000ULL;
+    }
+    else {
+        return;
+    }
+    bmp180->conversions++;
+    bmp180->registers[BMP180_REGISTER_CTR_MEAS] = command | _BV(BMP180_CTR_MEAS_SCO);
+}
+
+// Registers of a finished conversion
+static void sim_bmp180_update(sim_bmp180_t* bmp180) {
+    uint8_t* registers = bmp180->registers;
+    if (!bmp180->is_stalled && bit_is_set(registers[BMP180_REGISTER_CTR_MEAS], BMP180_CTR_MEAS_SCO) && native_get_time_ns() >= bmp180->conversion_end_ns) {
+        clear_bit(registers[BMP180_REGISTER_CTR_MEAS], BMP180_CTR_MEAS_SCO);
+        registers[BMP180_REGISTER_OUT_MSB] = bmp180->result >> 16;
+        registers[BMP180_REGISTER_OUT_LSB] = bmp180->result >> 8;
+        registers[BMP180_REGISTER_OUT_XLSB] = bmp180->result;
+    }
+}
+
+static bool sim_bmp180_start(void* context, i2c_mode_t mode) {
+    sim_bmp180_t* bmp180 = context;
+    bmp180->is_address_set = false;
+    return true;
+}
+
+static bool sim_bmp180_write(void* context, uint8_t byte) {
+    sim_bmp180_t* bmp180 = context;
+    if (!bmp180->is_address_set) {
+        bmp180->address = byte;
+        bmp180->is_address_set = true;
+        return true;
+    }
+    if (bmp180->address == BMP180_REGISTER_CTR_MEAS) {
+        sim_bmp180_update(bmp180);
+        sim_bmp180_start_conversion(bmp180, byte);
+    }
+    else if (bmp180->address == BMP180_REGISTER_SOFT_RESET && byte == BMP180_START_SOFT_RESET) {
+        bmp180->registers[BMP180_REGISTER_CTR_MEAS] = 0;
+    }
+    bmp180->address++;
+    return true;
+}
+
+static uint8_t sim_bmp180_read(void* context, bool ack) {
+    sim_bmp180_t* bmp180 = context;
+    sim_bmp180_update(bmp180);
+    return bmp180->registers[bmp180->address++];
+}
+
+static void sim_bmp180_stop(void* context) {
+}
+
+i2c_device_t sim_bmp180_create_device(sim_bmp180_t* bmp180, uint8_t address) {
+    i2c_device_t device = {
+        .address = address,
+        .start = sim_bmp180_start,
+        .write = sim_bmp180_write,
+        .read = sim_bmp180_read,
+        .stop = sim_bmp180_stop,
+        .context = bmp180,
+    };
+    return device;
+}
@@ -0,0 +1,59 @@
+/**
+ * Native build: simulated BMP180
+ * Temperature and pressure follow configured trajectories, they are converted to UT and UP
+ * by inverting the compensation of the datasheet with the configured calibration.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef SIM_BMP180_H
+#define SIM_BMP180_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_native.h"
+
+#define SIM_BMP180_CALIBRATION_SIZE 11 // AC1-MD
+#define SIM_BMP180_MODES 4 // Oversampling 0-3
+#define SIM_BMP180_CHIP_ID 0x55
+#define SIM_BMP180_SEED 0x2024
+
+/**
+ * value = base + slope * hours + amplitude * sin(2 pi * hours / period) + noise * N(0, 1)
+*/
+typedef struct {
+    double base;
+    double slope; // Per hour
+    double amplitude;
+    double period; // In hours, 0 = no oscillation
+    double noise; // Standard deviation
+} sim_bmp180_trajectory_t;
+
+typedef struct {
+    int32_t calibration[SIM_BMP180_CALIBRATION_SIZE];
+    sim_bmp180_trajectory_t temp; // In C
+    sim_bmp180_trajectory_t press; // In Pa, noise of the weather (the sensor noise is added)
+    double press_noise[SIM_BMP180_MODES]; // RMS noise of the sensor in Pa by oversampling
+} sim_bmp180_config_t;
+
+typedef struct {
+    sim_bmp180_config_t config;
+    uint8_t registers[256];
+    uint8_t address; // Register pointer, increments on read
+    bool is_address_set; // First written byte of a transaction is the register address
+    uint64_t conversion_end_ns;
+    uint32_t result; // Value of OUT_MSB..OUT_XLSB at the end of the conversion
+    int32_t UT; // Uncompensated temperature of the last conversion, for the pressure
+    uint32_t random;
+    uint32_t conversions;
+    bool is_stalled; // Conversions never complete (SCO stays set), for tests of timeouts
+} sim_bmp180_t;
+
+sim_bmp180_config_t sim_bmp180_create_config(void);
+void sim_bmp180_init(sim_bmp180_t* bmp180, const sim_bmp180_config_t* config);
+double sim_bmp180_get_value(sim_bmp180_t* bmp180, const sim_bmp180_trajectory_t* trajectory, uint64_t time_ns);
+int32_t sim_bmp180_compensate_temperature(const sim_bmp180_t* bmp180, int32_t UT, int32_t* B5);
+int32_t sim_bmp180_compensate_pressure(const sim_bmp180_t* bmp180, int32_t UP, int32_t B5, uint8_t oss);
+i2c_device_t sim_bmp180_create_device(sim_bmp180_t* bmp180, uint8_t address);
+
+#endif // SIM_BMP180_H
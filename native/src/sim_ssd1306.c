@@ -0,0 +1,278 @@
+/**
+ * Native build: simulated SSD1306 128x64
+ * Supports the addressing modes, content scroll and the commands sent by lib/ssd1306.
+ * Continuous scrolling, remapping and the display offset only change the panel output,
+ * they are accepted but the exported image is the GDDRAM as addressed by the firmware.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "ssd1306_def.h"
+#include "sim_ssd1306.h"
+
+#define SIM_SSD1306_CO 7 // Control byte: only one byte follows
+#define SIM_SSD1306_DC 6 // Control byte: data, otherwise commands
+#define SIM_SSD1306_LAST_COLUMN (SSD1306_WIDTH - 1)
+#define SIM_SSD1306_LAST_PAGE (SIM_SSD1306_PAGES - 1)
+
+void sim_ssd1306_init(sim_ssd1306_t* ssd1306) {
+    memset(ssd1306, 0, sizeof(sim_ssd1306_t));
+    ssd1306->addressing_mode = SSD1306_MEMORY_ADDRESSING_MODE_PAGE;
+    ssd1306->end_column = SIM_SSD1306_LAST_COLUMN;
+    ssd1306->end_page = SIM_SSD1306_LAST_PAGE;
+    ssd1306->contrast = SSD1306_CONTRAST_DEFAULT;
+    ssd1306->has_content_scroll = true;
+}
+
+// Count of parameter bytes that follow the command
+static uint8_t sim_ssd1306_get_parameter_length(const sim_ssd1306_t* ssd1306, uint8_t command) {
+    if (!ssd1306->has_content_scroll && (command == SSD1306_RIGHT_CONTENT_SCROLL_COMMAND || command == SSD1306_LEFT_CONTENT_SCROLL_COMMAND)) {
+        return 0; // Unknown to the original SSD1306, its parameters are taken as commands
+    }
+    switch (command) {
+        case SSD1306_CONTRAST_COMMAND:
+        case SSD1306_MEMORY_ADDRESSING_MODE_COMMAND:
+        case SSD1306_MUX_RATIO_COMMAND:
+        case SSD1306_DISPLAY_OFFSET_COMMAND:
+        case SSD1306_DISPLAY_CLOCK_DIVIDE_COMMAND:
+        case SSD1306_PRE_CHARGE_PERIOD_COMMAND:
+        case SSD1306_COM_PINS_HARDWARE_CONFIG_COMMAND:
+        case SSD1306_VCOMH_DESELECT_LEVEL_COMMAND:
+        case SSD1306_CHARGE_PUMP_COMMAND:
+        case SSD1306_ZOOM_IN_COMMAND:
+        case SSD1306_FADE_OUT_BLINKING_COMMAND:
+            return 1;
+        case SSD1306_COLUMN_START_END_ADDRESS_COMMAND:
+        case SSD1306_PAGE_START_END_ADDRESS_COMMAND:
+        case 0xA3: // Vertical scroll area
+            return 2;
+        case 0x29: // Vertical and horizontal scroll setup
+        case 0x2A:
+            return 5;
+        case 0x26: // Continuous horizontal scroll setup (right)
+        case 0x27: // Continuous horizontal scroll setup (left)
+        case SSD1306_RIGHT_CONTENT_SCROLL_COMMAND:
+        case SSD1306_LEFT_CONTENT_SCROLL_COMMAND:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+// Moves the columns of the area by one, the vacated column gets the one pushed out
+static void sim_ssd1306_scroll_content(sim_ssd1306_t* ssd1306, ssd1306_scroll_direction_t direction) {
+    const uint8_t* parameters = ssd1306->parameters;
+    const uint8_t start_page = parameters[1] & 0x07;
+    const uint8_t end_page = parameters[3] & 0x07;
+    const uint8_t start_column = parameters[4] & 0x7F;
+    const uint8_t end_column = parameters[5] & 0x7F;
+    if (start_page > end_page || start_column >= end_column) {
+        return;
+    }
+    const uint8_t length = end_column - start_column;
+    for (uint8_t page = start_page; page <= end_page; page++) {
+        uint8_t* data = &ssd1306->ram[page][0];
+        if (direction == SSD1306_SCROLL_LEFT) {
+            const uint8_t vacated = data[start_column];
+            memmove(&data[start_column], &data[start_column + 1], length);
+            data[end_column] = vacated;
+        }
+        else {
+            const uint8_t vacated = data[end_column];
+            memmove(&data[start_column + 1], &data[start_column], length);
+            data[start_column] = vacated;
+        }
+    }
+}
+
+static void sim_ssd1306_execute(sim_ssd1306_t* ssd1306) {
+    const uint8_t command = ssd1306->command;
+    const uint8_t* parameters = ssd1306->parameters;
+    ssd1306->commands++;
+
+    if (command <= 0x0F) {
+        ssd1306->column = (ssd1306->column & 0xF0) | command;
+    }
+    else if (command <= 0x1F) {
+        ssd1306->column = ((command & 0x07) << 4) | (ssd1306->column & 0x0F);
+    }
+    else if (command >= 0xB0 && command <= 0xB7) {
+        ssd1306->page = command & 0x07;
+    }
+    else if (command >= SSD1306_DISPLAY_START_LINE_COMMAND && command <= SSD1306_DISPLAY_START_LINE_COMMAND + 0x3F) {
+        // Panel output only
+    }
+    else {
+        switch (command) {
+            case SSD1306_CONTRAST_COMMAND:
+                ssd1306->contrast = parameters[0];
+                break;
+            case SSD1306_MEMORY_ADDRESSING_MODE_COMMAND:
+                if ((parameters[0] & 0x03) <= SSD1306_MEMORY_ADDRESSING_MODE_PAGE) {
+                    ssd1306->addressing_mode = parameters[0] & 0x03;
+                }
+                break;
+            case SSD1306_COLUMN_START_END_ADDRESS_COMMAND:
+                ssd1306->start_column = parameters[0] & 0x7F;
+                ssd1306->end_column = parameters[1] & 0x7F;
+                ssd1306->column = ssd1306->start_column;
+                break;
+            case SSD1306_PAGE_START_END_ADDRESS_COMMAND:
+                ssd1306->start_page = parameters[0] & 0x07;
+                ssd1306->end_page = parameters[1] & 0x07;
+                ssd1306->page = ssd1306->start_page;
+                break;
+            case SSD1306_DISPLAY_NORMAL_COMMAND:
+            case SSD1306_DISPLAY_INVERSE_COMMAND:
+                ssd1306->is_inverse = command == SSD1306_DISPLAY_INVERSE_COMMAND;
+                break;
+            case SSD1306_DISPLAY_OFF_COMMAND:
+            case SSD1306_DISPLAY_ON_COMMAND:
+                ssd1306->is_on = command == SSD1306_DISPLAY_ON_COMMAND;
+                break;
+            case SSD1306_RIGHT_CONTENT_SCROLL_COMMAND:
+            case SSD1306_LEFT_CONTENT_SCROLL_COMMAND:
+                if (ssd1306->has_content_scroll) {
+                    sim_ssd1306_scroll_content(ssd1306, command == SSD1306_LEFT_CONTENT_SCROLL_COMMAND ? SSD1306_SCROLL_LEFT : SSD1306_SCROLL_RIGHT);
+                }
+                else {
+                    ssd1306->unknown_commands++;
+                }
+                break;
+            case SSD1306_ENTIRE_DISPLAY_ON_COMMAND:
+            case SSD1306_ENTIRE_DISPLAY_OFF_COMMAND:
+            case SSD1306_SEGMENT_RE_MAP_NORMAL_COMMAND:
+            case SSD1306_SEGMENT_RE_MAP_INVERSE_COMMAND:
+            case SSD1306_COM_OUTPUT_SCAN_DIRECTION_NORMAL_COMMAND:
+            case SSD1306_COM_OUTPUT_SCAN_DIRECTION_REMAPPED_COMMAND:
+            case SSD1306_DEACTIVATE_SCROLL_COMMAND:
+            case 0x2F: // Activate scroll
+            case 0xE3: // NOP
+                break;
+            default:
+                if (sim_ssd1306_get_parameter_length(ssd1306, command) == 0) {
+                    ssd1306->unknown_commands++;
+                }
+                break;
+        }
+    }
+}
+
+/**
+ * Write command or parameter byte
+ * @param ssd1306
+ * @param byte
+*/
+void sim_ssd1306_write_command(sim_ssd1306_t* ssd1306, uint8_t byte) {
+    if (ssd1306->parameter_count < ssd1306->parameter_length) {
+        ssd1306->parameters[ssd1306->parameter_count++] = byte;
+    }
+    else {
+        ssd1306->command = byte;
+        ssd1306->parameter_count = 0;
+        ssd1306->parameter_length = sim_ssd1306_get_parameter_length(ssd1306, byte);
+    }
+    if (ssd1306->parameter_count == ssd1306->parameter_length) {
+        sim_ssd1306_execute(ssd1306);
+        ssd1306->parameter_length = 0;
+    }
+}
+
+/**
+ * Write display data, the address moves by the addressing mode
+ * @param ssd1306
+ * @param byte
+*/
+void sim_ssd1306_write_data(sim_ssd1306_t* ssd1306, uint8_t byte) {
+    ssd1306->ram[ssd1306->page][ssd1306->column] = byte;
+    ssd1306->data_bytes++;
+
+    switch (ssd1306->addressing_mode) {
+        case SSD1306_MEMORY_ADDRESSING_MODE_HORIZONTAL:
+            if (ssd1306->column++ >= ssd1306->end_column) {
+                ssd1306->column = ssd1306->start_column;
+                ssd1306->page = ssd1306->page >= ssd1306->end_page ? ssd1306->start_page : ssd1306->page + 1;
+            }
+            break;
+        case SSD1306_MEMORY_ADDRESSING_MODE_VERTICAL:
+            if (ssd1306->page++ >= ssd1306->end_page) {
+                ssd1306->page = ssd1306->start_page;
+                ssd1306->column = ssd1306->column >= ssd1306->end_column ? ssd1306->start_column : ssd1306->column + 1;
+            }
+            break;
+        default:
+            ssd1306->column = (ssd1306->column + 1) & SIM_SSD1306_LAST_COLUMN;
+            break;
+    }
+}
+
+bool sim_ssd1306_get_pixel(const sim_ssd1306_t* ssd1306, uint8_t x, uint8_t y) {
+    return ssd1306->ram[y / SSD1306_BITS_PER_COLUMN][x] & (1 << (y % SSD1306_BITS_PER_COLUMN));
+}
+
+/**
+ * Export GDDRAM as PBM image (P1), a lit pixel is black
+ * @param ssd1306
+ * @param path
+*/
+bool sim_ssd1306_export_pbm(const sim_ssd1306_t* ssd1306, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        return false;
+    }
+    fprintf(file, "P1\n%d %d\n", SSD1306_WIDTH, SSD1306_HEIGHT);
+    for (uint8_t y = 0; y < SSD1306_HEIGHT; y++) {
+        for (uint8_t x = 0; x < SSD1306_WIDTH; x++) {
+            fputc(sim_ssd1306_get_pixel(ssd1306, x, y) ? '1' : '0', file);
+            fputc(x < SSD1306_WIDTH - 1 ? ' ' : '\n', file);
+        }
+    }
+    return fclose(file) == 0;
+}
+
+static bool sim_ssd1306_start(void* context, i2c_mode_t mode) {
+    sim_ssd1306_t* ssd1306 = context;
+    ssd1306->is_control = true;
+    return mode == I2C_MODE_WRITE; // Status read of the I2C interface is not supported
+}
+
+static bool sim_ssd1306_write(void* context, uint8_t byte) {
+    sim_ssd1306_t* ssd1306 = context;
+    if (ssd1306->is_control) {
+        ssd1306->is_control = false;
+        ssd1306->is_continuation = byte & (1 << SIM_SSD1306_CO);
+        ssd1306->is_data = byte & (1 << SIM_SSD1306_DC);
+        return true;
+    }
+    if (ssd1306->is_data) {
+        sim_ssd1306_write_data(ssd1306, byte);
+    }
+    else {
+        sim_ssd1306_write_command(ssd1306, byte);
+    }
+    ssd1306->is_control = ssd1306->is_continuation;
+    return true;
+}
+
+static uint8_t sim_ssd1306_read(void* context, bool ack) {
+    return 0xFF;
+}
+
+static void sim_ssd1306_stop(void* context) {
+}
+
+i2c_device_t sim_ssd1306_create_device(sim_ssd1306_t* ssd1306, uint8_t address) {
+    i2c_device_t device = {
+        .address = address,
+        .start = sim_ssd1306_start,
+        .write = sim_ssd1306_write,
+        .read = sim_ssd1306_read,
+        .stop = sim_ssd1306_stop,
+        .context = ssd1306,
+    };
+    return device;
+}
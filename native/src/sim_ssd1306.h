@@ -0,0 +1,53 @@
+/**
+ * Native build: simulated SSD1306 128x64
+ * Commands and data written over I2C are interpreted into the display RAM (GDDRAM).
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef SIM_SSD1306_H
+#define SIM_SSD1306_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306_def.h"
+#include "i2c_native.h"
+
+#define SIM_SSD1306_PAGES (SSD1306_HEIGHT / SSD1306_BITS_PER_COLUMN)
+#define SIM_SSD1306_MAX_PARAMETERS 6
+
+typedef struct {
+    uint8_t ram[SIM_SSD1306_PAGES][SSD1306_WIDTH]; // GDDRAM, bit 0 of a byte is the top row of the page
+    ssd1306_memory_addressing_mode_t addressing_mode;
+    uint8_t column;
+    uint8_t page;
+    uint8_t start_column;
+    uint8_t end_column;
+    uint8_t start_page;
+    uint8_t end_page;
+    bool is_on;
+    bool is_inverse;
+    uint8_t contrast;
+    bool has_content_scroll; // false = original SSD1306 without the 0x2C/0x2D commands
+    // Command stream
+    bool is_control; // Next byte is a control byte
+    bool is_continuation; // Co bit: only one byte follows the control byte
+    bool is_data; // D/C# bit
+    uint8_t command;
+    uint8_t parameters[SIM_SSD1306_MAX_PARAMETERS];
+    uint8_t parameter_count; // Received parameters of the command
+    uint8_t parameter_length; // Expected parameters of the command
+    // Statistics
+    uint32_t commands;
+    uint32_t data_bytes;
+    uint32_t unknown_commands;
+} sim_ssd1306_t;
+
+void sim_ssd1306_init(sim_ssd1306_t* ssd1306);
+void sim_ssd1306_write_command(sim_ssd1306_t* ssd1306, uint8_t byte);
+void sim_ssd1306_write_data(sim_ssd1306_t* ssd1306, uint8_t byte);
+bool sim_ssd1306_get_pixel(const sim_ssd1306_t* ssd1306, uint8_t x, uint8_t y);
+bool sim_ssd1306_export_pbm(const sim_ssd1306_t* ssd1306, const char* path);
+i2c_device_t sim_ssd1306_create_device(sim_ssd1306_t* ssd1306, uint8_t address);
+
+#endif // SIM_SSD1306_H
@@ -0,0 +1,104 @@
+/**
+ * Native build: simulated TCA9548A I2C mux
+ * The mux is attached at its own address, the devices behind its channels are reached through
+ * a channel device attached at their address. A transaction goes to the device of the lowest
+ * connected channel (several connected devices with the same address would answer together).
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "sim_tca9548a.h"
+
+void sim_tca9548a_init(sim_tca9548a_t* tca9548a) {
+    memset(tca9548a, 0, sizeof(sim_tca9548a_t));
+}
+
+/**
+ * Put the device behind the channel
+ * @param tca9548a
+ * @param channel (0-7)
+ * @param device Its address is the address of the channel device
+*/
+bool sim_tca9548a_connect(sim_tca9548a_t* tca9548a, uint8_t channel, i2c_device_t* device) {
+    if (channel >= SIM_TCA9548A_CHANNELS) {
+        return false;
+    }
+    tca9548a->channels[channel] = device;
+    return true;
+}
+
+static bool sim_tca9548a_start(void* context, i2c_mode_t mode) {
+    return true;
+}
+
+static bool sim_tca9548a_write(void* context, uint8_t byte) {
+    sim_tca9548a_t* tca9548a = context;
+    tca9548a->control = byte;
+    return true;
+}
+
+static uint8_t sim_tca9548a_read(void* context, bool ack) {
+    const sim_tca9548a_t* tca9548a = context;
+    return tca9548a->control;
+}
+
+static void sim_tca9548a_stop(void* context) {
+}
+
+static bool sim_tca9548a_channel_start(void* context, i2c_mode_t mode) {
+    sim_tca9548a_t* tca9548a = context;
+    tca9548a->device = NULL;
+    for (uint8_t channel = 0; channel < SIM_TCA9548A_CHANNELS && tca9548a->device == NULL; channel++) {
+        if (tca9548a->control & (1 << channel)) {
+            tca9548a->device = tca9548a->channels[channel];
+        }
+    }
+    return tca9548a->device != NULL && tca9548a->device->start(tca9548a->device->context, mode);
+}
+
+static bool sim_tca9548a_channel_write(void* context, uint8_t byte) {
+    const sim_tca9548a_t* tca9548a = context;
+    return tca9548a->device->write(tca9548a->device->context, byte);
+}
+
+static uint8_t sim_tca9548a_channel_read(void* context, bool ack) {
+    const sim_tca9548a_t* tca9548a = context;
+    return tca9548a->device->read(tca9548a->device->context, ack);
+}
+
+static void sim_tca9548a_channel_stop(void* context) {
+    sim_tca9548a_t* tca9548a = context;
+    if (tca9548a->device != NULL) {
+        tca9548a->device->stop(tca9548a->device->context);
+        tca9548a->device = NULL;
+    }
+}
+
+// The mux itself: one control byte is written or read
+i2c_device_t sim_tca9548a_create_device(sim_tca9548a_t* tca9548a, uint8_t address) {
+    i2c_device_t device = {
+        .address = address,
+        .start = sim_tca9548a_start,
+        .write = sim_tca9548a_write,
+        .read = sim_tca9548a_read,
+        .stop = sim_tca9548a_stop,
+        .context = tca9548a,
+    };
+    return device;
+}
+
+// Devices behind the connected channels at the address
+i2c_device_t sim_tca9548a_create_channel_device(sim_tca9548a_t* tca9548a, uint8_t address) {
+    i2c_device_t device = {
+        .address = address,
+        .start = sim_tca9548a_channel_start,
+        .write = sim_tca9548a_channel_write,
+        .read = sim_tca9548a_channel_read,
+        .stop = sim_tca9548a_channel_stop,
+        .context = tca9548a,
+    };
+    return device;
+}
@@ -0,0 +1,28 @@
+/**
+ * Native build: simulated TCA9548A I2C mux
+ * The control register selects the channels, the devices behind them share one address.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#ifndef SIM_TCA9548A_H
+#define SIM_TCA9548A_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_native.h"
+
+#define SIM_TCA9548A_CHANNELS 8
+
+typedef struct {
+    uint8_t control; // Bit n = channel n is connected
+    i2c_device_t* channels[SIM_TCA9548A_CHANNELS]; // Device behind each channel
+    i2c_device_t* device; // Device of the current transaction behind the mux
+} sim_tca9548a_t;
+
+void sim_tca9548a_init(sim_tca9548a_t* tca9548a);
+bool sim_tca9548a_connect(sim_tca9548a_t* tca9548a, uint8_t channel, i2c_device_t* device);
+i2c_device_t sim_tca9548a_create_device(sim_tca9548a_t* tca9548a, uint8_t address);
+i2c_device_t sim_tca9548a_create_channel_device(sim_tca9548a_t* tca9548a, uint8_t address);
+
+#endif // SIM_TCA9548A_H
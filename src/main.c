@@ -4,18 +4,122 @@
 #include <stdio.h>
 #include <avr/io.h>
 #include <avr/pgmspace.h>
+#include <avr/interrupt.h>
 #include <util/delay.h>
 #include "i2c.h"
 #include "ssd1306.h"
 #include "bmp180.h"
+#include "bmp180_sampler.h"
+#include "sensor_array.h"
 #include "bitwise.h"
 #include "numeric_font.h"
+#include "forecast_font.h"
 #include "thermometer_bitmap.h"
 #include "barometer_bitmap.h"
+#include "barograph.h"
+#include "sparkline.h"
+#include "tendency.h"
+#include "units.h"
+#include "eeprom_log.h"
+#include "power.h"
+#include "scheduler.h"
+#include "uart.h"
+#include "telemetry.h"
 
 #define SSD1306_I2C_ADDRESS 0x3C
 #define BMP180_I2C_ADDRESS 0x77
 #define LED_PIN PB5 // D13
+#define UART_BAUD_RATE 115200
+#define TEXT_LENGTH 7 // Width of value fields in chars, e.g. "+21.4*<"
+#define TEXT_MARGIN 5
+#define IMG_MARGIN 16
+#define TEMP_PAGE 1
+#define TEMP_COLUMN (THERMOMETER_BITMAP_WIDTH + TEXT_MARGIN + IMG_MARGIN)
+#define PRESS_PAGE 5
+#define PRESS_COLUMN (BAROMETER_BITMAP_WIDTH + TEXT_MARGIN + IMG_MARGIN)
+#define TEMP_CHART_PAGE 3
+#define TEMP_CHART_RANGE 50 // +-5.0 C around the first measurement
+#define PRESS_CHART_PAGE 7
+#define PRESS_CHART_INTERVAL 3 // Measurements per column: 128 columns = 6.4 hours
+#define PRESS_CHART_RANGE 1500 // +-15 hPa around the first measurement, only with SSD1306_FRAMEBUFFER
+#define PRESS_TENDENCY_INTERVAL 3 // Measurements per tendency sample: 60 samples = 3 hours
+#define FORECAST_PAGE PRESS_PAGE
+#define FORECAST_COLUMN (SSD1306_WIDTH - 16) // Forecast glyphs are 16x16
+#define STATION_ALTITUDE 0 // Altitude of the station in 0.1 m, for sea level pressure of the forecast
+// Pressure conversions per measurement in standard mode, averaged: the cheapest setting of BMP180_BENCHMARK
+// under PRESS_NOISE_TARGET (34.5 ms, 1.9 Pa with the datasheet noise of the native build)
+#define PRESS_SAMPLES 4
+// Temperature changes slowly: it is measured again after 5 minutes or an estimated drift of 0.2 C,
+// the measurements in between only convert pressure
+#define TEMP_CACHE_MAX_AGE_MS 300000UL
+#define TEMP_CACHE_MAX_DRIFT 2 // 0.1 C
+#define PRESS_NOISE_TARGET 250 // Noise of the measured pressure (in 0.01 Pa): steady tendency is a change under 10 Pa
+#define BENCHMARK_ROUNDS 64 // Readings per mode and sample count, only with BMP180_BENCHMARK
+#define MUX_I2C_ADDRESS 0x70 // TCA9548A with a BMP180 on channels 0 and 1, only with SENSOR_ARRAY
+// One conversion per sensor and cycle instead of PRESS_SAMPLES, the conversions of both sensors overlap (about 22 ms):
+// 2.1 Pa of noise for the mean of two sensors in ultra high resolution mode
+#define PRESS_ARRAY_MODE BMP180_ULTRA_HIGH_RESOLUTION_MODE
+#define PRESS_DISAGREEMENT 50 // Pa, a sensor further from the median is an outlier
+#define MEASURE_INTERVAL 60 // Seconds between measurements, every measurement is logged to EEPROM
+// Changes of 0.1 C and 0.1 hPa are logged as no change: the log covers about 3 days instead of 22 hours,
+// a logged measurement is off by up to 0.1 C and 15 Pa
+#define HISTORY_DEAD_BAND 1
+#define MEASURE_DEADLINE_MS 1000
+#define DISPLAY_INTERVAL_MS 1000 // Display shows a new measurement within a second
+#define DISPLAY_DEADLINE_MS 500
+#define DISPLAY_ON_MS 10000 // Display is on after a measurement, only with DISPLAY_SLEEP
+#define HEARTBEAT_INTERVAL_MS 2000
+#define HEARTBEAT_ON_MS 20
+#define HEARTBEAT_DEADLINE_MS 50
+#define PROFILE_INTERVAL_MS 600000UL // I2C profile is sent every 10 minutes, only with I2C_PROFILE
+#define PROFILE_RETRY_MS 10 // UART buffer is full, the rest of the profile is sent later
+
+#ifdef PIO_UNIT_TESTING
+#define main firmware_main // Tests in test/ are linked with the firmware (native env) and have their own main()
+#endif
+
+#ifdef SSD1306_FRAMEBUFFER
+static ssd1306_framebuffer_t framebuffer;
+// No RAM for the sparkline next to the framebuffer: the pressure chart has a fixed range, its history is in the framebuffer
+static barograph_t press_chart;
+static int32_t press_chart_sum;
+static uint8_t press_chart_count;
+#else
+static sparkline_t press_chart;
+#ifndef SSD1306_CONTENT_SCROLL
+static uint8_t temp_chart_history[SSD1306_WIDTH]; // The display can't scroll the chart, it is redrawn
+#endif
+#endif
+static tendency_t press_tendency;
+static ssd1306_text_field_t temp_field;
+static ssd1306_text_field_t press_field;
+static ssd1306_text_field_t forecast_field;
+static eeprom_log_t history;
+static power_t power;
+static scheduler_t scheduler;
+static telemetry_t telemetry;
+#ifdef SENSOR_ARRAY
+static sensor_array_t sensors;
+static uint8_t mux_address = MUX_I2C_ADDRESS;
+#endif
+
+typedef struct {
+  const ssd1306_t *ssd1306;
+  const ssd1306_t *forecast_display;
+  bmp180_t *bmp180;
+  bmp180_sampler_config_t sampler_cfg;
+  barograph_t temp_chart;
+  units_qnh_t qnh;
+  bool is_first_measure;
+  bool is_measured; // New measurement is not shown yet
+  int32_t prev_temp;
+  int32_t temp; // Temperature in 0.1 C
+  int32_t press; // Pressure in Pa
+  uint32_t time; // Time of the measurement in seconds, no RTC: continues from the last logged sample
+  uint16_t current; // Average current of the last measurement period (in uA)
+} station_t;
+
+static station_t station;
 
 char get_trend(int32_t *prev_val, int32_t *val) {
   if (*prev_val == *val) {
@@ -24,63 +128,288 @@ char get_trend(int32_t *prev_val, int32_t *val) {
   return *val > *prev_val ? '<' : '>';
 }
 
-void update_display(const ssd1306_t *ssd1306, int32_t *prev_temp, int32_t *temp, int32_t *prev_press, int32_t *press) {
-  #define TEXT_MARGIN 5
-  #define IMG_MARGIN 16
-
-  static char buff[10];
+// Arrow of the 3-hour pressure tendency, slow changes are not shown
+char get_pressure_trend(tendency_category_t category) {
+  switch (category) {
+    case TENDENCY_RISING:
+    case TENDENCY_RISING_QUICKLY:
+    case TENDENCY_RISING_VERY_RAPIDLY:
+      return '<';
+    case TENDENCY_FALLING:
+    case TENDENCY_FALLING_QUICKLY:
+    case TENDENCY_FALLING_VERY_RAPIDLY:
+      return '>';
+    default:
+      return ' ';
+  }
+}
 
+// Static part of the screen, drawn once
+void draw_layout(const ssd1306_t *ssd1306) {
   ssd1306_clear_display(ssd1306);
+  ssd1306_draw_paged_bitmap(ssd1306, 0, IMG_MARGIN, THERMOMETER_BITMAP_WIDTH, THERMOMETER_BITMAP_HEIGHT, thermometer_bitmap);
+  ssd1306_draw_paged_bitmap(ssd1306, 4, IMG_MARGIN, BAROMETER_BITMAP_WIDTH, BAROMETER_BITMAP_HEIGHT, barometer_bitmap);
+  ssd1306_flush(ssd1306);
+}
 
-  ssd1306_draw_bitmap(ssd1306, 0, IMG_MARGIN, THERMOMETER_BITMAP_WIDTH, THERMOMETER_BITMAP_HEIGHT, thermometer_bitmap);
+// Only the changed chars of the value fields are sent
+void update_display(const ssd1306_t *ssd1306, int32_t *prev_temp, int32_t *temp, int32_t *press) {
+  static char buff[10];
 
   buff[0] = '\0';
   sprintf_P(buff, PSTR("%c%d.%d*%c"), *temp > 0 ? '+' : '-', abs(*temp / 10), abs(*temp % 10), get_trend(prev_temp, temp));
-  ssd1306_print(ssd1306, buff, 1, THERMOMETER_BITMAP_WIDTH + TEXT_MARGIN + IMG_MARGIN);
+  ssd1306_update_text_field(ssd1306, &temp_field, buff);
 
   buff[0] = '\0';
+  sprintf_P(buff, PSTR(" %dh%c"), units_pressure_to_mmhg(*press), get_pressure_trend(tendency_get_category(&press_tendency)));
+  ssd1306_update_text_field(ssd1306, &press_field, buff);
+
+  ssd1306_flush(ssd1306);
+}
+
+// Forecast glyph is redrawn only when the forecast changes
+void update_forecast(const ssd1306_t *forecast_display, const units_qnh_t *qnh, int32_t *press) {
+  const int32_t sea_level_press = units_pressure_to_sea_level(*press, qnh);
+  const char glyph[] = { '0' + tendency_get_forecast(&press_tendency, sea_level_press), '\0' };
+  ssd1306_update_text_field(forecast_display, &forecast_field, glyph);
+  ssd1306_flush(forecast_display);
+}
+
+// Temperature chart is scrolled by the display, pressure chart is scaled to the pressure history
+void update_charts(const ssd1306_t *ssd1306, const barograph_t *temp_chart, int32_t *temp, int32_t *press) {
+  barograph_add(ssd1306, temp_chart, *temp);
+#ifdef SSD1306_FRAMEBUFFER
+  press_chart_sum += *press;
+  if (++press_chart_count == PRESS_CHART_INTERVAL) {
+    barograph_add(ssd1306, &press_chart, press_chart_sum / PRESS_CHART_INTERVAL);
+    press_chart_sum = 0;
+    press_chart_count = 0;
+  }
+#else
+  if (sparkline_add(&press_chart, *press)) {
+    sparkline_draw(ssd1306, &press_chart);
+  }
+#endif
+  ssd1306_flush(ssd1306);
+}
+
+// UART and queued I2C transactions stop in power-down
+bool is_bus_busy(void) {
+  return uart_is_busy() || i2c_is_busy();
+}
+
+// Binary frames by default, text lines with TELEMETRY_TEXT
+void send_telemetry(const station_t *station, bool is_valid) {
+  const telemetry_measurement_t measurement = {
+    .time = station->time,
+    .UT = station->bmp180->UT,
+    .UP = station->bmp180->UP,
+    .temp = station->temp,
+    .press = station->press,
+    .current = station->current,
+    .status = (is_valid ? _BV(TELEMETRY_STATUS_VALID) : 0)
+      | (tendency_get_category(&press_tendency) != TENDENCY_UNKNOWN ? _BV(TELEMETRY_STATUS_TENDENCY) : 0),
+  };
+#ifdef TELEMETRY_TEXT
+  telemetry_print(&telemetry, &measurement);
+#else
+  telemetry_send(&telemetry, &measurement);
+#endif
+}
+
+void measure_task(void *context) {
+  station_t *station = context;
+  station->time += MEASURE_INTERVAL;
+  station->prev_temp = station->temp;
+  station->current = power_get_average_current(&power);
+  power_reset_statistics(&power);
+#ifdef SENSOR_ARRAY
+  const bool is_ok = sensor_array_measure(&sensors, &station->temp, &station->press);
+#else
+  const bool is_ok = bmp180_sampler_measure(station->bmp180, &station->sampler_cfg, &station->temp, &station->press);
+#endif
+  if (is_ok) {
+    if (station->is_first_measure) {
+      station->is_first_measure = false;
+      station->prev_temp = station->temp;
+      station->temp_chart = barograph_create(TEMP_CHART_PAGE, TEMP_CHART_PAGE, SSD1306_COLUMN_START_ADDRESS, SSD1306_COLUMN_END_ADDRESS, station->temp - TEMP_CHART_RANGE, station->temp + TEMP_CHART_RANGE);
+#ifdef SSD1306_FRAMEBUFFER
+      press_chart = barograph_create(PRESS_CHART_PAGE, PRESS_CHART_PAGE, SSD1306_COLUMN_START_ADDRESS, SSD1306_COLUMN_END_ADDRESS, station->press - PRESS_CHART_RANGE, station->press + PRESS_CHART_RANGE);
+#elif !defined(SSD1306_CONTENT_SCROLL)
+      barograph_set_history(&station->temp_chart, temp_chart_history);
+#endif
+    }
+    tendency_add(&press_tendency, station->press);
+    eeprom_log_append(&history, station->time, station->temp, station->press);
+    station->is_measured = true;
+  }
+  send_telemetry(station, is_ok);
+}
+
+#ifdef BMP180_BENCHMARK
+// Zero-terminated text line, passed through by tools/telemetry_decoder.py
+static void send_line(const char *text) {
+  while (!uart_write((const uint8_t *)text, strlen(text) + 1)) {}
+}
+
+// Line of the table: mode, samples, filter (A = average, M = median), burst time in us, deviation in 0.01 Pa
+static void send_benchmark(const bmp180_benchmark_t *benchmark, void *context) {
+  bmp180_benchmark_t *best = context;
+  char text[UART_TX_BUFFER_SIZE];
+  snprintf_P(text, sizeof(text), PSTR("BMP180 %u %u %c %lu %u\r\n"), benchmark->mode, benchmark->samples,
+    benchmark->filter == BMP180_FILTER_MEDIAN ? 'M' : 'A', (unsigned long)benchmark->conversion_time, benchmark->deviation);
+  send_line(text);
+  if (benchmark->deviation <= PRESS_NOISE_TARGET && benchmark->conversion_time < best->conversion_time) {
+    *best = *benchmark;
+  }
+}
+
+// Noise against conversion time of every mode and sample count, the pressure must be stable meanwhile
+static void run_benchmark(bmp180_t *bmp180) {
+  bmp180_benchmark_t best = { .conversion_time = UINT32_MAX };
+  send_line("BMP180 mode samples filter time_us deviation_0.01Pa\r\n");
+  bmp180_sampler_benchmark_all(bmp180, BMP180_FILTER_AVERAGE, BENCHMARK_ROUNDS, send_benchmark, &best);
+  bmp180_sampler_benchmark_all(bmp180, BMP180_FILTER_MEDIAN, BENCHMARK_ROUNDS, send_benchmark, &best);
+  char text[UART_TX_BUFFER_SIZE];
+  snprintf_P(text, sizeof(text), PSTR("BMP180 best %u %u %c %lu %u\r\n"), best.mode, best.samples,
+    best.filter == BMP180_FILTER_MEDIAN ? 'M' : 'A', (unsigned long)best.conversion_time, best.deviation);
+  send_line(text);
+}
+#endif
+
+#ifdef SENSOR_ARRAY
+// Calibration is read with the channel of the sensor selected
+bool init_sensor(bmp180_t *bmp180, uint8_t channel) {
+  bmp180_set_mode(bmp180, PRESS_ARRAY_MODE);
+  bmp180_set_temperature_cache(bmp180, TEMP_CACHE_MAX_AGE_MS, TEMP_CACHE_MAX_DRIFT, scheduler_get_time);
+  return sensor_array_select_tca9548a(channel, &mux_address) && bmp180_init(bmp180);
+}
+#endif
 
-  ssd1306_draw_bitmap(ssd1306, 4, IMG_MARGIN, BAROMETER_BITMAP_WIDTH, BAROMETER_BITMAP_HEIGHT, barometer_bitmap);
-  sprintf_P(buff, PSTR(" %dh%c"), bmp180_pressure_to_mm(press), get_trend(prev_press, press));
-  ssd1306_print(ssd1306, buff, 5, BAROMETER_BITMAP_WIDTH + TEXT_MARGIN + IMG_MARGIN);
+#ifdef I2C_PROFILE
+// Profile lines are zero-terminated, so they are separate from the binary telemetry frames.
+// All lines are formatted from one copy, also when they are sent in several runs.
+void profile_task(void *context) {
+  static uint8_t line = 0;
+  static i2c_profile_t profile;
+  char text[I2C_PROFILE_LINE_LENGTH];
+  uint8_t length;
+  if (line == 0) {
+    i2c_profile_get(&profile);
+  }
+  while ((length = i2c_profile_format(&profile, line, text, sizeof(text))) > 0) {
+    if (!uart_write((const uint8_t *)text, length + 1)) {
+      scheduler_add_once(&scheduler, profile_task, NULL, PROFILE_RETRY_MS, PROFILE_RETRY_MS);
+      return;
+    }
+    line++;
+  }
+  line = 0;
+}
+#endif
+
+#ifdef DISPLAY_SLEEP
+void display_off_task(void *context) {
+  station_t *station = context;
+  ssd1306_display_off(station->ssd1306);
+}
+#endif
+
+void display_task(void *context) {
+  station_t *station = context;
+  if (!station->is_measured) {
+    return;
+  }
+  station->is_measured = false;
+#ifdef DISPLAY_SLEEP
+  ssd1306_display_on(station->ssd1306);
+  scheduler_add_once(&scheduler, display_off_task, station, DISPLAY_ON_MS, DISPLAY_ON_MS);
+#endif
+  update_display(station->ssd1306, &station->prev_temp, &station->temp, &station->press);
+  update_forecast(station->forecast_display, &station->qnh, &station->press);
+  update_charts(station->ssd1306, &station->temp_chart, &station->temp, &station->press);
+}
+
+void heartbeat_off_task(void *context) {
+  clear_bit(PORTB, LED_PIN);
+}
+
+void heartbeat_task(void *context) {
+  set_bit(PORTB, LED_PIN);
+  scheduler_add_once(&scheduler, heartbeat_off_task, NULL, HEARTBEAT_ON_MS, HEARTBEAT_DEADLINE_MS);
 }
 
 int main(void) {
   set_bit(DDRB, LED_PIN); // Pin as OUTPUT
 
   i2c_init();
+  uart_init(UART_BAUD_RATE);
+  telemetry_init(&telemetry);
+  sei(); // Queued I2C transactions are driven by the TWI interrupt
+  power_init(&power);
 
   ssd1306_config_t ssd1306_cfg = ssd1306_create_config(SSD1306_I2C_ADDRESS);
   // ssd1306_cfg.contrast = 1;
   ssd1306_t ssd1306 = ssd1306_create(&ssd1306_cfg);
   ssd1306_set_font(&ssd1306, &numeric_font);
+#ifdef SSD1306_FRAMEBUFFER
+  ssd1306_set_framebuffer(&ssd1306, &framebuffer);
+#endif
 
   if (!ssd1306_init(&ssd1306, &ssd1306_cfg)) {
     while(1) {}
   }
+  draw_layout(&ssd1306);
+  temp_field = ssd1306_create_text_field(TEMP_PAGE, TEMP_COLUMN, TEXT_LENGTH);
+  press_field = ssd1306_create_text_field(PRESS_PAGE, PRESS_COLUMN, TEXT_LENGTH);
+
+  ssd1306_t forecast_display = ssd1306; // Same display, forecast glyphs as font
+  ssd1306_set_font(&forecast_display, &forecast_font);
+  forecast_field = ssd1306_create_text_field(FORECAST_PAGE, FORECAST_COLUMN, 1);
 
   bmp180_t bmp180 = bmp180_create(BMP180_I2C_ADDRESS);
+#ifdef SENSOR_ARRAY
+  bmp180_t second_bmp180 = bmp180_create(BMP180_I2C_ADDRESS);
+  // Channel 0 stays selected for BMP180_BENCHMARK
+  if (!init_sensor(&second_bmp180, 1) || !init_sensor(&bmp180, 0)) {
+    while(1) {}
+  }
+  sensor_array_init(&sensors, sensor_array_select_tca9548a, &mux_address, PRESS_DISAGREEMENT);
+  sensor_array_add(&sensors, &bmp180, 0);
+  sensor_array_add(&sensors, &second_bmp180, 1);
+#else
   if (!bmp180_init(&bmp180)) {
     while(1) {}
   }
+  bmp180_set_temperature_cache(&bmp180, TEMP_CACHE_MAX_AGE_MS, TEMP_CACHE_MAX_DRIFT, scheduler_get_time);
+#endif
+  station.ssd1306 = &ssd1306;
+  station.forecast_display = &forecast_display;
+  station.bmp180 = &bmp180;
+  station.sampler_cfg = bmp180_sampler_create_config();
+  station.sampler_cfg.samples = PRESS_SAMPLES;
+#ifdef BMP180_BENCHMARK
+  run_benchmark(&bmp180);
+#endif
+  station.is_first_measure = true;
 
-  bool is_first_measure = true;
-  int32_t prev_temp = 0;
-  int32_t prev_press = 0;
-  int32_t temp = 0; // Temperature in 0.1 C
-  int32_t press = 0; // Pressure in Pa
-
-  while (1) {
-    prev_temp = temp;
-    prev_press = press;
-    if (bmp180_get_temperature(&bmp180, &temp) && bmp180_get_pressure(&bmp180, &press)) {
-      if (is_first_measure) {
-        is_first_measure = false;
-        prev_temp = temp;
-        prev_press = press;
-      }
-      update_display(&ssd1306, &prev_temp, &temp, &prev_press, &press);
-    }
-    _delay_ms(60000);
-  }
-}
\ No newline at end of file
+#ifndef SSD1306_FRAMEBUFFER
+  sparkline_init(&press_chart, PRESS_CHART_PAGE, PRESS_CHART_PAGE, SSD1306_COLUMN_START_ADDRESS, SSD1306_WIDTH, PRESS_CHART_INTERVAL);
+#endif
+  tendency_init(&press_tendency, PRESS_TENDENCY_INTERVAL);
+  station.qnh = units_qnh_create(STATION_ALTITUDE);
+  eeprom_log_init(&history, MEASURE_INTERVAL);
+  eeprom_log_set_dead_band(&history, HISTORY_DEAD_BAND);
+  station.time = eeprom_log_get_time(&history);
+
+  // BMP180 is in standby after its conversions, the CPU sleeps between the tasks
+  scheduler_init(&scheduler, &power);
+  scheduler_set_busy(&scheduler, is_bus_busy);
+  scheduler_add_periodic(&scheduler, measure_task, &station, MEASURE_INTERVAL * 1000UL, MEASURE_DEADLINE_MS);
+  scheduler_add_periodic(&scheduler, display_task, &station, DISPLAY_INTERVAL_MS, DISPLAY_DEADLINE_MS);
+  scheduler_add_periodic(&scheduler, heartbeat_task, NULL, HEARTBEAT_INTERVAL_MS, HEARTBEAT_DEADLINE_MS);
+#ifdef I2C_PROFILE
+  scheduler_add_periodic(&scheduler, profile_task, NULL, PROFILE_INTERVAL_MS, PROFILE_INTERVAL_MS);
+#endif
+  scheduler_run(&scheduler);
+}
@@ -0,0 +1,204 @@
+/**
+ * Tests of the BMP180 compensation, run on the host: pio test -e native
+ * The calibration is read over I2C from the simulated BMP180 (native/src/sim_bmp180.c),
+ * which has the calibration of the datasheet example by default.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <unity.h>
+#include "i2c.h"
+#include "bmp180.h"
+#include "native.h"
+#include "sim_bmp180.h"
+
+#define BMP180_I2C_ADDRESS 0x77
+#define DATASHEET_UT 27898
+#define DATASHEET_UP 23843 // Ultra low power mode
+#define DATASHEET_TEMPERATURE 150 // 15.0 C
+#define DATASHEET_PRESSURE 69964 // Pa
+#define SWEEP_UT_MIN 0
+#define SWEEP_UT_MAX UINT16_MAX
+#define SWEEP_UT_STEP 61
+#define SWEEP_TEMPERATURE_MIN -400 // 0.1 C, operating range of the sensor
+#define SWEEP_TEMPERATURE_MAX 850
+#define SWEEP_UP_STEPS 2048 // UP values per UT and mode, over the whole 16 + oss bit range
+#define SWEEP_PRESSURE_MIN 20000 // Pa, results outside are not physical for the sensor (300-1100 hPa)
+#define SWEEP_PRESSURE_MAX 150000
+#define CACHE_I2C_ADDRESS 0x76 // Simulated BMP180 of the temperature cache tests
+#define CACHE_TEMPERATURE 20.0 // C
+#define CACHE_MAX_AGE_MS 1000
+#define DRIFT_MAX_AGE_MS 60000
+#define DRIFT_TEMPERATURE 21.0 // C, 1.0 C in DRIFT_MAX_AGE_MS
+#define DRIFT_MAX 5 // 0.5 C
+#define DRIFT_STALE_MS 32768 // 0.5 C at 10 / 65536 ms (1.0 C per 60 s, rounded down)
+#define INIT_BUS_US 600 // One 22 byte burst at 400 kHz, 11 word reads took 1318 us
+
+static bmp180_t* bmp180;
+static sim_bmp180_t cache_sim;
+static uint32_t clock_ms;
+
+static uint32_t get_clock(void) {
+    return clock_ms;
+}
+
+void setUp(void) {
+    TEST_ASSERT_TRUE(bmp180_init(bmp180));
+    sim_bmp180_config_t config = sim_bmp180_create_config();
+    config.temp = (sim_bmp180_trajectory_t){ .base = CACHE_TEMPERATURE };
+    sim_bmp180_init(&cache_sim, &config);
+    clock_ms = 0;
+}
+
+void tearDown(void) {}
+
+// Datasheet algorithm in 64-bit arithmetic, no intermediate result can overflow
+static int64_t reference_b5(const bmp180_calibration_data_t* c, int64_t ut) {
+    const int64_t x1 = ((ut - c->AC6) * c->AC5) >> 15;
+    const int64_t x2 = ((int64_t)c->MC << 11) / (x1 + c->MD);
+    return x1 + x2;
+}
+
+static int64_t reference_pressure(const bmp180_calibration_data_t* c, int64_t b5, int64_t up, uint8_t oss) {
+    const int64_t b6 = b5 - 4000;
+    int64_t x1 = (c->B2 * ((b6 * b6) >> 12)) >> 11;
+    int64_t x2 = (c->AC2 * b6) >> 11;
+    int64_t x3 = x1 + x2;
+    const int64_t b3 = ((((int64_t)c->AC1 * 4 + x3) << oss) + 2) / 4;
+    x1 = (c->AC3 * b6) >> 13;
+    x2 = (c->B1 * ((b6 * b6) >> 12)) >> 16;
+    x3 = ((x1 + x2) + 2) >> 2;
+    const int64_t b4 = (c->AC4 * (x3 + 32768)) >> 15;
+    const int64_t b7 = (up - b3) * (50000 >> oss);
+    const int64_t p = b7 < 0x80000000 ? (b7 * 2) / b4 : (b7 / b4) * 2;
+    x1 = (p >> 8) * (p >> 8);
+    x1 = (x1 * 3038) >> 16;
+    x2 = (-7357 * p) >> 16;
+    return p + ((x1 + x2 + 3791) >> 4);
+}
+
+static void test_calibration(void) {
+    TEST_ASSERT_EQUAL_INT16(408, bmp180->data.AC1);
+    TEST_ASSERT_EQUAL_INT16(-72, bmp180->data.AC2);
+    TEST_ASSERT_EQUAL_INT16(-14383, bmp180->data.AC3);
+    TEST_ASSERT_EQUAL_UINT16(32741, bmp180->data.AC4);
+    TEST_ASSERT_EQUAL_UINT16(32757, bmp180->data.AC5);
+    TEST_ASSERT_EQUAL_UINT16(23153, bmp180->data.AC6);
+    TEST_ASSERT_EQUAL_INT16(6190, bmp180->data.B1);
+    TEST_ASSERT_EQUAL_INT16(4, bmp180->data.B2);
+    TEST_ASSERT_EQUAL_INT16(-32768, bmp180->data.MB);
+    TEST_ASSERT_EQUAL_INT16(-8711, bmp180->data.MC);
+    TEST_ASSERT_EQUAL_INT16(2868, bmp180->data.MD);
+}
+
+// The calibration is read in one transaction
+static void test_init_bus_time(void) {
+    const uint64_t start_ns = native_get_time_ns();
+    TEST_ASSERT_TRUE(bmp180_init(bmp180));
+    TEST_ASSERT_TRUE(native_get_time_ns() - start_ns < INIT_BUS_US * 1000ULL);
+}
+
+static void test_datasheet_example(void) {
+    bmp180_set_mode(bmp180, BMP180_ULTRA_LOW_POWER_MODE);
+    TEST_ASSERT_EQUAL_INT32(DATASHEET_TEMPERATURE, bmp180_compensate_temperature(bmp180, DATASHEET_UT));
+    TEST_ASSERT_EQUAL_INT32(DATASHEET_PRESSURE, bmp180_compensate_pressure(bmp180, DATASHEET_UP));
+}
+
+static void test_reference_sweep(void) {
+    const bmp180_calibration_data_t* c = &bmp180->data;
+    uint32_t compared = 0;
+    for (uint8_t oss = BMP180_ULTRA_LOW_POWER_MODE; oss <= BMP180_ULTRA_HIGH_RESOLUTION_MODE; oss++) {
+        bmp180_set_mode(bmp180, oss);
+        const int32_t up_max = (int32_t)1 << (16 + oss);
+        for (int32_t ut = SWEEP_UT_MIN; ut <= SWEEP_UT_MAX; ut += SWEEP_UT_STEP) {
+            const int64_t b5 = reference_b5(c, ut);
+            const int64_t temperature = (b5 + 8) >> 4;
+            if (temperature < SWEEP_TEMPERATURE_MIN || temperature > SWEEP_TEMPERATURE_MAX) {
+                continue;
+            }
+            TEST_ASSERT_EQUAL_INT32(temperature, bmp180_compensate_temperature(bmp180, ut));
+            TEST_ASSERT_EQUAL_INT32(b5, bmp180->B5);
+            for (int32_t up = 0; up < up_max; up += up_max / SWEEP_UP_STEPS + 1) {
+                const int64_t expected = reference_pressure(c, b5, up, oss);
+                if (expected < SWEEP_PRESSURE_MIN || expected > SWEEP_PRESSURE_MAX) {
+                    continue;
+                }
+                const int32_t actual = bmp180_compensate_pressure(bmp180, up);
+                if (actual != expected) {
+                    char message[64];
+                    snprintf(message, sizeof(message), "oss %u, UT %ld, UP %ld", oss, (long)ut, (long)up);
+                    TEST_ASSERT_EQUAL_INT32_MESSAGE(expected, actual, message);
+                }
+                compared++;
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(compared > 100000);
+}
+
+// Pressure reads measure temperature only when it is older than max_age
+static void test_temperature_cache_age(void) {
+    bmp180_t sensor = bmp180_create(CACHE_I2C_ADDRESS);
+    TEST_ASSERT_TRUE(bmp180_init(&sensor));
+    int32_t press;
+    bmp180_set_temperature_cache(&sensor, CACHE_MAX_AGE_MS, 0, get_clock);
+    TEST_ASSERT_TRUE(bmp180_is_temperature_stale(&sensor)); // Never measured
+    TEST_ASSERT_TRUE(bmp180_get_pressure(&sensor, &press));
+    TEST_ASSERT_EQUAL_UINT32(2, cache_sim.conversions);
+    TEST_ASSERT_EQUAL_INT32(200, sensor.temperature);
+
+    clock_ms = CACHE_MAX_AGE_MS - 1;
+    TEST_ASSERT_FALSE(bmp180_is_temperature_stale(&sensor));
+    TEST_ASSERT_TRUE(bmp180_get_pressure(&sensor, &press));
+    TEST_ASSERT_EQUAL_UINT32(3, cache_sim.conversions);
+
+    clock_ms = CACHE_MAX_AGE_MS;
+    TEST_ASSERT_TRUE(bmp180_is_temperature_stale(&sensor));
+    TEST_ASSERT_TRUE(bmp180_get_pressure(&sensor, &press));
+    TEST_ASSERT_EQUAL_UINT32(5, cache_sim.conversions);
+    TEST_ASSERT_FALSE(bmp180_is_temperature_stale(&sensor));
+}
+
+// A temperature change between two measurements makes the cache stale sooner
+static void test_temperature_cache_drift(void) {
+    bmp180_t sensor = bmp180_create(CACHE_I2C_ADDRESS);
+    TEST_ASSERT_TRUE(bmp180_init(&sensor));
+    int32_t press;
+    bmp180_set_temperature_cache(&sensor, DRIFT_MAX_AGE_MS, DRIFT_MAX, get_clock);
+    TEST_ASSERT_TRUE(bmp180_get_pressure(&sensor, &press));
+    cache_sim.config.temp.base = DRIFT_TEMPERATURE;
+    clock_ms = DRIFT_MAX_AGE_MS;
+    TEST_ASSERT_TRUE(bmp180_get_pressure(&sensor, &press)); // Stale by age
+    TEST_ASSERT_EQUAL_INT32(210, sensor.temperature);
+    TEST_ASSERT_EQUAL_UINT32(4, cache_sim.conversions);
+
+    clock_ms = DRIFT_MAX_AGE_MS + DRIFT_STALE_MS - 1;
+    TEST_ASSERT_FALSE(bmp180_is_temperature_stale(&sensor));
+    clock_ms = DRIFT_MAX_AGE_MS + DRIFT_STALE_MS;
+    TEST_ASSERT_TRUE(bmp180_is_temperature_stale(&sensor));
+    TEST_ASSERT_TRUE(bmp180_get_pressure(&sensor, &press));
+    TEST_ASSERT_EQUAL_UINT32(6, cache_sim.conversions);
+
+    // No drift bound: only the age counts
+    bmp180_set_temperature_cache(&sensor, DRIFT_MAX_AGE_MS, 0, get_clock);
+    clock_ms += DRIFT_MAX_AGE_MS - 1;
+    TEST_ASSERT_FALSE(bmp180_is_temperature_stale(&sensor));
+}
+
+int main(void) {
+    i2c_init();
+    bmp180_t sensor = bmp180_create(BMP180_I2C_ADDRESS);
+    bmp180 = &sensor;
+    i2c_device_t cache_device = sim_bmp180_create_device(&cache_sim, CACHE_I2C_ADDRESS);
+    i2c_native_attach(&cache_device);
+    UNITY_BEGIN();
+    RUN_TEST(test_calibration);
+    RUN_TEST(test_init_bus_time);
+    RUN_TEST(test_datasheet_example);
+    RUN_TEST(test_reference_sweep);
+    RUN_TEST(test_temperature_cache_age);
+    RUN_TEST(test_temperature_cache_drift);
+    return UNITY_END();
+}
@@ -0,0 +1,221 @@
+/**
+ * Tests of the history log in EEPROM, run on the host: pio test -e native
+ * The log is written to the simulated EEPROM (native/src/native.c), which can lose the writes
+ * after a given byte as if the power failed in the middle of a record or a block header.
+ * Every test reads the log back with the reverse iterator, also as a new log after a reset.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/eeprom.h>
+#include <unity.h>
+#include "eeprom_log.h"
+#include "native.h"
+
+#define INTERVAL 60 // Seconds between samples
+#define START_TIME 3600
+#define TEMP 215 // 21.5 C
+#define PRESS 101320 // Pa, a multiple of 10 Pa is logged exactly
+#define RUN_SAMPLES 70 // More than one run record
+#define WEAR_SAMPLES 400 // About 44 blocks, the ring turns more than twice
+#define TORN_SAMPLES 5
+#define GAP (10 * INTERVAL) // Time gap that starts a new block
+#define MAX_SAMPLES 512
+#define EEPROM_SIZE (E2END + 1)
+
+static eeprom_log_t history;
+static eeprom_log_sample_t samples[MAX_SAMPLES]; // Appended samples as they are logged
+static uint16_t sample_count;
+static uint32_t next_time;
+
+static void append(int32_t temp, int32_t press) {
+    eeprom_log_append(&history, next_time, temp, press);
+    samples[sample_count++] = (eeprom_log_sample_t){ .time = next_time, .temp = temp, .press = press };
+    next_time += INTERVAL;
+}
+
+static uint16_t count_samples(const eeprom_log_t* log) {
+    eeprom_log_iterator_t iterator = eeprom_log_iterate(log);
+    eeprom_log_sample_t sample;
+    uint16_t count = 0;
+    while (eeprom_log_prev(&iterator, &sample)) {
+        count++;
+    }
+    return count;
+}
+
+// The log holds exactly the last count appended samples
+static void assert_samples(const eeprom_log_t* log, uint16_t count) {
+    eeprom_log_iterator_t iterator = eeprom_log_iterate(log);
+    eeprom_log_sample_t sample;
+    for (uint16_t i = 0; i < count; i++) {
+        const eeprom_log_sample_t* expected = &samples[sample_count - 1 - i];
+        TEST_ASSERT_TRUE(eeprom_log_prev(&iterator, &sample));
+        TEST_ASSERT_EQUAL_UINT32(expected->time, sample.time);
+        TEST_ASSERT_EQUAL_INT16(expected->temp, sample.temp);
+        TEST_ASSERT_EQUAL_INT32(expected->press, sample.press);
+    }
+    TEST_ASSERT_FALSE(eeprom_log_prev(&iterator, &sample));
+}
+
+// Log found in EEPROM after a reset
+static eeprom_log_t reset(void) {
+    eeprom_log_t log;
+    eeprom_log_init(&log, INTERVAL);
+    return log;
+}
+
+void setUp(void) {
+    native_eeprom_lose_writes(NATIVE_EEPROM_NO_LOSS);
+    eeprom_log_init(&history, INTERVAL);
+    eeprom_log_clear(&history);
+    sample_count = 0;
+    next_time = START_TIME;
+}
+
+void tearDown(void) {}
+
+// Runs, small deltas and varint deltas of up to 3 bytes are decoded backward to the exact samples
+static void test_round_trip(void) {
+    append(TEMP, PRESS);
+    for (uint8_t i = 0; i < RUN_SAMPLES; i++) {
+        append(TEMP, PRESS);
+    }
+    int32_t temp = TEMP;
+    int32_t press = PRESS;
+    for (int8_t i = 0; i < 16; i++) {
+        temp += i % 8 - 4; // -4..3
+        press += (i - 8) * 10; // -8..7 in 0.1 hPa
+        append(temp, press);
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+        append(i % 2 ? 850 : -400, i % 2 ? 650000 : 30000); // 7 byte records
+    }
+    TEST_ASSERT_TRUE(history.blocks > 1);
+    assert_samples(&history, sample_count);
+
+    eeprom_log_t log = reset();
+    TEST_ASSERT_EQUAL_UINT8(history.head, log.head);
+    TEST_ASSERT_EQUAL_UINT32(samples[sample_count - 1].time, eeprom_log_get_time(&log));
+    assert_samples(&log, sample_count);
+
+    // Samples after the reset start a new block
+    history = log;
+    append(TEMP, PRESS);
+    TEST_ASSERT_EQUAL_UINT8((log.head + 1) % EEPROM_LOG_BLOCKS, history.head);
+    assert_samples(&history, sample_count);
+}
+
+// Blocks are written in turn, the oldest block is overwritten when the ring is full
+static void test_wear_levelling(void) {
+    uint16_t starts[EEPROM_LOG_BLOCKS] = {};
+    uint16_t blocks = 0;
+    for (uint16_t i = 0; i < WEAR_SAMPLES; i++) {
+        const uint8_t head = history.head;
+        append(TEMP + (i % 2 ? 200 : -200), PRESS + (i % 2 ? 3000 : -3000));
+        if (history.head != head) {
+            starts[history.head]++;
+            blocks++;
+        }
+    }
+    TEST_ASSERT_TRUE(blocks > 2 * EEPROM_LOG_BLOCKS);
+    for (uint8_t block = 0; block < EEPROM_LOG_BLOCKS; block++) {
+        TEST_ASSERT_TRUE(starts[block] == blocks / EEPROM_LOG_BLOCKS || starts[block] == blocks / EEPROM_LOG_BLOCKS + 1);
+    }
+    TEST_ASSERT_EQUAL_UINT8(EEPROM_LOG_BLOCKS, history.blocks);
+    TEST_ASSERT_EQUAL_UINT16(blocks - 1, history.sequence);
+
+    // All samples of the last 16 blocks and no older one
+    const uint16_t count = count_samples(&history);
+    const uint16_t block_samples = WEAR_SAMPLES / blocks;
+    TEST_ASSERT_TRUE(count > (EEPROM_LOG_BLOCKS - 1) * block_samples && count < WEAR_SAMPLES);
+    assert_samples(&history, count);
+
+    eeprom_log_t log = reset();
+    TEST_ASSERT_EQUAL_UINT8(history.head, log.head);
+    TEST_ASSERT_EQUAL_UINT8(EEPROM_LOG_BLOCKS, log.blocks);
+    assert_samples(&log, count);
+}
+
+/**
+ * Power fails after every byte of the append in turn, the log after the reset has the samples
+ * before it and the new sample only when all of its bytes were written.
+*/
+static void assert_torn_append(int32_t temp, int32_t press) {
+    static uint8_t image[EEPROM_SIZE];
+    eeprom_read_block(image, 0, sizeof(image));
+    const eeprom_log_t saved = history;
+    const uint16_t saved_count = sample_count;
+    const uint32_t saved_time = next_time;
+
+    const uint32_t start_writes = native_eeprom_get_writes();
+    append(temp, press);
+    const uint32_t writes = native_eeprom_get_writes() - start_writes;
+    TEST_ASSERT_TRUE(writes > 2);
+
+    for (uint32_t written = 0; written <= writes; written++) {
+        eeprom_update_block(image, 0, sizeof(image));
+        history = saved;
+        sample_count = saved_count;
+        next_time = saved_time;
+        native_eeprom_lose_writes(written);
+        append(temp, press);
+        native_eeprom_lose_writes(NATIVE_EEPROM_NO_LOSS);
+
+        eeprom_log_t log = reset();
+        if (written < writes) {
+            sample_count--;
+        }
+        assert_samples(&log, sample_count);
+        TEST_ASSERT_EQUAL_UINT32(samples[sample_count - 1].time, eeprom_log_get_time(&log));
+    }
+}
+
+// Reset in the middle of a varint record
+static void test_torn_record(void) {
+    for (uint8_t i = 0; i < TORN_SAMPLES; i++) {
+        append(TEMP + i, PRESS + i * 10);
+    }
+    assert_torn_append(TEMP + 500, PRESS + 20000);
+}
+
+// Reset while a block is erased and its header written, over a block that held old data
+static void test_torn_block(void) {
+    static uint8_t garbage[EEPROM_SIZE];
+    for (uint16_t i = 0; i < sizeof(garbage); i++) {
+        garbage[i] = (uint8_t)i;
+    }
+    eeprom_update_block(garbage, 0, sizeof(garbage));
+    eeprom_log_clear(&history);
+    for (uint8_t i = 0; i < TORN_SAMPLES; i++) {
+        append(TEMP + i, PRESS + i * 10);
+    }
+    next_time += GAP;
+    assert_torn_append(TEMP, PRESS);
+}
+
+// Changes within the dead band are logged as no change, the logged value follows with a lag
+static void test_dead_band(void) {
+    eeprom_log_set_dead_band(&history, 1);
+    eeprom_log_clear(&history);
+    TEST_ASSERT_EQUAL_UINT8(1, history.dead_band);
+    append(TEMP, PRESS);
+    append(TEMP + 1, PRESS - 10);
+    append(TEMP + 2, PRESS + 10);
+    samples[1] = samples[0]; // Logged as no change
+    samples[1].time += INTERVAL;
+    samples[2].press = PRESS; // Pressure is still within the dead band
+    assert_samples(&history, sample_count);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_wear_levelling);
+    RUN_TEST(test_torn_record);
+    RUN_TEST(test_torn_block);
+    RUN_TEST(test_dead_band);
+    return UNITY_END();
+}
@@ -0,0 +1,326 @@
+/**
+ * Tests of the interrupt-driven I2C driver, run on the host: pio test -e native
+ * lib/i2c/i2c.c runs on the simulated TWI (native/src/native.c) with a register file device
+ * that logs what it sees on the bus: S/Sr START/repeated START, w/r direction, written bytes,
+ * <read bytes (n = not acknowledged by the master) and P when it is released.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/twi.h>
+#include <unity.h>
+#include "i2c.h"
+#include "i2c_native.h"
+#include "native.h"
+
+#define DEVICE_I2C_ADDRESS 0x42
+#define ABSENT_I2C_ADDRESS 0x50
+#define NACK_BYTE 0xEE // Written byte the device doesn't acknowledge
+#define BUS_ERROR_BYTE 0xBE // Written byte after which the bus fails
+#define LOG_SIZE 256
+#define REPEAT_COUNT 300 // More than a transaction of 255 bytes
+#define READ_LENGTH 261
+
+typedef struct {
+    uint8_t registers[256];
+    uint8_t pointer;
+    bool is_started;
+    bool is_pointer_set; // First byte written after START
+    uint16_t written; // Bytes written since the last reset
+    uint16_t read;
+    uint16_t not_acknowledged; // Read bytes the master didn't acknowledge
+    char log[LOG_SIZE];
+} test_device_t;
+
+static test_device_t device;
+static i2c_device_t bus_device;
+static uint8_t callbacks;
+
+static void device_log(const char* text) {
+    if (strlen(device.log) + strlen(text) < LOG_SIZE) {
+        strcat(device.log, text);
+    }
+}
+
+static bool device_start(void* context, i2c_mode_t mode) {
+    device_log(device.is_started ? "Sr " : "S ");
+    device_log(mode == I2C_MODE_READ ? "r " : "w ");
+    device.is_started = true;
+    device.is_pointer_set = false;
+    return true;
+}
+
+static bool device_write(void* context, uint8_t byte) {
+    char text[8];
+    snprintf(text, sizeof(text), "%02X ", byte);
+    device.written++;
+    if (device.written <= 16) {
+        device_log(text);
+    }
+    if (byte == BUS_ERROR_BYTE) {
+        native_twi_bus_error();
+    }
+    if (!device.is_pointer_set) {
+        device.pointer = byte;
+        device.is_pointer_set = true;
+    }
+    else {
+        device.registers[device.pointer++] = byte;
+    }
+    return byte != NACK_BYTE;
+}
+
+static uint8_t device_read(void* context, bool ack) {
+    char text[8];
+    const uint8_t byte = device.registers[device.pointer++];
+    snprintf(text, sizeof(text), ack ? "<%02X " : "<%02Xn ", byte);
+    device.read++;
+    device.not_acknowledged += !ack;
+    if (device.read <= 16) {
+        device_log(text);
+    }
+    return byte;
+}
+
+static void device_stop(void* context) {
+    device_log("P ");
+    device.is_started = false;
+}
+
+// The driver doesn't wait for the STOP on the bus until the next START
+static void wait_stop(void) {
+    loop_until_bit_is_clear(TWCR, TWSTO);
+}
+
+static void stop(void) {
+    i2c_stop();
+    wait_stop();
+}
+
+static void count_callback(i2c_transaction_t* transaction) {
+    callbacks++;
+}
+
+void setUp(void) {
+    memset(&device, 0, sizeof(device));
+    for (uint16_t i = 0; i < sizeof(device.registers); i++) {
+        device.registers[i] = i ^ 0x5A;
+    }
+    callbacks = 0;
+}
+
+void tearDown(void) {}
+
+static void test_read_registers(void) {
+    uint8_t data[3];
+    const bool is_ok = i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_WRITE) && i2c_write_byte(0x10) &&
+        i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_READ) && i2c_read_buffer(data, sizeof(data));
+    stop();
+    TEST_ASSERT_TRUE(is_ok);
+    TEST_ASSERT_EQUAL_STRING("S w 10 Sr r <4A <4B <48n P ", device.log);
+    TEST_ASSERT_EQUAL_UINT8(0x10 ^ 0x5A, data[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x12 ^ 0x5A, data[2]);
+}
+
+static void test_write_steps(void) {
+    static const uint8_t data_P[] PROGMEM = { 0x03, 0x04 };
+    const uint8_t data[] = { 0x01, 0x02 };
+    const bool is_ok = i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_WRITE) && i2c_write_byte(0x20) &&
+        i2c_write_buffer(data, sizeof(data)) && i2c_write_buffer_P(data_P, sizeof(data_P)) && i2c_write_repeat(0x55, 2);
+    stop();
+    TEST_ASSERT_TRUE(is_ok);
+    TEST_ASSERT_EQUAL_STRING("S w 20 01 02 03 04 55 55 P ", device.log);
+    TEST_ASSERT_EQUAL_UINT8(0x04, device.registers[0x23]);
+}
+
+static void test_read_bytes(void) {
+    uint8_t first = 0, second = 0;
+    const bool is_ok = i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_READ) && i2c_read_byte_ACK(&first) && i2c_read_byte_NACK(&second);
+    stop();
+    TEST_ASSERT_TRUE(is_ok);
+    TEST_ASSERT_EQUAL_STRING("S r <5A <5Bn P ", device.log);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, first);
+    TEST_ASSERT_EQUAL_UINT8(0x5B, second);
+}
+
+// The steps up to i2c_stop() fail, the next sequence works
+static void test_address_nack(void) {
+    TEST_ASSERT_FALSE(i2c_start(ABSENT_I2C_ADDRESS, I2C_MODE_WRITE));
+    TEST_ASSERT_EQUAL_UINT8(TW_MT_SLA_NACK, i2c_get_error());
+    TEST_ASSERT_FALSE(i2c_write_byte(0x10));
+    TEST_ASSERT_FALSE(i2c_write_buffer((const uint8_t*)"ab", 2));
+    stop();
+    TEST_ASSERT_EQUAL_STRING("", device.log);
+
+    TEST_ASSERT_TRUE(i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_WRITE));
+    stop();
+    TEST_ASSERT_EQUAL_STRING("S w P ", device.log);
+}
+
+static void test_data_nack(void) {
+    bool is_ok = i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_WRITE) && i2c_write_byte(0x10);
+    TEST_ASSERT_TRUE(is_ok);
+    TEST_ASSERT_FALSE(i2c_write_byte(NACK_BYTE)); // Polled step
+    TEST_ASSERT_EQUAL_UINT8(TW_MT_DATA_NACK, i2c_get_error());
+    TEST_ASSERT_FALSE(i2c_write_byte(0x01));
+    stop();
+    TEST_ASSERT_EQUAL_STRING("S w 10 EE P ", device.log);
+
+    // Queued step
+    device.log[0] = '\0';
+    const uint8_t data[] = { 0x10, NACK_BYTE, 0x01 };
+    is_ok = i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_WRITE) && i2c_write_buffer(data, sizeof(data));
+    stop();
+    TEST_ASSERT_FALSE(is_ok);
+    TEST_ASSERT_EQUAL_STRING("S w 10 EE P ", device.log);
+}
+
+// Transactions submitted while the blocking API holds the bus start after its STOP
+static void test_submit_during_sequence(void) {
+    const uint8_t pointer = 0x10;
+    uint8_t data[2];
+    i2c_transaction_t transaction = {
+        .address = DEVICE_I2C_ADDRESS,
+        .write_buffer = &pointer,
+        .write_length = 1,
+        .read_buffer = data,
+        .read_length = sizeof(data),
+        .callback = count_callback,
+    };
+    TEST_ASSERT_TRUE(i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_WRITE));
+    TEST_ASSERT_TRUE(i2c_submit(&transaction));
+    TEST_ASSERT_TRUE(i2c_write_byte(0x30));
+    TEST_ASSERT_EQUAL_UINT8(I2C_TRANSACTION_QUEUED, transaction.status);
+    stop();
+    TEST_ASSERT_TRUE(i2c_wait_transaction(&transaction));
+    wait_stop();
+    TEST_ASSERT_EQUAL_STRING("S w 30 P S w 10 Sr r <4A <4Bn P ", device.log);
+    TEST_ASSERT_EQUAL_UINT8(1, callbacks);
+    TEST_ASSERT_EQUAL_UINT8(I2C_NO_ERROR, transaction.error);
+}
+
+// A sequence of transactions on the held bus, an unrelated one goes after its STOP
+static void test_continue(void) {
+    const uint8_t pointer = 0x40;
+    const uint8_t data[] = { 0x01, 0x02 };
+    uint8_t read[2];
+    i2c_transaction_t first = { .address = DEVICE_I2C_ADDRESS, .write_buffer = &pointer, .write_length = 1, .flags = I2C_FLAG_NO_STOP };
+    i2c_transaction_t bytes = { .write_buffer = data, .write_length = sizeof(data), .flags = I2C_FLAG_CONTINUE | I2C_FLAG_NO_START | I2C_FLAG_NO_STOP };
+    i2c_transaction_t last = { .address = DEVICE_I2C_ADDRESS, .read_buffer = read, .read_length = sizeof(read), .flags = I2C_FLAG_CONTINUE };
+    i2c_transaction_t other = { .address = DEVICE_I2C_ADDRESS, .read_buffer = read, .read_length = 1 };
+    TEST_ASSERT_TRUE(i2c_transfer(&first));
+    TEST_ASSERT_TRUE(i2c_submit(&other));
+    TEST_ASSERT_TRUE(i2c_transfer(&bytes));
+    TEST_ASSERT_EQUAL_UINT8(I2C_TRANSACTION_QUEUED, other.status);
+    TEST_ASSERT_TRUE(i2c_transfer(&last));
+    TEST_ASSERT_TRUE(i2c_wait_transaction(&other));
+    wait_stop();
+    TEST_ASSERT_EQUAL_STRING("S w 40 01 02 Sr r <18 <19n P S r <1En P ", device.log);
+}
+
+// Steps longer than a transaction are sent in several
+static void test_chunks(void) {
+    TEST_ASSERT_TRUE(i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_WRITE) && i2c_write_repeat(0x11, REPEAT_COUNT));
+    stop();
+    TEST_ASSERT_EQUAL_UINT16(REPEAT_COUNT, device.written);
+    TEST_ASSERT_EQUAL_UINT8(0x11, device.registers[0x11]); // The first byte is the register pointer
+
+    static uint8_t data[READ_LENGTH];
+    device.read = 0;
+    const bool is_ok = i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_WRITE) && i2c_write_byte(0x00) &&
+        i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_READ) && i2c_read_buffer(data, READ_LENGTH);
+    stop();
+    TEST_ASSERT_TRUE(is_ok);
+    TEST_ASSERT_EQUAL_UINT16(READ_LENGTH, device.read);
+    TEST_ASSERT_EQUAL_UINT16(1, device.not_acknowledged); // Only the last byte
+    TEST_ASSERT_EQUAL_UINT8(device.registers[(READ_LENGTH - 1) % 256], data[READ_LENGTH - 1]);
+}
+
+// The failed transaction is not done, the next one starts with a new START
+static void test_bus_error(void) {
+    const uint8_t pointer[] = { 0x10, BUS_ERROR_BYTE };
+    uint8_t data[2] = { 0 };
+    i2c_transaction_t transaction = {
+        .address = DEVICE_I2C_ADDRESS,
+        .write_buffer = pointer,
+        .write_length = sizeof(pointer),
+        .read_buffer = data,
+        .read_length = sizeof(data),
+        .callback = count_callback,
+    };
+    TEST_ASSERT_FALSE(i2c_transfer(&transaction));
+    TEST_ASSERT_EQUAL_UINT8(I2C_TRANSACTION_ERROR, transaction.status);
+    TEST_ASSERT_EQUAL_UINT8(TW_BUS_ERROR, transaction.error);
+    TEST_ASSERT_EQUAL_UINT8(TW_BUS_ERROR, i2c_get_error());
+    TEST_ASSERT_EQUAL_UINT8(1, callbacks);
+
+    TEST_ASSERT_TRUE(i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_WRITE));
+    TEST_ASSERT_FALSE(i2c_write_byte(BUS_ERROR_BYTE) && i2c_write_byte(0x01)); // Polled step
+    TEST_ASSERT_EQUAL_UINT8(TW_BUS_ERROR, i2c_get_error());
+    stop();
+
+    transaction.write_length = 1;
+    TEST_ASSERT_TRUE(i2c_transfer(&transaction));
+    wait_stop();
+    TEST_ASSERT_EQUAL_STRING("S w 10 BE P S w BE P S w 10 Sr r <BE <4Bn P ", device.log);
+}
+
+// The driver doesn't enable interrupts of a caller that has them disabled
+static void test_interrupts_disabled(void) {
+    const uint8_t data[] = { 0x01, 0x02 };
+    cli();
+    const bool is_ok = i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_WRITE) && i2c_write_byte(0x60) && i2c_write_buffer(data, sizeof(data));
+    stop();
+    const uint8_t sreg = SREG;
+    sei();
+    TEST_ASSERT_TRUE(is_ok);
+    TEST_ASSERT_FALSE(sreg & _BV(SREG_I));
+    TEST_ASSERT_EQUAL_STRING("S w 60 01 02 P ", device.log);
+}
+
+// One place of the queue is kept for the sequence on the held bus
+static void test_queue_full(void) {
+    static uint8_t data[I2C_QUEUE_SIZE];
+    static i2c_transaction_t transactions[I2C_QUEUE_SIZE];
+    TEST_ASSERT_TRUE(i2c_start(DEVICE_I2C_ADDRESS, I2C_MODE_READ)); // Nothing else starts
+    for (uint8_t i = 0; i < I2C_QUEUE_SIZE; i++) {
+        transactions[i] = (i2c_transaction_t){ .address = DEVICE_I2C_ADDRESS, .read_buffer = &data[i], .read_length = 1 };
+        TEST_ASSERT_EQUAL_INT(i < I2C_QUEUE_SIZE - 1, i2c_submit(&transactions[i]));
+    }
+    uint8_t read[2];
+    TEST_ASSERT_TRUE(i2c_read_buffer(read, sizeof(read)));
+    stop();
+    TEST_ASSERT_TRUE(i2c_wait_transaction(&transactions[I2C_QUEUE_SIZE - 2]));
+    TEST_ASSERT_FALSE(i2c_is_busy());
+}
+
+int main(void) {
+    i2c_init();
+    bus_device = (i2c_device_t){
+        .address = DEVICE_I2C_ADDRESS,
+        .start = device_start,
+        .write = device_write,
+        .read = device_read,
+        .stop = device_stop,
+    };
+    i2c_native_attach(&bus_device);
+    UNITY_BEGIN();
+    RUN_TEST(test_read_registers);
+    RUN_TEST(test_write_steps);
+    RUN_TEST(test_read_bytes);
+    RUN_TEST(test_address_nack);
+    RUN_TEST(test_data_nack);
+    RUN_TEST(test_submit_during_sequence);
+    RUN_TEST(test_continue);
+    RUN_TEST(test_chunks);
+    RUN_TEST(test_bus_error);
+    RUN_TEST(test_interrupts_disabled);
+    RUN_TEST(test_queue_full);
+    return UNITY_END();
+}
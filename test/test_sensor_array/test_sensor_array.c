@@ -0,0 +1,198 @@
+/**
+ * Tests of the multi-sensor BMP180 array, run on the host: pio test -e native
+ * The sensors are simulated BMP180s (native/src/sim_bmp180.c) at their own addresses, two of them also
+ * behind a simulated TCA9548A mux, with constant temperature and pressure and no noise.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <unity.h>
+#include "i2c.h"
+#include "bmp180.h"
+#include "sensor_array.h"
+#include "native.h"
+#include "sim_bmp180.h"
+#include "sim_tca9548a.h"
+
+#define SENSORS 3
+#define FIRST_I2C_ADDRESS 0x74 // Sensors at 0x74-0x76, 0x77 is the BMP180 of the firmware
+#define TEMPERATURE 21.5 // C
+#define PRESSURE 101325 // Pa
+#define MUX_I2C_ADDRESS 0x71
+#define MUX_SENSOR_I2C_ADDRESS 0x73 // Address of the sensors behind the mux
+#define MAX_DISAGREEMENT 100 // Pa
+#define PRESSURE_ERROR 2 // Pa, the simulated UP is the closest to the pressure
+#define PIPELINED_CYCLE_US 20000 // Three sensors in standard mode, one after another would take 36 ms
+#define TIMEOUT_US (SENSOR_ARRAY_MAX_POLLS * SENSOR_ARRAY_POLL_US)
+
+static sim_bmp180_t sims[SENSORS];
+static i2c_device_t devices[SENSORS];
+static bmp180_t* sensors[SENSORS];
+static sensor_array_t array;
+static sim_tca9548a_t mux;
+static i2c_device_t mux_devices[2]; // Mux and its channels
+static bmp180_t* mux_sensors[2];
+
+static void set_pressure(uint8_t index, int32_t pressure) {
+    sims[index].config.press.base = pressure;
+}
+
+void setUp(void) {
+    sim_bmp180_config_t config = sim_bmp180_create_config();
+    config.temp = (sim_bmp180_trajectory_t){ .base = TEMPERATURE };
+    config.press = (sim_bmp180_trajectory_t){ .base = PRESSURE };
+    for (uint8_t i = 0; i < SIM_BMP180_MODES; i++) {
+        config.press_noise[i] = 0;
+    }
+    sensor_array_init(&array, NULL, NULL, MAX_DISAGREEMENT);
+    for (uint8_t i = 0; i < SENSORS; i++) {
+        sim_bmp180_init(&sims[i], &config);
+        TEST_ASSERT_TRUE(bmp180_init(sensors[i]));
+        TEST_ASSERT_TRUE(sensor_array_add(&array, sensors[i], SENSOR_ARRAY_NO_CHANNEL));
+    }
+}
+
+void tearDown(void) {}
+
+static void test_agreement(void) {
+    set_pressure(1, PRESSURE + 20);
+    set_pressure(2, PRESSURE + 40);
+    int32_t temp, press;
+    TEST_ASSERT_TRUE(sensor_array_measure(&array, &temp, &press));
+    TEST_ASSERT_EQUAL_INT32(215, temp);
+    TEST_ASSERT_INT_WITHIN(PRESSURE_ERROR, PRESSURE + 20, press);
+    TEST_ASSERT_INT_WITHIN(PRESSURE_ERROR, 40, array.spread);
+    TEST_ASSERT_INT_WITHIN(PRESSURE_ERROR, -20, array.entries[0].deviation);
+    for (uint8_t i = 0; i < SENSORS; i++) {
+        TEST_ASSERT_TRUE(array.entries[i].is_valid);
+        TEST_ASSERT_FALSE(array.entries[i].is_outlier);
+        TEST_ASSERT_TRUE(sensor_array_is_healthy(&array, i));
+    }
+}
+
+// Conversions overlap: a cycle takes about one temperature and one pressure conversion, not one per sensor
+static void test_pipelined(void) {
+    int32_t temp, press;
+    const uint64_t start_ns = native_get_time_ns();
+    TEST_ASSERT_TRUE(sensor_array_measure(&array, &temp, &press));
+    TEST_ASSERT_TRUE(native_get_time_ns() - start_ns < PIPELINED_CYCLE_US * 1000ULL);
+}
+
+static void test_outlier(void) {
+    set_pressure(1, PRESSURE + 20);
+    set_pressure(2, PRESSURE + 1000);
+    int32_t temp, press;
+    TEST_ASSERT_TRUE(sensor_array_measure(&array, &temp, &press));
+    TEST_ASSERT_INT_WITHIN(PRESSURE_ERROR, PRESSURE + 10, press);
+    TEST_ASSERT_INT_WITHIN(PRESSURE_ERROR, 1000, array.spread);
+    TEST_ASSERT_FALSE(array.entries[0].is_outlier);
+    TEST_ASSERT_FALSE(array.entries[1].is_outlier);
+    TEST_ASSERT_TRUE(array.entries[2].is_outlier);
+    TEST_ASSERT_INT_WITHIN(PRESSURE_ERROR, 980, array.entries[2].deviation);
+    TEST_ASSERT_TRUE(sensor_array_is_healthy(&array, 2)); // Disagreement is not an error
+}
+
+// Two sensors further apart than twice max_disagreement: no sensor agrees with the median
+static void test_no_agreement(void) {
+    sensor_array_init(&array, NULL, NULL, MAX_DISAGREEMENT);
+    sensor_array_add(&array, sensors[0], SENSOR_ARRAY_NO_CHANNEL);
+    sensor_array_add(&array, sensors[1], SENSOR_ARRAY_NO_CHANNEL);
+    set_pressure(1, PRESSURE + 1000);
+    int32_t temp, press;
+    TEST_ASSERT_TRUE(sensor_array_measure(&array, &temp, &press));
+    TEST_ASSERT_EQUAL_INT32(215, temp);
+    TEST_ASSERT_INT_WITHIN(PRESSURE_ERROR, PRESSURE + 500, press);
+    TEST_ASSERT_TRUE(array.entries[0].is_outlier);
+    TEST_ASSERT_TRUE(array.entries[1].is_outlier);
+}
+
+static void test_timeout(void) {
+    sims[2].is_stalled = true;
+    set_pressure(2, PRESSURE + 1000); // Not read
+    int32_t temp, press;
+    for (uint8_t cycle = 1; cycle <= SENSOR_ARRAY_MAX_ERRORS; cycle++) {
+        const uint64_t start_ns = native_get_time_ns();
+        TEST_ASSERT_TRUE(sensor_array_measure(&array, &temp, &press));
+        TEST_ASSERT_TRUE(native_get_time_ns() - start_ns >= TIMEOUT_US * 1000ULL);
+        TEST_ASSERT_INT_WITHIN(PRESSURE_ERROR, PRESSURE, press);
+        TEST_ASSERT_FALSE(array.entries[2].is_valid);
+        TEST_ASSERT_EQUAL_UINT16(cycle, array.entries[2].errors);
+        TEST_ASSERT_EQUAL_UINT8(cycle, array.entries[2].consecutive_errors);
+        TEST_ASSERT_EQUAL_UINT16(0, array.entries[0].errors);
+    }
+    TEST_ASSERT_FALSE(sensor_array_is_healthy(&array, 2));
+    TEST_ASSERT_TRUE(sensor_array_is_healthy(&array, 0));
+
+    // The abandoned conversion is not read, the sensor recovers with the next cycle
+    sims[2].is_stalled = false;
+    TEST_ASSERT_TRUE(sensor_array_measure(&array, &temp, &press));
+    TEST_ASSERT_TRUE(array.entries[2].is_valid);
+    TEST_ASSERT_TRUE(sensor_array_is_healthy(&array, 2));
+    TEST_ASSERT_EQUAL_UINT16(SENSOR_ARRAY_MAX_ERRORS, array.entries[2].errors);
+    TEST_ASSERT_EQUAL_UINT16(SENSOR_ARRAY_MAX_ERRORS + 1, array.entries[2].cycles);
+}
+
+static void test_all_timeout(void) {
+    for (uint8_t i = 0; i < SENSORS; i++) {
+        sims[i].is_stalled = true;
+    }
+    int32_t temp, press;
+    TEST_ASSERT_FALSE(sensor_array_measure(&array, &temp, &press));
+    TEST_ASSERT_EQUAL_INT32(0, array.spread);
+}
+
+// Same sensors on channels 0 and 1 of the mux, selected before every access
+static void test_mux(void) {
+    uint8_t mux_address = MUX_I2C_ADDRESS;
+    sensor_array_init(&array, sensor_array_select_tca9548a, &mux_address, MAX_DISAGREEMENT);
+    for (uint8_t channel = 0; channel < 2; channel++) {
+        TEST_ASSERT_TRUE(sensor_array_select_tca9548a(channel, &mux_address));
+        TEST_ASSERT_TRUE(bmp180_init(mux_sensors[channel]));
+        sensor_array_add(&array, mux_sensors[channel], channel);
+    }
+    set_pressure(1, PRESSURE + 20);
+    int32_t temp, press;
+    TEST_ASSERT_TRUE(sensor_array_measure(&array, &temp, &press));
+    TEST_ASSERT_INT_WITHIN(PRESSURE_ERROR, PRESSURE + 10, press);
+    TEST_ASSERT_INT_WITHIN(PRESSURE_ERROR, 20, array.spread);
+
+    sims[1].is_stalled = true;
+    TEST_ASSERT_TRUE(sensor_array_measure(&array, &temp, &press));
+    TEST_ASSERT_TRUE(array.entries[0].is_valid);
+    TEST_ASSERT_FALSE(array.entries[1].is_valid);
+}
+
+int main(void) {
+    i2c_init();
+    bmp180_t sensor_0 = bmp180_create(FIRST_I2C_ADDRESS);
+    bmp180_t sensor_1 = bmp180_create(FIRST_I2C_ADDRESS + 1);
+    bmp180_t sensor_2 = bmp180_create(FIRST_I2C_ADDRESS + 2);
+    sensors[0] = &sensor_0;
+    sensors[1] = &sensor_1;
+    sensors[2] = &sensor_2;
+    for (uint8_t i = 0; i < SENSORS; i++) {
+        devices[i] = sim_bmp180_create_device(&sims[i], FIRST_I2C_ADDRESS + i);
+        i2c_native_attach(&devices[i]);
+    }
+    bmp180_t mux_sensor_0 = bmp180_create(MUX_SENSOR_I2C_ADDRESS);
+    bmp180_t mux_sensor_1 = bmp180_create(MUX_SENSOR_I2C_ADDRESS);
+    mux_sensors[0] = &mux_sensor_0;
+    mux_sensors[1] = &mux_sensor_1;
+    sim_tca9548a_init(&mux);
+    sim_tca9548a_connect(&mux, 0, &devices[0]);
+    sim_tca9548a_connect(&mux, 1, &devices[1]);
+    mux_devices[0] = sim_tca9548a_create_device(&mux, MUX_I2C_ADDRESS);
+    mux_devices[1] = sim_tca9548a_create_channel_device(&mux, MUX_SENSOR_I2C_ADDRESS);
+    i2c_native_attach(&mux_devices[0]);
+    i2c_native_attach(&mux_devices[1]);
+    UNITY_BEGIN();
+    RUN_TEST(test_agreement);
+    RUN_TEST(test_pipelined);
+    RUN_TEST(test_outlier);
+    RUN_TEST(test_no_agreement);
+    RUN_TEST(test_timeout);
+    RUN_TEST(test_all_timeout);
+    RUN_TEST(test_mux);
+    return UNITY_END();
+}
@@ -0,0 +1,141 @@
+/**
+ * Accuracy of the integer unit conversions against double precision, run on the host: pio test -e native
+ * The bounds are the documented errors of lib/units/units.c.
+ * Author: Pavel Koltyshev
+ * (c) 2024
+*/
+
+#include <stdint.h>
+#include <math.h>
+#include <unity.h>
+#include "units.h"
+
+#define PA_PER_MMHG 133.322387415
+#define PA_PER_INHG 3386.389
+#define ALTITUDE_ERROR_M 0.72 // 510-1140 hPa at standard sea level pressure
+#define ALTITUDE_QNH_ERROR_M 0.43 // Sea level pressure 950-1050 hPa
+#define SEA_LEVEL_ERROR_LOW_PA 3.3 // Station at -500-1000 m
+#define SEA_LEVEL_ERROR_MIDDLE_PA 4.1 // 1000-3000 m
+#define SEA_LEVEL_ERROR_HIGH_PA 5.7 // 3000-5000 m
+#define SEA_LEVEL_MIN 95000 // Pa
+#define SEA_LEVEL_MAX 105000
+#define MMHG_MISMATCHES_PER_MILLE 2.5 // Values off by one from the truncated quotient
+#define INHG_MISMATCHES_PER_MILLE 31
+#define QNH_CREATE_ERROR_M 0.5 // Altitude of the Q15 ratio of units_qnh_create()
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// International barometric formula, altitude in m
+static double reference_altitude(double ratio) {
+    return 44330.0 * (1.0 - pow(ratio, 1.0 / 5.255));
+}
+
+// Pressure ratio (station / sea level) of the altitude in m
+static double reference_ratio(double altitude) {
+    return pow(1.0 - altitude / 44330.0, 5.255);
+}
+
+static double altitude_error(int32_t pressure, int32_t sea_level_pressure) {
+    const double altitude = units_pressure_to_altitude(pressure, sea_level_pressure) / 10.0;
+    return fabs(altitude - reference_altitude((double)pressure / sea_level_pressure));
+}
+
+static void test_altitude_standard(void) {
+    double error = 0;
+    for (int32_t pressure = 51000; pressure <= 114000; pressure++) {
+        error = fmax(error, altitude_error(pressure, UNITS_STANDARD_PRESSURE));
+    }
+    TEST_ASSERT_DOUBLE_WITHIN(ALTITUDE_ERROR_M, 0, error);
+}
+
+static void test_altitude_qnh(void) {
+    double error = 0;
+    for (int32_t sea_level = SEA_LEVEL_MIN; sea_level <= SEA_LEVEL_MAX; sea_level += 500) {
+        for (int32_t pressure = 50000; pressure <= 106000; pressure += 7) {
+            const double ratio = (double)pressure / sea_level;
+            if (ratio >= 0.5 && ratio <= 1.125) {
+                error = fmax(error, altitude_error(pressure, sea_level));
+            }
+        }
+    }
+    TEST_ASSERT_DOUBLE_WITHIN(ALTITUDE_QNH_ERROR_M, 0, error);
+}
+
+static void test_altitude_clamped(void) {
+    TEST_ASSERT_EQUAL_INT32(units_pressure_to_altitude(40000, UNITS_STANDARD_PRESSURE), units_pressure_to_altitude(30000, UNITS_STANDARD_PRESSURE));
+    TEST_ASSERT_EQUAL_INT32(units_pressure_to_altitude(115000, UNITS_STANDARD_PRESSURE), units_pressure_to_altitude(200000, UNITS_STANDARD_PRESSURE));
+    TEST_ASSERT_EQUAL_INT32(units_pressure_to_altitude(40000, UNITS_STANDARD_PRESSURE), units_pressure_to_altitude(0, UNITS_STANDARD_PRESSURE));
+}
+
+static void test_qnh_create(void) {
+    for (int32_t altitude = -1000; altitude <= 5400; altitude++) {
+        const units_qnh_t qnh = units_qnh_create(altitude * 10);
+        const double ratio = qnh.ratio / 32768.0;
+        TEST_ASSERT_DOUBLE_WITHIN(QNH_CREATE_ERROR_M, altitude, reference_altitude(ratio));
+    }
+}
+
+// Sea level pressure of 950-1050 hPa reduced from stations in the altitude range, error in Pa
+static double sea_level_error(int32_t low, int32_t high) {
+    double error = 0;
+    for (int32_t altitude = low; altitude <= high; altitude += 5) {
+        const units_qnh_t qnh = units_qnh_create(altitude * 10);
+        const double ratio = reference_ratio(altitude);
+        for (int32_t pressure = (int32_t)(SEA_LEVEL_MIN * ratio); pressure <= SEA_LEVEL_MAX * ratio; pressure += 3) {
+            error = fmax(error, fabs(units_pressure_to_sea_level(pressure, &qnh) - pressure / ratio));
+        }
+    }
+    return error;
+}
+
+static void test_sea_level(void) {
+    TEST_ASSERT_DOUBLE_WITHIN(SEA_LEVEL_ERROR_LOW_PA, 0, sea_level_error(-500, 1000));
+    TEST_ASSERT_DOUBLE_WITHIN(SEA_LEVEL_ERROR_MIDDLE_PA, 0, sea_level_error(1000, 3000));
+    TEST_ASSERT_DOUBLE_WITHIN(SEA_LEVEL_ERROR_HIGH_PA, 0, sea_level_error(3000, 5000));
+}
+
+static void test_sea_level_at_sea(void) {
+    const units_qnh_t qnh = units_qnh_create(0);
+    for (int32_t pressure = SEA_LEVEL_MIN; pressure <= SEA_LEVEL_MAX; pressure++) {
+        TEST_ASSERT_EQUAL_INT32(pressure, units_pressure_to_sea_level(pressure, &qnh));
+    }
+}
+
+// Truncated quotient, off by one next to a whole mmHg or 0.01 inHg
+static void test_mmhg_inhg(void) {
+    uint32_t values = 0;
+    uint32_t mmhg_mismatches = 0;
+    uint32_t inhg_mismatches = 0;
+    for (int32_t pressure = 30000; pressure <= 120000; pressure++) {
+        const int32_t mmhg = (int32_t)floor(pressure / PA_PER_MMHG);
+        const int32_t inhg = (int32_t)floor(pressure / (PA_PER_INHG / 100));
+        TEST_ASSERT_INT_WITHIN(1, mmhg, units_pressure_to_mmhg(pressure));
+        TEST_ASSERT_INT_WITHIN(1, inhg, units_pressure_to_inhg(pressure));
+        mmhg_mismatches += units_pressure_to_mmhg(pressure) != mmhg;
+        inhg_mismatches += units_pressure_to_inhg(pressure) != inhg;
+        values++;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL((uint32_t)(values * MMHG_MISMATCHES_PER_MILLE / 1000), mmhg_mismatches);
+    TEST_ASSERT_LESS_OR_EQUAL((uint32_t)(values * INHG_MISMATCHES_PER_MILLE / 1000), inhg_mismatches);
+}
+
+static void test_hpa(void) {
+    for (int32_t pressure = 30000; pressure <= 120000; pressure++) {
+        TEST_ASSERT_EQUAL_UINT16((uint16_t)lround(pressure / 10.0), units_pressure_to_hpa(pressure));
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_altitude_standard);
+    RUN_TEST(test_altitude_qnh);
+    RUN_TEST(test_altitude_clamped);
+    RUN_TEST(test_qnh_create);
+    RUN_TEST(test_sea_level);
+    RUN_TEST(test_sea_level_at_sea);
+    RUN_TEST(test_mmhg_inhg);
+    RUN_TEST(test_hpa);
+    return UNITY_END();
+}
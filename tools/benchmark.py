@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""
+Runner of the micro-benchmarks in bench/ and the flash/SRAM footprint of the firmware.
+
+The bench env (stubbed I2C bus, see lib/i2c/i2c_stub.c) is run under simavr, which counts
+the cycles of the real AVR build. Every benchmark sends a line over UART:
+
+    BENCH <name> <iterations> <cycles per operation> <I2C bytes per operation>
+
+The footprint env is the firmware with debug info, its symbols are mapped by avr-nm to the source
+files: lib/<name> is the module <name>, src is the application, symbols without a source file
+(avr-libc, libgcc) are "libc", the rest of the image (vectors, startup code) is "other".
+
+Results are saved as JSON and can be compared with the results of another revision,
+with --threshold the exit status is 1 when cycles, flash or SRAM grow by more percent.
+
+Usage:
+    benchmark.py --output results.json
+    benchmark.py --compare baseline.json --threshold 5
+    benchmark.py --log simavr.log --no-footprint
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+F_CPU = 16000000
+MCU = "atmega328p"
+BENCH_ELF = ".pio/build/bench/firmware.elf"
+FOOTPRINT_ELF = ".pio/build/footprint/firmware.elf"
+TOOLCHAIN = os.path.expanduser("~/.platformio/packages/toolchain-atmelavr/bin")
+SIMAVR_TIMEOUT_S = 60
+
+BENCH_LINE = re.compile(r"BENCH (\S+) (\d+) (\d+) (\d+)")
+ANSI_ESCAPE = re.compile(r"\x1b\[[0-9;]*m")
+NM_LINE = re.compile(r"^[0-9a-fA-F]+ ([0-9a-fA-F]+) (\S) (\S+)(?:\t(.+):\d+)?$")
+FLASH_TYPES = "TtDdWwVv"
+SRAM_TYPES = "DdBb"
+
+
+def root_dir():
+    return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def tool(name):
+    path = os.path.join(TOOLCHAIN, name)
+    return path if os.path.exists(path) else shutil.which(name) or name
+
+
+def build(env):
+    subprocess.run(["pio", "run", "-e", env], cwd=root_dir(), check=True, stdout=subprocess.DEVNULL)
+
+
+def run_simavr(simavr):
+    elf = os.path.join(root_dir(), BENCH_ELF)
+    result = subprocess.run([simavr, "-m", MCU, "-f", str(F_CPU), elf],
+                            capture_output=True, text=True, timeout=SIMAVR_TIMEOUT_S)
+    return result.stdout + result.stderr
+
+
+def parse_benchmarks(log):
+    """Benchmarks from the simavr output (UART lines may have prefixes or colors)."""
+    benchmarks = {}
+    for line in ANSI_ESCAPE.sub("", log).splitlines():
+        match = BENCH_LINE.search(line)
+        if match:
+            name, iterations, cycles, bytes_ = match.groups()
+            benchmarks[name] = {
+                "iterations": int(iterations),
+                "cycles": int(cycles),
+                "bytes": int(bytes_),
+                "us": round(int(cycles) * 1e6 / F_CPU, 2),
+            }
+    if "BENCH END" not in log:
+        print("benchmark: output is incomplete, got %d benchmarks" % len(benchmarks), file=sys.stderr)
+    return benchmarks
+
+
+def module_of(path):
+    if path is None:
+        return "libc"
+    parts = os.path.relpath(path, root_dir()).replace("\\", "/").split("/")
+    if parts[0] == "lib" and len(parts) > 2:
+        return parts[1]
+    if parts[0] == "src":
+        return "src"
+    return "libc"
+
+
+def footprint():
+    elf = os.path.join(root_dir(), FOOTPRINT_ELF)
+    nm = subprocess.run([tool("avr-nm"), "--size-sort", "-S", "-l", "--defined-only", elf],
+                        capture_output=True, text=True, check=True).stdout
+    modules = {}
+    for line in nm.splitlines():
+        match = NM_LINE.match(line)
+        if not match:
+            continue
+        size, type_, _, path = match.groups()
+        module = modules.setdefault(module_of(path), {"flash": 0, "sram": 0})
+        if type_ in FLASH_TYPES:
+            module["flash"] += int(size, 16)
+        if type_ in SRAM_TYPES:
+            module["sram"] += int(size, 16)
+
+    # Berkeley format: text data bss dec hex filename
+    size = subprocess.run([tool("avr-size"), elf], capture_output=True, text=True, check=True).stdout
+    text, data, bss = (int(value) for value in size.splitlines()[1].split()[:3])
+    total = {"flash": text + data, "sram": data + bss}
+    modules["other"] = {
+        "flash": max(total["flash"] - sum(module["flash"] for module in modules.values()), 0),
+        "sram": max(total["sram"] - sum(module["sram"] for module in modules.values()), 0),
+    }
+    return {"total": total, "modules": dict(sorted(modules.items()))}
+
+
+def revision():
+    result = subprocess.run(["git", "describe", "--always", "--dirty"], cwd=root_dir(),
+                            capture_output=True, text=True)
+    return result.stdout.strip() or None
+
+
+def delta(old, new):
+    if old == 0:
+        return 0.0 if new == 0 else float("inf")
+    return (new - old) * 100.0 / old
+
+
+def compare_row(name, key, old, new, threshold):
+    change = delta(old, new)
+    regression = threshold is not None and change > threshold
+    print("%-32s %-6s %10d %10d %+8.1f%%%s" % (name, key, old, new, change, "  !" if regression else ""))
+    return regression
+
+
+def compare(baseline, results, threshold):
+    """Print the changes against the baseline, return true if anything grew above the threshold."""
+    regression = False
+    print("%-32s %-6s %10s %10s %9s" % ("", "", "baseline", "current", "change"))
+    for name, bench in results.get("benchmarks", {}).items():
+        old = baseline.get("benchmarks", {}).get(name)
+        if old is None:
+            print("%-32s new" % name)
+            continue
+        regression |= compare_row(name, "cycles", old["cycles"], bench["cycles"], threshold)
+        if old["bytes"] != bench["bytes"]:
+            compare_row(name, "bytes", old["bytes"], bench["bytes"], None)
+
+    modules = dict(results.get("footprint", {}).get("modules", {}))
+    if "total" in results.get("footprint", {}):
+        modules["total"] = results["footprint"]["total"]
+    old_footprint = baseline.get("footprint", {})
+    old_modules = dict(old_footprint.get("modules", {}), total=old_footprint.get("total"))
+    for name, module in modules.items():
+        old = old_modules.get(name)
+        if old is None:
+            print("%-32s new" % name)
+            continue
+        for key in ("flash", "sram"):
+            if old[key] != module[key] or name == "total":
+                regression |= compare_row(name, key, old[key], module[key], threshold)
+    return regression
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Cycle counts of the hot paths under simavr and flash/SRAM per module")
+    parser.add_argument("--output", help="save results as JSON")
+    parser.add_argument("--compare", metavar="BASELINE", help="JSON results of another revision")
+    parser.add_argument("--threshold", type=float, help="fail if cycles, flash or SRAM grow by more percent")
+    parser.add_argument("--log", help="parse the captured simavr output instead of building and running")
+    parser.add_argument("--simavr", default="simavr", help="simavr executable")
+    parser.add_argument("--no-build", action="store_true", help="use the existing ELF files")
+    parser.add_argument("--no-footprint", action="store_true", help="skip the flash/SRAM footprint")
+    args = parser.parse_args()
+
+    results = {"revision": revision(), "f_cpu": F_CPU}
+    if args.log:
+        with open(args.log, errors="replace") as file:
+            log = file.read()
+    else:
+        if not args.no_build:
+            build("bench")
+        log = run_simavr(args.simavr)
+    results["benchmarks"] = parse_benchmarks(log)
+
+    if not args.no_footprint:
+        if not args.no_build:
+            build("footprint")
+        results["footprint"] = footprint()
+
+    if args.output:
+        with open(args.output, "w") as file:
+            json.dump(results, file, indent=2)
+            file.write("\n")
+    if args.compare:
+        with open(args.compare) as file:
+            baseline = json.load(file)
+        if compare(baseline, results, args.threshold):
+            sys.exit(1)
+    elif not args.output:
+        json.dump(results, sys.stdout, indent=2)
+        print()
+
+
+if __name__ == "__main__":
+    main()
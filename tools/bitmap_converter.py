@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+"""
+Converter of bitmaps and fonts to the SSD1306 page-native format.
+
+The display RAM is organized in pages: one byte is a column of 8 vertical
+pixels (bit 0 = top row). A page-native bitmap stores these bytes page by page,
+so the driver streams them to the display without transposing.
+
+Sources are PBM images (P1 or P4), e.g. exported from GIMP (numeric_font.xcf)
+or converted from a row-major C array of Bitmap Editor with the "import" command.
+
+Usage:
+    bitmap_converter.py import lib/bitmaps/barometer_bitmap.h barometer_bitmap barometer_bitmap.pbm
+    bitmap_converter.py bitmap barometer_bitmap.pbm barometer_bitmap lib/bitmaps/barometer_bitmap.h
+    bitmap_converter.py font numeric_font.pbm numeric_font lib/fonts/numeric_font.h \\
+        --chars " 0123456789+-.%*h<>" --width 8 --letter-spacing 1
+"""
+
+import argparse
+import re
+import sys
+
+BITS_IN_BYTE = 8
+
+
+def read_pbm(path):
+    """Read PBM image. Returns (width, height, rows), rows[y][x] is 1 for a set pixel."""
+    with open(path, "rb") as file:
+        data = file.read()
+
+    pos = 0
+
+    def next_token():
+        nonlocal pos
+        while True:
+            while pos < len(data) and data[pos:pos + 1].isspace():
+                pos += 1
+            if data[pos:pos + 1] == b"#":
+                while pos < len(data) and data[pos:pos + 1] not in (b"\n", b"\r"):
+                    pos += 1
+                continue
+            break
+        start = pos
+        while pos < len(data) and not data[pos:pos + 1].isspace():
+            pos += 1
+        return data[start:pos]
+
+    magic = next_token()
+    width = int(next_token())
+    height = int(next_token())
+    rows = []
+    if magic == b"P1":
+        pixels = [int(ch) for ch in re.sub(rb"\s|#[^\n]*", b"", data[pos:]).decode()]
+        for y in range(height):
+            rows.append(pixels[y * width:(y + 1) * width])
+    elif magic == b"P4":
+        pos += 1  # Single whitespace after the header
+        row_bytes = (width + 7) // 8
+        for y in range(height):
+            row = data[pos + y * row_bytes:pos + (y + 1) * row_bytes]
+            rows.append([(row[x // 8] >> (7 - x % 8)) & 1 for x in range(width)])
+    else:
+        raise ValueError("%s: unsupported PBM format %r" % (path, magic))
+    return width, height, rows
+
+
+def write_pbm(path, width, height, rows):
+    with open(path, "w") as file:
+        file.write("P1\n%d %d\n" % (width, height))
+        for row in rows:
+            file.write(" ".join(str(pixel) for pixel in row) + "\n")
+
+
+def read_row_major_header(path, name):
+    """Read row-major bitmap (Bitmap Editor format, bit 0 = left pixel) from C header."""
+    with open(path) as file:
+        text = file.read()
+    upper = name.upper()
+    width = int(re.search(r"#define\s+%s_WIDTH\s+(\d+)" % upper, text).group(1))
+    height = int(re.search(r"#define\s+%s_HEIGHT\s+(\d+)" % upper, text).group(1))
+    body = re.search(r"\b%s\s*\[\s*\]\s*=\s*\{([^}]*)\}" % name, text).group(1)
+    data = [int(value, 0) for value in body.replace(",", " ").split()]
+    row_bytes = (width + 7) // 8
+    rows = []
+    for y in range(height):
+        rows.append([(data[y * row_bytes + x // 8] >> (x % 8)) & 1 for x in range(width)])
+    return width, height, rows
+
+
+def to_pages(rows, x, width, height):
+    """Convert the area of the image to page-native bytes."""
+    pages = (height + BITS_IN_BYTE - 1) // BITS_IN_BYTE
+    result = []
+    for page in range(pages):
+        for column in range(x, x + width):
+            value = 0
+            for bit in range(BITS_IN_BYTE):
+                y = page * BITS_IN_BYTE + bit
+                if y < height and rows[y][column]:
+                    value |= 1 << bit
+            result.append(value)
+    return result
+
+
+def format_bytes(data):
+    return ", ".join("0x%x" % value for value in data)
+
+
+def header_guard(name):
+    return name.upper() + "_H"
+
+
+def write_bitmap_header(path, name, width, height, rows):
+    upper = name.upper()
+    data = to_pages(rows, 0, width, height)
+    with open(path, "w") as file:
+        file.write("#ifndef %s\n#define %s\n" % (header_guard(name), header_guard(name)))
+        file.write("#include <stdint.h>\n#include <avr/pgmspace.h>\n\n")
+        file.write("// Generated by tools/bitmap_converter.py (page-native format)\n")
+        file.write("#define %s_WIDTH %d\n#define %s_HEIGHT %d\n\n" % (upper, width, upper, height))
+        file.write("const uint8_t PROGMEM %s[] = { %s };\n\n" % (name, format_bytes(data)))
+        file.write("#endif // %s" % header_guard(name))
+
+
+def write_font_header(path, name, chars, width, height, letter_spacing, rows):
+    glyphs = {}
+    for i, char in enumerate(chars):
+        glyphs[ord(char)] = to_pages(rows, i * width, width, height)
+    first_char = min(glyphs)
+    last_char = max(glyphs)
+
+    with open(path, "w") as file:
+        file.write("#ifndef %s\n#define %s\n\n" % (header_guard(name), header_guard(name)))
+        file.write("#include <avr/pgmspace.h>\n#include <stdint.h>\n#include \"ssd1306_def.h\"\n\n")
+        file.write("// Generated by tools/bitmap_converter.py (page-native format)\n")
+        file.write("static const uint8_t PROGMEM %s_bitmaps[] = {\n" % name)
+        offsets = []
+        offset = 0
+        for code in range(first_char, last_char + 1):
+            if code in glyphs:
+                offsets.append("%d" % offset)
+                file.write("    %s, // '%s'\n" % (format_bytes(glyphs[code]), chr(code)))
+                offset += len(glyphs[code])
+            else:
+                offsets.append("SSD1306_GLYPH_MISSING")
+        file.write("};\n\n")
+        file.write("// Offset of the glyph in %s_bitmaps for every char from 0x%02x to 0x%02x\n" % (name, first_char, last_char))
+        file.write("static const uint16_t PROGMEM %s_offsets[] = {\n" % name)
+        for i in range(0, len(offsets), 8):
+            file.write("    %s,\n" % ", ".join(offsets[i:i + 8]))
+        file.write("};\n\n")
+        file.write("const ssd1306_font_t %s = {\n" % name)
+        file.write("    .width = %d,\n" % width)
+        file.write("    .height = %d,\n" % height)
+        file.write("    .letter_spacing = %d,\n" % letter_spacing)
+        file.write("    .format = SSD1306_BITMAP_PAGED,\n")
+        file.write("    .first_char = 0x%02x,\n" % first_char)
+        file.write("    .last_char = 0x%02x,\n" % last_char)
+        file.write("    .offsets = %s_offsets,\n" % name)
+        file.write("    .bitmaps = %s_bitmaps\n" % name)
+        file.write("};\n\n")
+        file.write("#endif // %s" % header_guard(name))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert bitmaps and fonts to the SSD1306 page-native format")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    command = commands.add_parser("import", help="row-major C array (Bitmap Editor) to PBM")
+    command.add_argument("header")
+    command.add_argument("name")
+    command.add_argument("output")
+
+    command = commands.add_parser("bitmap", help="PBM to page-native bitmap header")
+    command.add_argument("input")
+    command.add_argument("name")
+    command.add_argument("output")
+
+    command = commands.add_parser("font", help="PBM strip of glyphs to page-native font header")
+    command.add_argument("input")
+    command.add_argument("name")
+    command.add_argument("output")
+    command.add_argument("--chars", required=True, help="characters of the glyphs from left to right")
+    command.add_argument("--width", type=int, required=True, help="glyph width")
+    command.add_argument("--letter-spacing", type=int, default=1)
+
+    args = parser.parse_args()
+
+    if args.command == "import":
+        width, height, rows = read_row_major_header(args.header, args.name)
+        write_pbm(args.output, width, height, rows)
+    elif args.command == "bitmap":
+        width, height, rows = read_pbm(args.input)
+        write_bitmap_header(args.output, args.name, width, height, rows)
+    elif args.command == "font":
+        width, height, rows = read_pbm(args.input)
+        if width != args.width * len(args.chars):
+            sys.exit("%s: expected width %d for %d glyphs" % (args.input, args.width * len(args.chars), len(args.chars)))
+        write_font_header(args.output, args.name, args.chars, args.width, height, args.letter_spacing, rows)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
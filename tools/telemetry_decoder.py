@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+Decoder of the binary telemetry frames of lib/telemetry.
+
+Frames are COBS-encoded and terminated by a zero byte. The payload is little-endian:
+
+    type u8, sequence u16, status u8, time u32, UT u16, UP u32, temperature i16 (0.1 C),
+    pressure i32 (Pa), current u16 (uA), CRC-16/CCITT-FALSE u16
+
+The input is a serial port or pseudo-terminal (set to raw mode at the given baud rate)
+or a file with captured bytes. Frames with a bad CRC are reported and skipped,
+gaps of the sequence number are reported as lost frames. Zero-terminated text lines between
+the frames (e.g. the I2C profile of a build with -D I2C_PROFILE) are passed through.
+
+Usage:
+    telemetry_decoder.py /dev/ttyUSB0
+    telemetry_decoder.py capture.bin --json
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import termios
+import tty
+
+FRAME_MEASUREMENT = 1
+PAYLOAD = struct.Struct("<BHBIHIhiH")
+CRC = struct.Struct("<H")
+
+STATUS_VALID = 0
+STATUS_BOOT = 1
+STATUS_TENDENCY = 2
+
+BAUD_RATES = {
+    9600: termios.B9600,
+    19200: termios.B19200,
+    38400: termios.B38400,
+    57600: termios.B57600,
+    115200: termios.B115200,
+}
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, same as _crc_xmodem_update() from 0xFFFF."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    output = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("bad COBS code")
+        output += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            output.append(0)
+    return bytes(output)
+
+
+def is_text(frame):
+    """Binary frames always contain a COBS code or type byte below 0x20."""
+    return all(0x20 <= byte < 0x7F or byte in b"\r\n" for byte in frame)
+
+
+def decode_frame(frame):
+    payload = cobs_decode(frame)
+    if len(payload) != PAYLOAD.size + CRC.size:
+        raise ValueError("bad length %d" % len(payload))
+    (crc,) = CRC.unpack_from(payload, PAYLOAD.size)
+    if crc != crc16(payload[:PAYLOAD.size]):
+        raise ValueError("bad CRC")
+    kind, sequence, status, time, ut, up, temp, press, current = PAYLOAD.unpack_from(payload)
+    if kind != FRAME_MEASUREMENT:
+        raise ValueError("unknown frame type %d" % kind)
+    return {
+        "sequence": sequence,
+        "valid": bool(status & (1 << STATUS_VALID)),
+        "boot": bool(status & (1 << STATUS_BOOT)),
+        "tendency": bool(status & (1 << STATUS_TENDENCY)),
+        "time": time,
+        "ut": ut,
+        "up": up,
+        "temperature": temp / 10,
+        "pressure": press,
+        "current_ua": current,
+    }
+
+
+def open_input(path, baud_rate):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        tty.setraw(fd)
+        attributes = termios.tcgetattr(fd)
+        attributes[4] = attributes[5] = BAUD_RATES[baud_rate]
+        termios.tcsetattr(fd, termios.TCSANOW, attributes)
+    return fd
+
+
+def read_frames(fd):
+    buffer = bytearray()
+    while True:
+        data = os.read(fd, 256)
+        if not data:
+            return
+        buffer += data
+        while 0 in buffer:
+            end = buffer.index(0)
+            frame = bytes(buffer[:end])
+            del buffer[:end + 1]
+            if frame:
+                yield frame
+
+
+def format_sample(sample):
+    flags = "".join(flag for flag, key in (("V", "valid"), ("B", "boot"), ("T", "tendency")) if sample[key])
+    return "#%-5d %-3s t=%-8d %+6.1f C %7d Pa  UT=%-5d UP=%-6d %5d uA" % (
+        sample["sequence"], flags, sample["time"], sample["temperature"], sample["pressure"],
+        sample["ut"], sample["up"], sample["current_ua"])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode binary telemetry frames of the meteo station")
+    parser.add_argument("input", help="serial port, pseudo-terminal or file with captured bytes")
+    parser.add_argument("--baud", type=int, default=115200, choices=sorted(BAUD_RATES))
+    parser.add_argument("--json", action="store_true", help="print one JSON object per frame")
+    args = parser.parse_args()
+
+    fd = open_input(args.input, args.baud)
+    sequence = None
+    errors = 0
+    lost = 0
+    try:
+        for frame in read_frames(fd):
+            if is_text(frame):
+                text = frame.decode("ascii").rstrip()
+                print(json.dumps({"text": text}) if args.json else text, flush=True)
+                continue
+            try:
+                sample = decode_frame(frame)
+            except ValueError as error:
+                errors += 1
+                print("bad frame: %s" % error, file=sys.stderr)
+                continue
+            if sequence is not None and not sample["boot"]:
+                gap = (sample["sequence"] - sequence - 1) & 0xFFFF
+                if gap:
+                    lost += gap
+                    print("lost %d frames" % gap, file=sys.stderr)
+            sequence = sample["sequence"]
+            print(json.dumps(sample) if args.json else format_sample(sample), flush=True)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        os.close(fd)
+    print("bad frames: %d, lost frames: %d" % (errors, lost), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""
+Generator of the altitude table of lib/units.
+
+Altitude is interpolated from a table indexed by the pressure ratio p / p0
+in Q15 fixed point (international barometric formula):
+
+    h = 44330 * (1 - (p / p0) ^ (1 / 5.255))
+
+The accuracy of the integer conversions against the double-precision formulas
+is checked by test/test_units (pio test -e native).
+
+Usage:
+    units_table.py table lib/units/altitude_table.h
+"""
+
+import argparse
+
+RATIO_SHIFT = 15  # Q15 pressure ratio
+RATIO_MIN = 16384  # 0.5, about 5478 m
+RATIO_MAX = 36864  # 1.125, about -1005 m
+STEP_SHIFT = 8  # Table step is 1/128 of the ratio
+STEP = 1 << STEP_SHIFT
+SIZE = (RATIO_MAX - RATIO_MIN) // STEP + 1
+
+
+def altitude(ratio):
+    """Altitude in m for the pressure ratio p / p0."""
+    return 44330.0 * (1.0 - ratio ** (1.0 / 5.255))
+
+
+def build_table():
+    """Altitude in 0.1 m for every table step."""
+    return [round(altitude((RATIO_MIN + i * STEP) / (1 << RATIO_SHIFT)) * 10) for i in range(SIZE)]
+
+
+def write_table(path):
+    table = build_table()
+    with open(path, "w") as file:
+        file.write("#ifndef ALTITUDE_TABLE_H\n#define ALTITUDE_TABLE_H\n\n")
+        file.write("#include <stdint.h>\n#include <avr/pgmspace.h>\n\n")
+        file.write("// Generated by tools/units_table.py\n")
+        file.write("#define ALTITUDE_TABLE_RATIO_MIN %d // Q15 pressure ratio of the first entry\n" % RATIO_MIN)
+        file.write("#define ALTITUDE_TABLE_RATIO_MAX %d // Q15 pressure ratio of the last entry\n" % RATIO_MAX)
+        file.write("#define ALTITUDE_TABLE_STEP_SHIFT %d\n" % STEP_SHIFT)
+        file.write("#define ALTITUDE_TABLE_SIZE %d\n\n" % SIZE)
+        file.write("// Altitude in 0.1 m for every step of the pressure ratio\n")
+        file.write("static const int32_t PROGMEM altitude_table[] = {\n")
+        for i in range(0, SIZE, 8):
+            file.write("    %s,\n" % ", ".join(str(value) for value in table[i:i + 8]))
+        file.write("};\n\n")
+        file.write("#endif // ALTITUDE_TABLE_H")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Altitude table of lib/units")
+    commands = parser.add_subparsers(dest="command", required=True)
+    command = commands.add_parser("table", help="write altitude table header")
+    command.add_argument("output")
+    args = parser.parse_args()
+
+    if args.command == "table":
+        write_table(args.output)
+
+
+if __name__ == "__main__":
+    main()